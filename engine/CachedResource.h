@@ -0,0 +1,21 @@
+#pragma once
+#include <stdint.h>
+
+//Something ResourceLoader hands out of its ResourceCache. Every get*() that returns one counts as
+// a use, and whoever holds on to it calls release() once done with it. The cache only ever frees
+// resources nobody's using, and only once it's over its memory budget. Main thread only.
+class CachedResource
+{
+	unsigned int m_uses;
+
+public:
+	CachedResource()	{m_uses = 0;};
+	virtual ~CachedResource() {};
+
+	void addUse()			{m_uses++;};
+	void release()			{if(m_uses) m_uses--;};
+	unsigned int getUses()	{return m_uses;};
+
+	//Bytes of graphics memory held by this resource
+	virtual uint64_t getMemoryUsage() = 0;
+};
@@ -12,7 +12,4 @@ public:
 	Image* img;
 	bool active;
 	Color col;
-	
-	virtual void draw(bool bDebugInfo = false) = 0;	//TODO This shouldn't have a debug thing?
-
 };
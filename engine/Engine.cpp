@@ -75,6 +75,7 @@ Engine::Engine(uint16_t iWidth, uint16_t iHeight, string sTitle, string sAppName
 	LOG(INFO) << "Creating resource loader";
 	m_resourceLoader = new ResourceLoader(m_physicsWorld, "res/pak");	//TODO: pass in pak folder from somewhere else
 	m_entityManager = new EntityManager(m_resourceLoader, m_physicsWorld);
+	memset(&m_frameGLStats, 0, sizeof(m_frameGLStats));
 
 	LOG(INFO) << "Initializing FMOD...";
 	m_bSoundDied = true;
@@ -216,6 +217,7 @@ bool Engine::_frame()
 #ifdef _DEBUG
 		}
 #endif
+		m_resourceLoader->update(RESOURCE_UPLOAD_BUDGET);
 		_render();
 	}
 
@@ -257,7 +259,12 @@ void Engine::_render()
 	drawCursor();
 	
 	//End rendering and update the screen
-	SDL_GL_SwapWindow(m_Window);
+	if(!OpenGLAPI::IsNull())
+		SDL_GL_SwapWindow(m_Window);
+
+	//Everything from one swap to the next counts as this frame
+	m_frameGLStats = OpenGLAPI::GetStats();
+	OpenGLAPI::ResetCallCount();
 }
 
 void Engine::drawDebug()
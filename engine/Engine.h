@@ -11,6 +11,7 @@
 #include "EngineContactListener.h"
 #include "Node.h"
 #include "DebugDraw.h"
+#include "opengl-api.h"
 
 class b2World;
 class Image;
@@ -19,6 +20,7 @@ class EntityManager;
 
 #define VELOCITY_ITERATIONS 8
 #define PHYSICS_ITERATIONS 3
+#define RESOURCE_UPLOAD_BUDGET	2.0f	//Milliseconds per frame to spend finishing off background resource loads
 
 //SDL codes that should be defined but aren't
 #define SDL_BUTTON_FORWARD	SDL_BUTTON_X2
@@ -76,6 +78,8 @@ private:
 #endif
 	ResourceLoader* m_resourceLoader;
 	EntityManager* m_entityManager;
+	GLStats m_frameGLStats;	//OpenGL usage over the last full frame
+	glm::mat4 m_projection;	//Camera projection, as set up in setup_opengl()
 	
 	
 	//multimap<string, FMOD_CHANNEL*> m_channels;
@@ -115,6 +119,7 @@ public:
 	Rect getCameraView(Vec3 Camera);		//Return the rectangle, in world position z=0, that the camera can see
 	Vec2 worldPosFromCursor(Vec2 cursorpos, Vec3 Camera);	//Get the worldspace position of the given mouse cursor position
 	Vec2 worldMovement(Vec2 cursormove, Vec3 Camera);		//Get the worldspace transform of the given mouse transformation
+	const glm::mat4& getProjection()	{return m_projection;};
 	
 	//Drawing functions
 	Rect getScreenRect()	{Rect rc(0,0,getWidth(),getHeight()); return rc;};
@@ -203,6 +208,7 @@ public:
 	void setMSAA(int iMSAA);
 	void setGamma(float fGamma)	{m_fGamma = fGamma;};
 	float getGamma()				{return m_fGamma;};
+	const GLStats& getFrameGLStats()	{return m_frameGLStats;};	//Draw calls and such, last frame
 	
 	//---------------------------------------------------------
 	// Entity manager
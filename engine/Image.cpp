@@ -17,17 +17,52 @@
 #include "ResourceTypes.h"
 using namespace std;
 
-Image::Image(unsigned char* blob, unsigned int size)
+Image::Image(const unsigned char* blob, unsigned int size)
 {
+	m_hTex = 0;
+	m_iWidth = m_iHeight = 0;
+	m_iMemUsage = 0;
+	m_atlas = NULL;
+	m_rcTex.set(0, 0, 1, 1);
 	m_sFilename = "";	//Can't reload? Is this a problem?
 	_loadBlob(blob, size);
 }
 
+Image::Image(const unsigned char* pixels, unsigned int width, unsigned int height, int mode)
+{
+	m_hTex = 0;
+	m_iMemUsage = 0;
+	m_atlas = NULL;
+	m_rcTex.set(0, 0, 1, 1);
+	m_sFilename = "";
+	_bind(pixels, width, height, mode);
+}
+
+Image::Image(Image* atlas, unsigned int x, unsigned int y, unsigned int width, unsigned int height)
+{
+	m_atlas = atlas;
+	m_hTex = atlas->_getTex();
+	m_iWidth = width;
+	m_iHeight = height;
+	m_iMemUsage = 0;	//The page counts it
+	m_sFilename = "";
+
+	float pageWidth = (float)atlas->getWidth();
+	float pageHeight = (float)atlas->getHeight();
+	if(pageWidth && pageHeight)
+		m_rcTex.set(x / pageWidth, y / pageHeight, (x + width) / pageWidth, (y + height) / pageHeight);
+	else
+		m_rcTex.set(0, 0, 1, 1);
+}
+
 Image::Image(string sFilename)
 {
 	//m_bReloadEachTime = false;
 	m_hTex = 0;
 	m_iWidth = m_iHeight = 0;
+	m_iMemUsage = 0;
+	m_atlas = NULL;
+	m_rcTex.set(0, 0, 1, 1);
 	m_sFilename = sFilename;
 	_load(sFilename);
 }
@@ -37,14 +72,17 @@ Image::~Image()
 	//image cleanup
 	if(m_sFilename.length())
 		LOG(INFO) << "Free " << m_sFilename;
-	if(m_hTex)
+	if(m_atlas)
+		m_atlas->release();	//The page's texture isn't ours to free
+	else if(m_hTex)
 		glDeleteTextures(1, &m_hTex);	//Free OpenGL graphics memory
 }
 
-void Image::_bind(unsigned char* data, unsigned int width, unsigned int height, int mode)
+void Image::_bind(const unsigned char* data, unsigned int width, unsigned int height, int mode)
 {
 	m_iWidth = width;
 	m_iHeight = height;
+	m_iMemUsage = (uint64_t)width * height * ((mode == GL_RGB) ? 3 : 4);
 
 	//generate an OpenGL texture ID for this texture
 	glGenTextures(1, &m_hTex);
@@ -58,7 +96,7 @@ void Image::_bind(unsigned char* data, unsigned int width, unsigned int height,
 }
 
 //TODO: This should be split into a resource loader
-void Image::_loadBlob(unsigned char* blob, unsigned int size)
+void Image::_loadBlob(const unsigned char* blob, unsigned int size)
 {
 	if(size < sizeof(TextureHeader))
 	{
@@ -247,10 +285,10 @@ void Image::render(Vec2 size, float tilex, float tiley)
     };
     const float texCoords[] =
     {
-		0.0f, 0.0f, // lower left
-		tilex, 0.0f, // lower right
-		tilex, tiley, // upper right
-        0.0f, tiley, // upper left
+		texU(0.0f), texV(0.0f), // lower left
+		texU(tilex), texV(0.0f), // lower right
+		texU(tilex), texV(tiley), // upper right
+        texU(0.0f), texV(tiley), // upper left
     };
     glVertexPointer(2, GL_FLOAT, 0, &vertexData);
     glTexCoordPointer(2, GL_FLOAT, 0, &texCoords);
@@ -262,17 +300,19 @@ void Image::renderLattice(Lattice* l, Vec2 size)
 	glPushMatrix();
 	
 	glScalef(size.x, size.y, 1);
+	pushTexRect();
 	l->renderTex(m_hTex);
+	popTexRect();
 	
 	glPopMatrix();
 }
 
 void Image::render(Vec2 size, Rect rcImg)
 {
-	rcImg.left = rcImg.left / (float)m_iWidth;
-	rcImg.right = rcImg.right / (float)m_iWidth;
-	rcImg.top = 1.0f - rcImg.top / (float)m_iHeight;
-	rcImg.bottom = 1.0f - rcImg.bottom / (float)m_iHeight;
+	rcImg.left = texU(rcImg.left / (float)m_iWidth);
+	rcImg.right = texU(rcImg.right / (float)m_iWidth);
+	rcImg.top = texV(1.0f - rcImg.top / (float)m_iHeight);
+	rcImg.bottom = texV(1.0f - rcImg.bottom / (float)m_iHeight);
 	
 	const float vertexData[] =
 	{
@@ -299,6 +339,26 @@ void Image::bindTexture()
 	glBindTexture(GL_TEXTURE_2D, m_hTex);
 }
 
+void Image::pushTexRect()
+{
+	if(!m_atlas)
+		return;
+	glMatrixMode(GL_TEXTURE);
+	glPushMatrix();
+	glTranslatef(m_rcTex.left, m_rcTex.top, 0);
+	glScalef(m_rcTex.right - m_rcTex.left, m_rcTex.bottom - m_rcTex.top, 1);
+	glMatrixMode(GL_MODELVIEW);
+}
+
+void Image::popTexRect()
+{
+	if(!m_atlas)
+		return;
+	glMatrixMode(GL_TEXTURE);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+}
+
 void Image::render4V(Vec2 ul, Vec2 ur, Vec2 bl, Vec2 br)
 {
 	float maxx, maxy;
@@ -320,10 +380,10 @@ void Image::render4V(Vec2 ul, Vec2 ur, Vec2 bl, Vec2 br)
     };
     const float texCoords[] =
     {
-        0.0, maxy, // upper left
-        maxx, maxy, // upper right
-        0.0, 0.0, // lower left
-        maxx, 0.0, // lower right
+        texU(0.0f), texV(maxy), // upper left
+        texU(maxx), texV(maxy), // upper right
+        texU(0.0f), texV(0.0f), // lower left
+        texU(maxx), texV(0.0f), // lower right
     };
     glVertexPointer(2, GL_FLOAT, 0, &vertexData);
     glTexCoordPointer(2, GL_FLOAT, 0, &texCoords);
@@ -339,7 +399,7 @@ void Image::_load(string sFilename)
 void Image::_reload()
 {
 	//TODO: Support reloading images loaded from buffers
-	if(m_sFilename.length())
+	if(m_sFilename.length() && !m_atlas)
 		_load(m_sFilename);
 }
 
@@ -6,8 +6,9 @@
 
 #include "lattice.h"
 #include "SDL_opengl.h"
+#include "CachedResource.h"
 
-class Image
+class Image : public CachedResource
 {
 private:
 	Image(){};  //Default constructor is uncallable
@@ -15,6 +16,9 @@ private:
 	GLuint    	m_hTex;
 	std::string     	m_sFilename;
 	int 		m_iWidth, m_iHeight;			// width and height of original image
+	uint64_t	m_iMemUsage;					// bytes of texture memory
+	Image*		m_atlas;						// page this image was packed into, if any; we hold a use of it
+	Rect		m_rcTex;						// texture coordinates the image covers, 0..1 across the texture
 	
 #ifdef BIG_ENDIAN
 	uint32_t m_iRealWidth, m_iRealHeight;
@@ -22,8 +26,8 @@ private:
 
 	void _load(std::string sFilename);
 	void _loadPNG(std::string sFilename);
-	void _loadBlob(unsigned char* blob, unsigned int size);
-	void _bind(unsigned char* data, unsigned int width, unsigned int height, int mode);
+	void _loadBlob(const unsigned char* blob, unsigned int size);
+	void _bind(const unsigned char* data, unsigned int width, unsigned int height, int mode);
 	//void _loadNoise(string sXMLFilename);
 
 public:
@@ -31,7 +35,9 @@ public:
 	
 	//Constructor/destructor
 	Image(std::string sFilename);
-	Image(unsigned char* blob, unsigned int size);
+	Image(const unsigned char* blob, unsigned int size);
+	Image(const unsigned char* pixels, unsigned int width, unsigned int height, int mode);	//Raw pixels; mode is GL_RGB or GL_RGBA
+	Image(Image* atlas, unsigned int x, unsigned int y, unsigned int width, unsigned int height);	//Part of an atlas page; takes over a use of it
 	//Image(uint32_t width, uint32_t height, float sizex = 1.0f, float sizey = 1.0f, float xoffset = 0.0f, float yoffset = 0.0f);	//Create image from random noise
 	~Image();
     
@@ -42,14 +48,27 @@ public:
 	//Accessor methods
 	uint32_t getWidth()     {return m_iWidth;};
 	uint32_t getHeight()    {return m_iHeight;};
+	uint64_t getMemoryUsage()	{return m_iMemUsage;};
 	const std::string& getFilename()    {return m_sFilename;};
+	bool isAtlased()	{return m_atlas != NULL;};
+
+	//Map texture coordinates across this image (0..1) to coordinates in its texture, for drawing
+	// it by hand. Same thing unless it's atlased.
+	float texU(float u)	{return m_rcTex.left + u * (m_rcTex.right - m_rcTex.left);};
+	float texV(float v)	{return m_rcTex.top + v * (m_rcTex.bottom - m_rcTex.top);};
 	
-	//Drawing methods for texel-based coordinates
+	//Drawing methods for texel-based coordinates. Atlased images can't tile, since the texture
+	// around them belongs to other images
 	void render(Vec2 size, float tilex = 1.0f, float tiley = 1.0f);				//Render at 0,0 with specified texel size
 	void renderLattice(Lattice* l, Vec2 size);	//Render at 0,0 with specified lattice
 	void render(Vec2 size, Rect rcImg);			//NOTE: Doesn't bind texture!
 	void render4V(Vec2 ul, Vec2 ur, Vec2 bl, Vec2 br);
 
 	void bindTexture();	//Bind texture to OpenGL (so we don't have to bind each draw call)
+
+	//For geometry with its own texture coordinates (meshes, lattices): scales them into this image's
+	// part of the texture with the texture matrix. Does nothing unless it's atlased
+	void pushTexRect();
+	void popTexRect();
 };
 
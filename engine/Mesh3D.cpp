@@ -3,11 +3,11 @@
  Copyright (c) 2013 Mark Hutcheson
 */
 #include "Mesh3D.h"
-#include "tiny3d.h"
 #include <sstream>
 #include <set>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <vector>
 #include <fstream>
 #include "Image.h"
@@ -15,13 +15,13 @@
 #include "easylogging++.h"
 #include "FileOperations.h"
 using namespace std;
-using namespace tiny3d;
 
 Mesh3D::Mesh3D(string sOBJFile)
 {
 	useGlobalLight = true;
 	
-    m_obj = 0;
+	m_vertexBuffer = m_indexBuffer = m_numIndices = 0;
+	m_iMemUsage = 0;
 	//Load with OBJ loader or Tiny3D loader, depending on file type (Tiny3D should be _far_ faster)
 	if(sOBJFile.find(".obj", sOBJFile.size()-4) != string::npos)
 		_fromOBJFile(sOBJFile);
@@ -34,7 +34,9 @@ Mesh3D::Mesh3D(string sOBJFile)
 
 Mesh3D::Mesh3D(const unsigned char* data, unsigned int len)
 {
-	m_obj = 0;
+	useGlobalLight = true;
+	m_vertexBuffer = m_indexBuffer = m_numIndices = 0;
+	m_iMemUsage = 0;
 	wireframe = false;
 	shaded = true;
 
@@ -42,10 +44,39 @@ Mesh3D::Mesh3D(const unsigned char* data, unsigned int len)
 }
 
 Mesh3D::~Mesh3D()
+{
+	_free();
+}
+
+void Mesh3D::_free()
 {
 	//Free OpenGL graphics memory
-	if(m_obj)
-		glDeleteLists(m_obj, 1);
+	if(m_vertexBuffer)
+		glDeleteBuffers(1, &m_vertexBuffer);
+	if(m_indexBuffer)
+		glDeleteBuffers(1, &m_indexBuffer);
+	m_vertexBuffer = m_indexBuffer = m_numIndices = 0;
+	m_iMemUsage = 0;
+}
+
+void Mesh3D::_upload(const MeshData& mesh)
+{
+	_free();
+	if(mesh.indices.empty())
+		return;
+
+	glGenBuffers(1, &m_vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(MeshVertex), &mesh.vertices[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glGenBuffers(1, &m_indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(uint32_t), &mesh.indices[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	m_numIndices = mesh.indices.size();
+	m_iMemUsage = (uint64_t)mesh.vertices.size() * sizeof(MeshVertex) + (uint64_t)mesh.indices.size() * sizeof(uint32_t);
 }
 
 void Mesh3D::_fromOBJFile(string sFilename)
@@ -162,33 +193,27 @@ void Mesh3D::_fromOBJFile(string sFilename)
     }
     infile.close();
 
-    //Done with file; create object
-    m_obj = glGenLists(1);
-    glNewList(m_obj,GL_COMPILE);
-	
-    //Loop through and add faces
-    glBegin(GL_TRIANGLES);
+    //Done with file; OBJ positions and normals count from 1, UVs from our 0,0 one
+    vector<uint32_t> corners;
+    corners.reserve(lFaces.size() * 9);
     for(list<Face>::iterator i = lFaces.begin(); i != lFaces.end(); i++)
     {
-        if(bNorms)
-            glNormal3f(vNormals[i->norm1-1].x, vNormals[i->norm1-1].y, vNormals[i->norm1-1].z);
-        if(bUVs)
-            glTexCoord2f(vUVs[i->uv1].u, vUVs[i->uv1].v);
-        glVertex3f(vVerts[i->v1-1].x, vVerts[i->v1-1].y, vVerts[i->v1-1].z);
-        if(bNorms)
-            glNormal3f(vNormals[i->norm2-1].x, vNormals[i->norm2-1].y, vNormals[i->norm2-1].z);
-        if(bUVs)
-            glTexCoord2f(vUVs[i->uv2].u, vUVs[i->uv2].v);
-        glVertex3f(vVerts[i->v2-1].x, vVerts[i->v2-1].y, vVerts[i->v2-1].z);
-        if(bNorms)
-            glNormal3f(vNormals[i->norm3-1].x, vNormals[i->norm3-1].y, vNormals[i->norm3-1].z);
-        if(bUVs)
-            glTexCoord2f(vUVs[i->uv3].u, vUVs[i->uv3].v);
-        glVertex3f(vVerts[i->v3-1].x, vVerts[i->v3-1].y, vVerts[i->v3-1].z);
+        const uint32_t faceCorners[9] =
+        {
+            i->v1 - 1, i->uv1, bNorms ? i->norm1 - 1 : MESH_NO_NORMAL,
+            i->v2 - 1, i->uv2, bNorms ? i->norm2 - 1 : MESH_NO_NORMAL,
+            i->v3 - 1, i->uv3, bNorms ? i->norm3 - 1 : MESH_NO_NORMAL,
+        };
+        corners.insert(corners.end(), faceCorners, faceCorners + 9);
     }
 
-    glEnd();
-    glEndList();
+    MeshData mesh;
+    if(vVerts.empty() || !MeshBuilder::build(&vVerts[0].x, vVerts.size(), &vUVs[0].u, vUVs.size(), vNormals.size() ? &vNormals[0].x : NULL, vNormals.size(), corners, &mesh))
+    {
+        LOG(ERROR) << "Error: Wavefront object file " << sFilename << " has faces with bad indices";
+        return;
+    }
+    _upload(mesh);
 }
 
 //Fall back on pure C functions for speed
@@ -208,75 +233,18 @@ void Mesh3D::_fromTiny3DFile(string sFilename)
 
 void Mesh3D::_fromData(const unsigned char* data, unsigned int len)
 {
-	//Make sure this is large enough to hold a header
-	if(len < sizeof(tiny3dHeader)) return;
-
-	tiny3dHeader*  header = (tiny3dHeader*) data;
-
-	//Make sure this is large enough to hold all the data
-	if(len < sizeof(tiny3dHeader) +
-		sizeof(normal) * header->numNormals +
-		sizeof(uv) * header->numUVs +
-		sizeof(vert) * header->numVertices +
-		sizeof(face) * header->numFaces)
+	MeshData mesh;
+	if(!MeshBuilder::fromTiny3D(data, len, &mesh))
+	{
+		LOG(ERROR) << "Error: Invalid tiny3d data";
 		return;
-
-	data += sizeof(tiny3dHeader);
-	
-	normal* normals = (normal*)data;
-
-	data += sizeof(normal) * header->numNormals;
-
-	uv* uvs = (uv*)data;
-
-	data += sizeof(uv) * header->numUVs;
-
-	vert* vertices = (vert*)data;
-
-	data += sizeof(vert) * header->numVertices;
-
-	face* faces = (face*)data;
-	
-	//Construct OpenGL object
-    m_obj = glGenLists(1);
-    glNewList(m_obj,GL_COMPILE);
-	
-    //Loop through and add faces
-    glBegin(GL_TRIANGLES);
-	face* facePtr = faces;
-    for(unsigned i = 0; i < header->numFaces; i++)
-    {
-		vert v = vertices[facePtr->v1];
-		uv UV = uvs[facePtr->uv1];
-		normal norm = normals[facePtr->norm1];
-        glNormal3f(norm.x, norm.y, norm.z);
-        glTexCoord2f(UV.u, UV.v);
-        glVertex3f(v.x, v.y, v.z);
-        
-		v = vertices[facePtr->v2];
-		UV = uvs[facePtr->uv2];
-		norm = normals[facePtr->norm2];
-        glNormal3f(norm.x, norm.y, norm.z);
-        glTexCoord2f(UV.u, UV.v);
-        glVertex3f(v.x, v.y, v.z);
-		
-		v = vertices[facePtr->v3];
-		UV = uvs[facePtr->uv3];
-		norm = normals[facePtr->norm3];
-        glNormal3f(norm.x, norm.y, norm.z);
-        glTexCoord2f(UV.u, UV.v);
-        glVertex3f(v.x, v.y, v.z);
-
-		facePtr++;
-    }
-
-    glEnd();
-    glEndList();
+	}
+	_upload(mesh);
 }
 
 void Mesh3D::render(Image* img)
 {
-	if(!m_obj) return;
+	if(!m_numIndices) return;
 
 	if(!useGlobalLight)
 	{
@@ -288,8 +256,22 @@ void Mesh3D::render(Image* img)
 	if(wireframe)
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 	if(img != NULL)
+	{
 		glBindTexture(GL_TEXTURE_2D, img->_getTex());
-    glCallList(m_obj);
+		img->pushTexRect();
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glEnableClientState(GL_NORMAL_ARRAY);	//Vertex and texcoord arrays are always on; see engine_gl.cpp
+	glVertexPointer(3, GL_FLOAT, sizeof(MeshVertex), (const GLvoid*)offsetof(MeshVertex, x));
+	glNormalPointer(GL_FLOAT, sizeof(MeshVertex), (const GLvoid*)offsetof(MeshVertex, nx));
+	glTexCoordPointer(2, GL_FLOAT, sizeof(MeshVertex), (const GLvoid*)offsetof(MeshVertex, u));
+	glDrawElements(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, 0);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);	//Everything else draws from client memory
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	if(img != NULL)
+		img->popTexRect();
 	if(wireframe)
 		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);	//Reset to drawing full faces
 	if(!useGlobalLight)
@@ -4,6 +4,8 @@
 */
 #pragma once
 #include <string>
+#include "CachedResource.h"
+#include "MeshBuilder.h"
 
 #define NO_TEXTURE 	"image_none"	//Invalid image
 #define NO_MESH		"mesh_none"		//Invalid 3D mesh
@@ -29,16 +31,21 @@ struct Face
     uint32_t norm1, norm2, norm3;
 };
 
-class Mesh3D
+class Mesh3D : public CachedResource
 {
 protected:
-    unsigned m_obj;   //The object in 3D memory
+    unsigned m_vertexBuffer;	//Interleaved MeshVertex data
+	unsigned m_indexBuffer;
+	unsigned m_numIndices;	//Three per triangle; 0 if nothing's loaded
+	uint64_t m_iMemUsage;	//Bytes in both buffers
 	std::string m_sObjFilename;
 	
 	
     void _fromOBJFile(std::string sFilename);
 	void _fromTiny3DFile(std::string sFilename);
 	void _fromData(const unsigned char* data, unsigned int len);
+	void _upload(const MeshData& mesh);
+	void _free();
 
 	Mesh3D() {};
 
@@ -58,7 +65,8 @@ public:
     void render(Image* img);
 	
 	//Accessor methods
-	std::string getObjFilename()	{if(m_obj)return m_sObjFilename;return NO_MESH;};
+	std::string getObjFilename()	{if(m_numIndices)return m_sObjFilename;return NO_MESH;};
+	uint64_t getMemoryUsage()		{return m_iMemUsage;};
 
 };
 
@@ -0,0 +1,122 @@
+#include "MeshBuilder.h"
+#include "tiny3d.h"
+#include <map>
+using namespace std;
+using namespace tiny3d;
+
+typedef struct
+{
+	uint32_t pos, uv, norm;
+} CornerKey;
+
+class CornerKeyLess
+{
+public:
+	bool operator()(const CornerKey& a, const CornerKey& b) const
+	{
+		if(a.pos != b.pos)
+			return a.pos < b.pos;
+		if(a.uv != b.uv)
+			return a.uv < b.uv;
+		return a.norm < b.norm;
+	}
+};
+
+namespace MeshBuilder
+{
+	bool build(const float* positions, uint32_t numPositions, const float* uvs, uint32_t numUVs, const float* normals, uint32_t numNormals, const vector<uint32_t>& corners, MeshData* out)
+	{
+		out->vertices.clear();
+		out->indices.clear();
+		if(corners.size() % 9)
+			return false;	//Not whole triangles
+
+		map<CornerKey, uint32_t, CornerKeyLess> lookup;
+		out->indices.reserve(corners.size() / 3);
+		for(vector<uint32_t>::const_iterator i = corners.begin(); i != corners.end(); i += 3)
+		{
+			CornerKey key;
+			key.pos = *i;
+			key.uv = *(i + 1);
+			key.norm = *(i + 2);
+			if(key.pos >= numPositions || key.uv >= numUVs || (key.norm >= numNormals && key.norm != MESH_NO_NORMAL))
+			{
+				out->vertices.clear();
+				out->indices.clear();
+				return false;
+			}
+
+			map<CornerKey, uint32_t, CornerKeyLess>::iterator found = lookup.find(key);
+			if(found != lookup.end())
+			{
+				out->indices.push_back(found->second);
+				continue;
+			}
+
+			MeshVertex v;
+			v.x = positions[key.pos * 3];
+			v.y = positions[key.pos * 3 + 1];
+			v.z = positions[key.pos * 3 + 2];
+			if(key.norm == MESH_NO_NORMAL)
+			{
+				v.nx = v.ny = 0.0f;
+				v.nz = 1.0f;
+			}
+			else
+			{
+				v.nx = normals[key.norm * 3];
+				v.ny = normals[key.norm * 3 + 1];
+				v.nz = normals[key.norm * 3 + 2];
+			}
+			v.u = uvs[key.uv * 2];
+			v.v = uvs[key.uv * 2 + 1];
+
+			uint32_t idx = out->vertices.size();
+			lookup[key] = idx;
+			out->vertices.push_back(v);
+			out->indices.push_back(idx);
+		}
+		return true;
+	}
+
+	bool fromTiny3D(const unsigned char* data, unsigned int len, MeshData* out)
+	{
+		//Make sure this is large enough to hold a header
+		if(len < sizeof(tiny3dHeader)) return false;
+
+		const tiny3dHeader* header = (const tiny3dHeader*) data;
+
+		//Make sure this is large enough to hold all the data
+		if(len < sizeof(tiny3dHeader) +
+			sizeof(normal) * (uint64_t)header->numNormals +
+			sizeof(uv) * (uint64_t)header->numUVs +
+			sizeof(vert) * (uint64_t)header->numVertices +
+			sizeof(face) * (uint64_t)header->numFaces)
+			return false;
+
+		data += sizeof(tiny3dHeader);
+		const normal* normals = (const normal*)data;
+		data += sizeof(normal) * header->numNormals;
+		const uv* uvs = (const uv*)data;
+		data += sizeof(uv) * header->numUVs;
+		const vert* vertices = (const vert*)data;
+		data += sizeof(vert) * header->numVertices;
+		const face* faces = (const face*)data;
+
+		vector<uint32_t> corners;
+		corners.reserve(header->numFaces * 9);
+		for(unsigned int i = 0; i < header->numFaces; i++)
+		{
+			const face& f = faces[i];
+			const uint32_t faceCorners[9] =
+			{
+				f.v1, f.uv1, f.norm1,
+				f.v2, f.uv2, f.norm2,
+				f.v3, f.uv3, f.norm3,
+			};
+			corners.insert(corners.end(), faceCorners, faceCorners + 9);
+		}
+
+		return build(&vertices->x, header->numVertices, &uvs->u, header->numUVs, &normals->x, header->numNormals, corners, out);
+	}
+}
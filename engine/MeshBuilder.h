@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+
+#define MESH_NO_NORMAL	0xFFFFFFFF	//Corner has no normal; it gets +z, same as OpenGL's default
+
+typedef struct
+{
+	float x, y, z;
+	float nx, ny, nz;
+	float u, v;
+} MeshVertex;	//Interleaved, exactly as it goes into the vertex buffer
+
+typedef struct
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;	//Three per triangle
+} MeshData;
+
+//Turns faces that index separate position, UV and normal arrays (the way .obj and tiny3d files do)
+// into one vertex per unique (position, uv, normal) and an index array. No OpenGL in here, so
+// Mesh3D only has to upload the result.
+namespace MeshBuilder
+{
+	//positions and normals are 3 floats each, uvs 2. corners is (position, uv, normal) index
+	// triples, three corners per triangle, all zero-based. Returns false, with out left empty, if any
+	// index is out of range.
+	bool build(const float* positions, uint32_t numPositions, const float* uvs, uint32_t numUVs, const float* normals, uint32_t numNormals, const std::vector<uint32_t>& corners, MeshData* out);
+
+	//Same, from a tiny3d file in memory. False if it's truncated or its faces are bad
+	bool fromTiny3D(const unsigned char* data, unsigned int len, MeshData* out);
+}
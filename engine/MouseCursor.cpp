@@ -16,7 +16,8 @@ MouseCursor::MouseCursor()
 
 MouseCursor::~MouseCursor()
 {
-	
+	if(img)
+		img->release();
 }
 	
 void MouseCursor::_init()
@@ -8,6 +8,7 @@
 #include "lattice.h"
 #include "Image.h"
 #include "opengl-api.h"
+#include "RenderQueue.h"
 
 #include <Box2D/Box2D.h>
 #include "tinyxml2.h"
@@ -43,9 +44,16 @@ Object::~Object()
 		delete meshLattice;
 	if(meshAnim)
 		delete meshAnim;
+	if(img)
+		img->release();	//Let the resource cache know we're done with it
 }
 
-void Object::draw(bool bDebugInfo)
+static void drawObjectLattice(void* data, bool bDebugInfo)
+{
+	((Object*)data)->drawLattice(bDebugInfo);
+}
+
+void Object::draw(RenderQueue* queue, int layer)
 {
 	if(!active)
 		return;
@@ -54,7 +62,7 @@ void Object::draw(bool bDebugInfo)
     for(vector<ObjSegment*>::iterator i = segments.begin(); i != segments.end(); i++)
     {
 		if((*i)->active)	//Skip frames that shouldn't be drawn up front
-			(*i)->draw();
+			(*i)->draw(queue, layer);
 	}
 	if(img)
 	{
@@ -67,25 +75,85 @@ void Object::draw(bool bDebugInfo)
 			{
 				b2Vec2 pos = seg->body->GetPosition();
 				//float fAngle = seg->body->GetAngle();	//TODO Is this needed?
-				glPushMatrix();
-				glTranslatef(pos.x, pos.y, depth);
 				if(meshLattice)
-					img->renderLattice(meshLattice, meshSize);
+					queue->addFunc(layer, depth, drawObjectLattice, this);
 				else
-					img->render(meshSize);
-				
-				if(bDebugInfo && meshLattice)
-				{
-					glScalef(meshSize.x, meshSize.y, 1);
-					meshLattice->renderDebug();
-				}
-				
-				glPopMatrix();
+					queue->addSprite(layer, depth, img, glm::translate(glm::mat4(1.0f), glm::vec3(pos.x, pos.y, depth)), meshSize, Color(1.0f, 1.0f, 1.0f, 1.0f));
 			}
 		}
 	}
 }
 
+//Grow bounds and the depth range to include rc at depth d
+static void growBounds(Rect* bounds, float* nearDepth, float* farDepth, const Rect& rc, float d)
+{
+	bounds->left = min(bounds->left, rc.left);
+	bounds->right = max(bounds->right, rc.right);
+	bounds->top = max(bounds->top, rc.top);
+	bounds->bottom = min(bounds->bottom, rc.bottom);
+	*nearDepth = max(*nearDepth, d);
+	*farDepth = min(*farDepth, d);
+}
+
+bool Object::getBounds(Rect* bounds, float* nearDepth, float* farDepth)
+{
+	bool found = false;
+	for(vector<ObjSegment*>::iterator i = segments.begin(); i != segments.end(); i++)
+	{
+		ObjSegment* seg = *i;
+		if(!seg->active || seg->img == NULL)
+			continue;
+		
+		Rect rc;
+		if(!seg->getBounds(&rc))
+			return false;
+		if(!found)
+		{
+			*bounds = rc;
+			*nearDepth = *farDepth = seg->depth;
+			found = true;
+		}
+		else
+			growBounds(bounds, nearDepth, farDepth, rc, seg->depth);
+	}
+	
+	b2Body* b = getBody();
+	if(img && b)
+	{
+		b2Vec2 pos = b->GetPosition();
+		Rect rc(pos.x - meshSize.x / 2.0f, pos.y + meshSize.y / 2.0f, pos.x + meshSize.x / 2.0f, pos.y - meshSize.y / 2.0f);
+		if(!found)
+		{
+			*bounds = rc;
+			*nearDepth = *farDepth = depth;
+			found = true;
+		}
+		else
+			growBounds(bounds, nearDepth, farDepth, rc, depth);
+	}
+	return found;
+}
+
+void Object::drawLattice(bool bDebugInfo)
+{
+	b2Body* b = getBody();
+	if(!img || !meshLattice || !b)
+		return;
+	
+	b2Vec2 pos = b->GetPosition();
+	glPushMatrix();
+	glTranslatef(pos.x, pos.y, depth);
+	img->renderLattice(meshLattice, meshSize);
+	
+	if(bDebugInfo)
+	{
+		glScalef(meshSize.x, meshSize.y, 1);
+		meshLattice->renderDebug();
+	}
+	
+	glPopMatrix();
+}
+
 void Object::addSegment(ObjSegment* seg)
 {
 	if(seg == NULL) return;
@@ -112,7 +180,11 @@ b2Body* Object::getBody()
 void Object::setImage(Image* img, unsigned int seg)
 {
 	if(segments.size() > seg)
-		segments[seg]->img = img;
+	{
+		if(segments[seg]->img)
+			segments[seg]->img->release();
+		segments[seg]->img = img;	//Caller got this from the ResourceLoader, so its use is ours now
+	}
 }
 
 Vec2 Object::getPos()
@@ -191,59 +263,91 @@ ObjSegment::~ObjSegment()
 		delete lat;
 	if(latanim)
 		delete latanim;
+	if(img)
+		img->release();
+	if(obj3D)
+		obj3D->release();
 }
 
-void ObjSegment::draw(bool bDebugInfo)
+static void drawSegment(void* data, bool bDebugInfo)
 {
-	if(img == NULL || !active) return;
-	glColor4f(col.r,col.g,col.b,col.a);
-	glPushMatrix();
+	((ObjSegment*)data)->drawUnbatched(bDebugInfo);
+}
+
+glm::mat4 ObjSegment::getTransform()
+{
+	glm::mat4 xform(1.0f);
 	if(body == NULL)
 	{
-		glRotatef(glm::degrees(rot), 0.0f, 0.0f, 1.0f);
-		glTranslatef(pos.x, pos.y, depth);
-		if(obj3D)
-		{
-			glScalef(size.x, size.y, size.x);	//Can't really scale along z, don't care
-			glEnable(GL_CULL_FACE);
-			glEnable(GL_LIGHTING);
-			obj3D->render(img);
-			glDisable(GL_CULL_FACE);
-			glDisable(GL_LIGHTING);
-		}
-		else
-		{
-			if(lat)
-				img->renderLattice(lat, size);
-			else
-				img->render(size, tile.x, tile.y);
-		}
+		xform = glm::rotate(xform, rot, glm::vec3(0.0f, 0.0f, 1.0f));
+		xform = glm::translate(xform, glm::vec3(pos.x, pos.y, depth));
 	}
 	else
 	{
 		b2Vec2 objpos = body->GetWorldCenter();
 		float objrot = body->GetAngle();
-		glTranslatef(objpos.x, objpos.y, 0.0f);
-		glRotatef(glm::degrees(objrot), 0.0f, 0.0f, 1.0f);
-		glTranslatef(pos.x, pos.y, depth);
-		glRotatef(glm::degrees(rot), 0.0f, 0.0f, 1.0f);
-		if(obj3D)
-		{
-			glScalef(size.x, size.y, size.x);
-			glEnable(GL_CULL_FACE);
-			glEnable(GL_LIGHTING);
-			obj3D->render(img);
-			glDisable(GL_CULL_FACE);
-			glDisable(GL_LIGHTING);
-		}
+		xform = glm::translate(xform, glm::vec3(objpos.x, objpos.y, 0.0f));
+		xform = glm::rotate(xform, objrot, glm::vec3(0.0f, 0.0f, 1.0f));
+		xform = glm::translate(xform, glm::vec3(pos.x, pos.y, depth));
+		xform = glm::rotate(xform, rot, glm::vec3(0.0f, 0.0f, 1.0f));
+	}
+	return xform;
+}
+
+bool ObjSegment::getBounds(Rect* bounds)
+{
+	if(obj3D)
+		return false;	//No idea how big the mesh is
+	
+	//Lattices are assumed to stay within the image's rect
+	glm::mat4 xform = getTransform();
+	for(int i = 0; i < 4; i++)
+	{
+		glm::vec4 p = xform * glm::vec4((i & 1) ? size.x / 2.0f : -size.x / 2.0f, (i & 2) ? size.y / 2.0f : -size.y / 2.0f, 0.0f, 1.0f);
+		if(i == 0)
+			bounds->set(p.x, p.y, p.x, p.y);
 		else
 		{
-			if(lat)
-				img->renderLattice(lat, size);
-			else
-				img->render(size, tile.x, tile.y);
+			bounds->left = min(bounds->left, p.x);
+			bounds->right = max(bounds->right, p.x);
+			bounds->top = max(bounds->top, p.y);
+			bounds->bottom = min(bounds->bottom, p.y);
 		}
 	}
+	return true;
+}
+
+void ObjSegment::draw(RenderQueue* queue, int layer)
+{
+	if(img == NULL || !active) return;
+	
+	//Meshes and lattices have their own geometry and draw themselves
+	if(obj3D || lat)
+		queue->addFunc(layer, depth, drawSegment, this);
+	else
+		queue->addSprite(layer, depth, img, getTransform(), size, col, tile);
+}
+
+void ObjSegment::drawUnbatched(bool bDebugInfo)
+{
+	if(img == NULL || !active) return;
+	
+	glColor4f(col.r,col.g,col.b,col.a);
+	glPushMatrix();
+	glMultMatrixf(glm::value_ptr(getTransform()));
+	if(obj3D)
+	{
+		glScalef(size.x, size.y, size.x);	//Can't really scale along z, don't care
+		glEnable(GL_CULL_FACE);
+		glEnable(GL_LIGHTING);
+		obj3D->render(img);
+		glDisable(GL_CULL_FACE);
+		glDisable(GL_LIGHTING);
+	}
+	else if(lat)
+		img->renderLattice(lat, size);
+	else
+		img->render(size, tile.x, tile.y);
 	glPopMatrix();
 	glColor4f(1.0f,1.0f,1.0f,1.0f);
 }
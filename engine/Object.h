@@ -21,6 +21,7 @@ struct b2BodyDef;
 class Lattice;
 class LatticeAnim;
 class Image;
+class RenderQueue;
 
 //Physical segments of objects - be they actual physics bodies or just images
 //TODO: Why would they just be images unless they're scenery? Make second class for scenery?
@@ -41,7 +42,10 @@ public:
     ObjSegment();
     ~ObjSegment();
 	
-	void draw(bool bDebugInfo = false);
+	void draw(RenderQueue* queue, int layer);	//Submit this segment to queue, on one of the RENDER_LAYERs
+	void drawUnbatched(bool bDebugInfo = false);	//Draw a mesh or lattice segment right away
+	glm::mat4 getTransform();	//Where this segment is drawn
+	bool getBounds(Rect* bounds);	//World-space rect this segment covers. False if we can't tell (3D meshes)
 	void update(float dt);
 };
 
@@ -62,7 +66,9 @@ public:
     Object();
     ~Object();
 
-    void draw(bool bDebugInfo = false);
+    void draw(RenderQueue* queue, int layer);
+    void drawLattice(bool bDebugInfo = false);	//Draw the image on meshLattice right away
+    bool getBounds(Rect* bounds, float* nearDepth, float* farDepth);	//Everything this object draws. False if we can't tell
     void addSegment(ObjSegment* seg);
 	void update(float dt);
 	b2Body* getBody();
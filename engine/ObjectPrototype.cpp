@@ -0,0 +1,139 @@
+#include "ObjectPrototype.h"
+#include "Object.h"
+#include "Image.h"
+#include "Mesh3D.h"
+#include "lattice.h"
+using namespace std;
+
+ObjectPrototype::ObjectPrototype()
+{
+	luaClass = "templateobj";
+	latticeImg = NULL;
+	meshSize = Vec2(0, 0);
+	latticeRes = Vec2(10, 10);
+	latticeType = LATTICE_NONE;
+	centerBody = 0;
+
+	//Same defaults as the lattice animations themselves
+	amp = freq = vtime = 1.0f;
+	speed = 1.0f;
+	startdist = 0.05f;
+	distvar = 0.01f;
+	startangle = 0;
+	anglevar = 0;
+	hfac = vfac = 1;
+}
+
+ObjectPrototype::~ObjectPrototype()
+{
+	for(vector<SegmentPrototype>::iterator i = segments.begin(); i != segments.end(); i++)
+	{
+		for(vector<b2FixtureDef>::iterator j = i->fixtures.begin(); j != i->fixtures.end(); j++)
+			delete j->shape;
+		if(i->img)
+			i->img->release();
+		if(i->obj3D)
+			i->obj3D->release();
+	}
+	if(latticeImg)
+		latticeImg->release();
+}
+
+Object* ObjectPrototype::instantiate(b2World* world, Vec2 ptOffset) const
+{
+	Object* o = new Object;
+	o->luaClass = luaClass;
+
+	for(vector<SegmentPrototype>::const_iterator i = segments.begin(); i != segments.end(); i++)
+	{
+		ObjSegment* seg = new ObjSegment;
+		seg->img = i->img;
+		if(seg->img)
+			seg->img->addUse();
+		seg->obj3D = i->obj3D;
+		if(seg->obj3D)
+			seg->obj3D->addUse();
+		seg->pos = i->pos;
+		seg->tile = i->tile;
+		seg->rot = i->rot;
+		seg->depth = i->depth;
+		seg->size = i->size;
+		seg->col = i->col;
+		seg->parent = o;
+
+		if(i->bBody)
+		{
+			b2BodyDef bodyDef = i->bodyDef;
+			bodyDef.position += b2Vec2(ptOffset.x, ptOffset.y);
+
+			b2Body* bod = world->CreateBody(&bodyDef);
+			seg->body = bod;
+			bod->SetUserData((void*)seg);	//Store user data, so when collisions occur we know what segments are colliding
+			for(vector<b2FixtureDef>::const_iterator j = i->fixtures.begin(); j != i->fixtures.end(); j++)
+				bod->CreateFixture(&(*j));
+		}
+		o->addSegment(seg);
+	}
+
+	for(vector<JointPrototype>::const_iterator i = joints.begin(); i != joints.end(); i++)
+	{
+		b2DistanceJointDef jd = i->def;
+		jd.bodyA = o->segments[i->bodyA]->body;
+		jd.bodyB = o->segments[i->bodyB]->body;
+
+		b2Vec2 p1, p2, d;
+		p1 = jd.bodyA->GetWorldPoint(jd.localAnchorA);
+		p2 = jd.bodyB->GetWorldPoint(jd.localAnchorB);
+		d = p2 - p1;
+		jd.length = d.Length();
+
+		world->CreateJoint(&jd);
+	}
+
+	if(latticeImg)
+	{
+		o->img = latticeImg;
+		o->img->addUse();
+		o->meshSize = meshSize;
+	}
+
+	if(latticeType != LATTICE_NONE)
+	{
+		o->meshLattice = new Lattice((int)latticeRes.x, (int)latticeRes.y);
+
+		if(latticeType == LATTICE_SOFTBODY)
+		{
+			SoftBodyAnim* manim = new SoftBodyAnim(o->meshLattice);
+			manim->addBody(o->segments[centerBody]->body, true);
+			manim->size = o->meshSize;
+			for(vector<unsigned int>::const_iterator i = softBodies.begin(); i != softBodies.end(); i++)
+				manim->addBody(o->segments[*i]->body);
+			manim->init();
+			o->meshAnim = manim;
+		}
+		else if(latticeType == LATTICE_SIN)
+		{
+			SinLatticeAnim* manim = new SinLatticeAnim(o->meshLattice);
+			manim->amp = amp;
+			manim->freq = freq;
+			manim->vtime = vtime;
+			manim->init();
+			o->meshAnim = manim;
+		}
+		else if(latticeType == LATTICE_WOBBLE)
+		{
+			WobbleLatticeAnim* manim = new WobbleLatticeAnim(o->meshLattice);
+			manim->speed = speed;
+			manim->startdist = startdist;
+			manim->distvar = distvar;
+			manim->startangle = startangle;
+			manim->anglevar = anglevar;
+			manim->hfac = hfac;
+			manim->vfac = vfac;
+			manim->init();
+			o->meshAnim = manim;
+		}
+	}
+
+	return o;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "Box2D/Box2D.h"
+#include "Rect.h"
+#include "Color.h"
+#include <vector>
+#include <string>
+
+class Object;
+class Image;
+class Mesh3D;
+
+typedef enum
+{
+	LATTICE_NONE,		//No lattice at all
+	LATTICE_PLAIN,		//Lattice with no animation
+	LATTICE_SOFTBODY,
+	LATTICE_SIN,
+	LATTICE_WOBBLE,
+} LatticeType;
+
+typedef struct
+{
+	//Image layer
+	Image* img;
+	Mesh3D* obj3D;
+	Vec2 pos;
+	Vec2 tile;
+	float rot;
+	float depth;
+	Vec2 size;
+	Color col;
+
+	//Physics body, if any
+	bool bBody;
+	b2BodyDef bodyDef;		//Position relative to where the object is created
+	std::vector<b2FixtureDef> fixtures;	//Shapes are owned by the prototype
+} SegmentPrototype;
+
+typedef struct
+{
+	b2DistanceJointDef def;	//Length is worked out from the bodies when created
+	unsigned int bodyA;		//Segment indices
+	unsigned int bodyB;
+} JointPrototype;
+
+//An object type, compiled from res/obj/<type>.xml once. Creating one of these from the prototype
+// only has to make the Box2D bodies and copy values over; no file access or XML parsing.
+class ObjectPrototype
+{
+public:
+	std::string luaClass;
+	std::vector<SegmentPrototype> segments;
+	std::vector<JointPrototype> joints;
+
+	//Lattice
+	Image* latticeImg;
+	Vec2 meshSize;
+	Vec2 latticeRes;
+	LatticeType latticeType;
+	int centerBody;			//Segment index for softbody lattices
+	std::vector<unsigned int> softBodies;	//The other segments the softbody lattice follows
+
+	//Sin lattice
+	float amp, freq, vtime;
+
+	//Wobble lattice
+	float speed, startdist, distvar, startangle, anglevar, hfac, vfac;
+
+	ObjectPrototype();
+	~ObjectPrototype();
+
+	Object* instantiate(b2World* world, Vec2 ptOffset) const;
+};
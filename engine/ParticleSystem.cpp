@@ -31,6 +31,7 @@ ParticleSystem::ParticleSystem()
 	m_lifePreFade = NULL;
 	m_rotAxis = NULL;
 	m_num = 0;
+	m_extent = Vec2(0.0f, 0.0f);
 	glue = NULL;
 	lua = NULL;
 
@@ -48,6 +49,8 @@ ParticleSystem::ParticleSystem()
 ParticleSystem::~ParticleSystem()
 {
 	_deleteAll();
+	if(img)
+		img->release();
 	if(glue && lua)
 	{
 		lua->deleteObject(glue);
@@ -141,10 +144,10 @@ void ParticleSystem::_newParticle()
 
 	//Add proper locations from m_imgRect to tex coord ptr array here
 	float* particleTexCoord = &m_texCoordPtr[m_num * 8];
-	float left = m_imgRect[m_num].left / (float)img->getWidth();
-	float right = m_imgRect[m_num].right / (float)img->getWidth();
-	float top = 1.0f - m_imgRect[m_num].top / (float)img->getHeight();
-	float bottom = 1.0f - m_imgRect[m_num].bottom / (float)img->getHeight();
+	float left = img->texU(m_imgRect[m_num].left / (float)img->getWidth());
+	float right = img->texU(m_imgRect[m_num].right / (float)img->getWidth());
+	float top = img->texV(1.0f - m_imgRect[m_num].top / (float)img->getHeight());
+	float bottom = img->texV(1.0f - m_imgRect[m_num].bottom / (float)img->getHeight());
 
 	*particleTexCoord++ = left; *particleTexCoord++ = bottom; // lower left
 	*particleTexCoord++ = right; *particleTexCoord++ = bottom; // lower right
@@ -156,6 +159,8 @@ void ParticleSystem::_newParticle()
 	m_sizeStart[m_num].y = sizeStart.y + sizediff;
 	m_sizeEnd[m_num].x = sizeEnd.x + sizediff;
 	m_sizeEnd[m_num].y = sizeEnd.y + sizediff;
+	m_extent.x = std::max(m_extent.x, std::max(fabs(m_sizeStart[m_num].x), fabs(m_sizeEnd[m_num].x)) / 2.0f);
+	m_extent.y = std::max(m_extent.y, std::max(fabs(m_sizeStart[m_num].y), fabs(m_sizeEnd[m_num].y)) / 2.0f);
 	float angle = emissionAngle + Random::randomFloat(-emissionAngleVar,emissionAngleVar);
 	float amt = speed + Random::randomFloat(-speedVar,speedVar);
 	m_vel[m_num].x = amt*cos(glm::radians(angle));
@@ -220,10 +225,10 @@ void ParticleSystem::_newParticle()
 void ParticleSystem::_rmParticle(const unsigned idx)
 {
 	float* particleTexCoord = &m_texCoordPtr[idx * 8];
-	float left = m_imgRect[m_num - 1].left / (float)img->getWidth();
-	float right = m_imgRect[m_num - 1].right / (float)img->getWidth();
-	float top = 1.0f - m_imgRect[m_num - 1].top / (float)img->getHeight();
-	float bottom = 1.0f - m_imgRect[m_num - 1].bottom / (float)img->getHeight();
+	float left = img->texU(m_imgRect[m_num - 1].left / (float)img->getWidth());
+	float right = img->texU(m_imgRect[m_num - 1].right / (float)img->getWidth());
+	float top = img->texV(1.0f - m_imgRect[m_num - 1].top / (float)img->getHeight());
+	float bottom = img->texV(1.0f - m_imgRect[m_num - 1].bottom / (float)img->getHeight());
 
 	*particleTexCoord++ = left; *particleTexCoord++ = bottom; // lower left
 	*particleTexCoord++ = right; *particleTexCoord++ = bottom; // lower right
@@ -276,6 +281,7 @@ void ParticleSystem::_initValues()
 	lifetime = 4;
 	lifetimeVar = 0;
 	decay = FLT_MAX;
+	decayVar = 0;
 	startedFiring = 0.0f;
 	rotAxis = Vec3(0.0f, 0.0f, 1.0f);
 	
@@ -321,13 +327,21 @@ void ParticleSystem::update(float dt)
 	}
 	
 	//Update particle fields (In separate for loops to cut down on cache thrashing)
+	//Track bounds as we move particles, for culling
+	Vec2 boundsMin(std::min(emitFrom.left, emitFrom.right), std::min(emitFrom.top, emitFrom.bottom));
+	Vec2 boundsMax(std::max(emitFrom.left, emitFrom.right), std::max(emitFrom.top, emitFrom.bottom));
 	Vec2* ptPos = m_pos;
 	Vec2* ptVel = m_vel;
 	for(unsigned int i = 0; i < m_num; i++, ptPos++, ptVel++)
 	{
 		ptPos->x += ptVel->x * dt;
 		ptPos->y += ptVel->y * dt;
+		boundsMin.x = std::min(boundsMin.x, ptPos->x);
+		boundsMin.y = std::min(boundsMin.y, ptPos->y);
+		boundsMax.x = std::max(boundsMax.x, ptPos->x);
+		boundsMax.y = std::max(boundsMax.y, ptPos->y);
 	}
+	m_bounds.set(boundsMin.x - m_extent.x, boundsMax.y + m_extent.y, boundsMax.x + m_extent.x, boundsMin.y - m_extent.y);
 	
 	ptVel = m_vel;
 	Vec2* ptAccel = m_accel;
@@ -478,6 +492,59 @@ void ParticleSystem::draw()
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
+ParticleSystem* ParticleSystem::clone() const
+{
+	ParticleSystem* ps = new ParticleSystem();
+
+	ps->sizeStart = sizeStart;
+	ps->sizeEnd = sizeEnd;
+	ps->sizeVar = sizeVar;
+	ps->speed = speed;
+	ps->speedVar = speedVar;
+	ps->accel = accel;
+	ps->accelVar = accelVar;
+	ps->rotStart = rotStart;
+	ps->rotStartVar = rotStartVar;
+	ps->rotVel = rotVel;
+	ps->rotVelVar = rotVelVar;
+	ps->rotAccel = rotAccel;
+	ps->rotAccelVar = rotAccelVar;
+	ps->colStart = colStart;
+	ps->colEnd = colEnd;
+	ps->colVar = colVar;
+	ps->tangentialAccel = tangentialAccel;
+	ps->tangentialAccelVar = tangentialAccelVar;
+	ps->normalAccel = normalAccel;
+	ps->normalAccelVar = normalAccelVar;
+	ps->lifetime = lifetime;
+	ps->lifetimeVar = lifetimeVar;
+	ps->lifetimePreFade = lifetimePreFade;
+	ps->lifetimePreFadeVar = lifetimePreFadeVar;
+	ps->decay = decay + Random::randomFloat(-decayVar, decayVar);
+	ps->decayVar = decayVar;
+	ps->rotAxis = rotAxis;
+	ps->rotAxisVar = rotAxisVar;
+
+	ps->img = img;
+	if(img)
+		img->addUse();	//Each system holds its own use of the image
+	ps->imgRect = imgRect;
+	ps->max = max;
+	ps->rate = rate;
+	ps->curRate = curRate;
+	ps->emitFrom = emitFrom;
+	ps->blend = blend;
+	ps->emissionAngle = emissionAngle;
+	ps->emissionAngleVar = emissionAngleVar;
+	ps->firing = firing;
+	ps->spawnOnDeath = spawnOnDeath;
+	ps->emissionVel = emissionVel;
+	ps->m_sXMLFrom = m_sXMLFrom;
+
+	ps->init();
+	return ps;
+}
+
 void ParticleSystem::init()
 {
 	if(m_num)
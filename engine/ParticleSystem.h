@@ -59,6 +59,9 @@ class ParticleSystem
 	void _rmParticle(const unsigned idx);	//Delete an expired particle (i.e. copy particle at end of the list to where this one was)
 	void _initValues();				//Initialize particle system variables
 
+	Rect m_bounds;					//Everything drawn as of the last update
+	Vec2 m_extent;					//Half the biggest particle size we've spawned
+
 	float curTime;
 	float spawnCounter;
 	float startedFiring;			//When we started firing (to keep track of decay)
@@ -102,6 +105,7 @@ public:
 	float			lifetimePreFade;	//How long the particle stays alive before changing colors
 	float			lifetimePreFadeVar;
 	float			decay;				//How many seconds after firing to stop firing
+	float			decayVar;			//Applied to decay by clone(), so each copy stops at its own time
 	Vec3			rotAxis;			//What axis these particles rotate around
 	Vec3			rotAxisVar;
 	
@@ -126,9 +130,11 @@ public:
 	void update(float dt);
 	void draw();
 	void init();
+	ParticleSystem* clone() const;	//New, initialized system with the same settings and no particles. Doesn't copy Lua glue or subject
 	unsigned count() {return m_num;};		//How many particles are currently alive (read-only because reasons)
 	void killParticles()	{m_num=0;};		//Kill all active particles
 	bool done()				{return !(m_num || firing);};	//Test and see if effect is done
+	const Rect& getBounds()	{return m_bounds;};		//World-space rect covering emitFrom and every particle, at depth 0
 
 	void setSubject(Subject* subject) { m_subject = subject; };
 };
@@ -0,0 +1,175 @@
+#include "RenderQueue.h"
+#include "Image.h"
+#include <cstring>
+using namespace std;
+
+//Sort key layout, high bits first
+#define KEY_LAYER_SHIFT		60	//4 bits
+#define KEY_DEPTH_SHIFT		28	//32 bits
+#define KEY_BLEND_SHIFT		26	//2 bits
+#define KEY_TEX_MASK		0x3FFFFFF	//26 bits; texture names are small, and a collision only costs a draw
+
+//Map a float to an unsigned int that sorts the same way
+static uint32_t depthBits(float depth)
+{
+	uint32_t bits;
+	depth += 0.0f;	//-0 to 0, so they sort together
+	memcpy(&bits, &depth, sizeof(bits));
+	if(bits & 0x80000000)
+		return ~bits;
+	return bits | 0x80000000;
+}
+
+RenderQueue::RenderQueue()
+{
+	m_cull = false;
+	m_culled = m_visible = 0;
+	m_lastCommands = m_lastDraws = 0;
+	m_lastCulled = m_lastVisible = 0;
+}
+
+void RenderQueue::addKey(int layer, float depth, int blend, unsigned int tex)
+{
+	RenderKey key;
+	key.key = ((uint64_t)(layer & (RENDER_LAYER_COUNT - 1)) << KEY_LAYER_SHIFT)
+		| ((uint64_t)depthBits(depth) << KEY_DEPTH_SHIFT)
+		| ((uint64_t)(blend & 0x3) << KEY_BLEND_SHIFT)
+		| (tex & KEY_TEX_MASK);
+	key.cmd = m_commands.size();
+	key.pad = 0;
+	m_keys.push_back(key);
+}
+
+void RenderQueue::addSprite(int layer, float depth, Image* img, const glm::mat4& xform, Vec2 size, const Color& col, Vec2 tile, int blend)
+{
+	if(img == NULL)
+		return;
+
+	addKey(layer, depth, blend, img->_getTex());
+	RenderCommand cmd;
+	cmd.img = img;
+	cmd.xform = xform;
+	cmd.size = size;
+	cmd.tile = tile;
+	cmd.col = col;
+	cmd.blend = blend;
+	cmd.func = NULL;
+	cmd.data = NULL;
+	m_commands.push_back(cmd);
+}
+
+void RenderQueue::addFunc(int layer, float depth, RenderFunc func, void* data)
+{
+	addKey(layer, depth, SPRITE_BLEND_ALPHA, 0);
+	RenderCommand cmd;
+	cmd.img = NULL;
+	cmd.blend = SPRITE_BLEND_ALPHA;
+	cmd.func = func;
+	cmd.data = data;
+	m_commands.push_back(cmd);
+}
+
+//LSD radix sort, a byte at a time. Stable, and skips any byte that's the same for every key
+// (the layer and blend bytes usually are)
+void RenderQueue::sortKeys()
+{
+	m_sortTemp.resize(m_keys.size());
+	for(int shift = 0; shift < 64; shift += 8)
+	{
+		unsigned int counts[256] = {0};
+		for(vector<RenderKey>::iterator i = m_keys.begin(); i != m_keys.end(); i++)
+			counts[(i->key >> shift) & 0xFF]++;
+		if(counts[(m_keys[0].key >> shift) & 0xFF] == m_keys.size())
+			continue;
+
+		unsigned int offsets[256];
+		unsigned int total = 0;
+		for(int i = 0; i < 256; i++)
+		{
+			offsets[i] = total;
+			total += counts[i];
+		}
+		for(vector<RenderKey>::iterator i = m_keys.begin(); i != m_keys.end(); i++)
+			m_sortTemp[offsets[(i->key >> shift) & 0xFF]++] = *i;
+		m_keys.swap(m_sortTemp);
+	}
+}
+
+void RenderQueue::execute(bool bDebugInfo)
+{
+	m_lastCommands = m_commands.size();
+	m_lastDraws = 0;
+	m_lastCulled = m_culled;
+	m_lastVisible = m_visible;
+	m_culled = m_visible = 0;
+	if(m_keys.empty())
+		return;
+
+	sortKeys();
+	RenderCommand* prev = NULL;	//Last sprite, while it's still in the batch
+	for(vector<RenderKey>::iterator i = m_keys.begin(); i != m_keys.end(); i++)
+	{
+		RenderCommand& cmd = m_commands[i->cmd];
+		if(cmd.img)
+		{
+			//SpriteBatch flushes by itself whenever the texture or blend mode changes
+			if(!prev || prev->img->_getTex() != cmd.img->_getTex() || prev->blend != cmd.blend)
+				m_lastDraws++;
+			m_batch.add(cmd.img, cmd.xform, cmd.size, cmd.col, cmd.tile, cmd.blend);
+			prev = &cmd;
+		}
+		else
+		{
+			m_batch.flush();
+			cmd.func(cmd.data, bDebugInfo);
+			m_lastDraws++;
+			prev = NULL;
+		}
+	}
+	m_batch.flush();
+
+	m_commands.clear();
+	m_keys.clear();
+}
+
+void RenderQueue::setView(const glm::mat4& mat)
+{
+	m_view = mat;
+	m_cull = true;
+}
+
+bool RenderQueue::isVisible(const Rect& rc, float nearDepth, float farDepth)
+{
+	if(!m_cull)
+	{
+		m_visible++;
+		return true;
+	}
+
+	//Offscreen only if every corner of the box is past the same side of the screen
+	unsigned int left = 0, right = 0, below = 0, above = 0;
+	const float xs[2] = {rc.left, rc.right};
+	const float ys[2] = {rc.bottom, rc.top};
+	const float zs[2] = {nearDepth, farDepth};
+	for(int i = 0; i < 8; i++)
+	{
+		glm::vec4 p = m_view * glm::vec4(xs[i & 1], ys[(i >> 1) & 1], zs[i >> 2], 1.0f);
+		if(p.w <= 0.0f)
+		{
+			//Behind the camera; don't bother
+			m_visible++;
+			return true;
+		}
+		if(p.x < -p.w) left++;
+		if(p.x > p.w) right++;
+		if(p.y < -p.w) below++;
+		if(p.y > p.w) above++;
+	}
+	if(left == 8 || right == 8 || below == 8 || above == 8)
+	{
+		m_culled++;
+		return false;
+	}
+	m_visible++;
+	return true;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "SpriteBatch.h"
+#include "Rect.h"
+
+//Layers, in the order they're drawn
+#define RENDER_LAYER_BACKGROUND		0	//Scenery behind everything
+#define RENDER_LAYER_OBJECTS		1
+#define RENDER_LAYER_PARTICLES		2
+#define RENDER_LAYER_FOREGROUND		3	//Scenery in front of everything
+#define RENDER_LAYER_COUNT			16	//Most the sort key has room for
+
+typedef void (*RenderFunc)(void* data, bool bDebugInfo);
+
+//Everything EntityManager draws in a frame gets submitted here, then sorted and drawn all at once.
+// Each command gets a 64-bit key, layer first, then depth (far to near), then blend mode and texture,
+// so sprites that can share a draw end up next to each other no matter who submitted them. The sort
+// is stable, so anything with the same key draws in the order it came in.
+class RenderQueue
+{
+	typedef struct
+	{
+		Image* img;			//NULL for a function command
+		glm::mat4 xform;
+		Vec2 size;
+		Vec2 tile;
+		Color col;
+		int blend;
+		RenderFunc func;
+		void* data;
+	} RenderCommand;
+
+	typedef struct
+	{
+		uint64_t key;
+		uint32_t cmd;		//Index into m_commands
+		uint32_t pad;
+	} RenderKey;
+
+	std::vector<RenderCommand> m_commands;
+	std::vector<RenderKey> m_keys;
+	std::vector<RenderKey> m_sortTemp;
+	SpriteBatch m_batch;
+
+	glm::mat4 m_view;		//World to clip space, for culling
+	bool m_cull;			//If we have a view to cull against
+	unsigned int m_culled;	//isVisible() results since the last execute()
+	unsigned int m_visible;
+
+	unsigned int m_lastCommands;	//How much the last execute() did
+	unsigned int m_lastDraws;
+	unsigned int m_lastCulled;
+	unsigned int m_lastVisible;
+
+	void sortKeys();
+	void addKey(int layer, float depth, int blend, unsigned int tex);
+
+	RenderQueue(const RenderQueue&);
+	RenderQueue& operator=(const RenderQueue&);
+public:
+	RenderQueue();
+
+	//Same as SpriteBatch::add(), drawn at the given layer and depth
+	void addSprite(int layer, float depth, Image* img, const glm::mat4& xform, Vec2 size, const Color& col, Vec2 tile = Vec2(1.0f, 1.0f), int blend = SPRITE_BLEND_ALPHA);
+
+	//For anything that draws itself: func(data, bDebugInfo) is called at this command's turn, with
+	// nothing else pending
+	void addFunc(int layer, float depth, RenderFunc func, void* data);
+
+	//Sort, draw, and clear everything submitted since the last call
+	void execute(bool bDebugInfo = false);
+
+	//Cull against the camera; mat is projection * modelview. Until this is called, everything's visible
+	void setView(const glm::mat4& mat);
+
+	//Test if any of the world-space rect rc, anywhere from nearDepth to farDepth, is on screen. Counts
+	// toward the culled/visible counts, so call it once per thing that might get submitted
+	bool isVisible(const Rect& rc, float nearDepth, float farDepth);
+	bool isVisible(const Rect& rc, float depth)	{return isVisible(rc, depth, depth);};
+
+	unsigned int getLastCommandCount()	{return m_lastCommands;};
+	unsigned int getLastDrawCount()		{return m_lastDraws;};	//Batched draws plus function commands
+	unsigned int getLastCulledCount()	{return m_lastCulled;};
+	unsigned int getLastVisibleCount()	{return m_lastVisible;};
+};
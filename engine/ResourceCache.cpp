@@ -1,49 +1,150 @@
 #include "ResourceCache.h"
 #include "Image.h"
 #include "Mesh3D.h"
+#include "easylogging++.h"
+#include <vector>
+#include <algorithm>
 using namespace std;
 
+ResourceCache::ResourceCache()
+{
+	m_images.bytes = m_meshes.bytes = 0;
+	m_images.budget = DEFAULT_TEXTURE_BUDGET;
+	m_meshes.budget = DEFAULT_MESH_BUDGET;
+	m_tick = 0;
+}
+
 ResourceCache::~ResourceCache()
 {
 	clear();
 }
 
-Image* ResourceCache::findImage(uint64_t id)
+CachedResource* ResourceCache::find(CachePool* pool, uint64_t id)
 {
-	map<uint64_t, Image*>::iterator i = imageIDMap.find(id);
-	if(i == imageIDMap.end())	//This image isn't here
+	map<uint64_t, CacheEntry>::iterator i = pool->entries.find(id);
+	if(i == pool->entries.end())	//This resource isn't here
 		return NULL;
-	return i->second;
+
+	i->second.lastUsed = ++m_tick;
+	i->second.res->addUse();
+	return i->second.res;
 }
 
-void ResourceCache::addImage(uint64_t id, Image* img)
+void ResourceCache::add(CachePool* pool, uint64_t id, CachedResource* res)
+{
+	CacheEntry entry;
+	entry.res = res;
+	entry.bytes = res->getMemoryUsage();
+	entry.lastUsed = entry.added = ++m_tick;
+	res->addUse();
+
+	map<uint64_t, CacheEntry>::iterator i = pool->entries.find(id);
+	if(i != pool->entries.end())
+	{
+		//Replacing something; whoever still has the old one keeps it, but we stop tracking it
+		LOG(WARNING) << "Resource ID " << id << " added to cache twice";
+		pool->bytes -= i->second.bytes;
+		i->second = entry;
+	}
+	else
+		pool->entries[id] = entry;
+	pool->bytes += entry.bytes;
+
+	if(pool->bytes > pool->budget)
+		trim(pool);
+}
+
+static bool olderThan(const pair<uint64_t, uint64_t>& a, const pair<uint64_t, uint64_t>& b)
 {
-	imageIDMap[id] = img;
+	return a.first < b.first;
 }
 
-void ResourceCache::clearImages()
+void ResourceCache::trim(CachePool* pool)
 {
-	for(map<uint64_t, Image*>::iterator i = imageIDMap.begin(); i != imageIDMap.end(); i++)
-		delete (i->second);
-	imageIDMap.clear();
+	if(pool->bytes <= pool->budget)
+		return;
+
+	//Unused entries by last use (tick, ID), oldest first
+	vector<pair<uint64_t, uint64_t> > unused;
+	for(map<uint64_t, CacheEntry>::iterator i = pool->entries.begin(); i != pool->entries.end(); i++)
+	{
+		if(!i->second.res->getUses())
+			unused.push_back(make_pair(i->second.lastUsed, i->first));
+	}
+	sort(unused.begin(), unused.end(), olderThan);
+
+	for(vector<pair<uint64_t, uint64_t> >::iterator i = unused.begin(); i != unused.end() && pool->bytes > pool->budget; i++)
+	{
+		map<uint64_t, CacheEntry>::iterator entry = pool->entries.find(i->second);
+		pool->bytes -= entry->second.bytes;
+		delete entry->second.res;
+		pool->entries.erase(entry);
+	}
+}
+
+static bool addedLater(const pair<uint64_t, uint64_t>& a, const pair<uint64_t, uint64_t>& b)
+{
+	return a.first > b.first;
+}
+
+void ResourceCache::clear(CachePool* pool)
+{
+	//Newest first, so anything holding a use of an older entry lets go of it before that one's checked
+	vector<pair<uint64_t, uint64_t> > all;
+	for(map<uint64_t, CacheEntry>::iterator i = pool->entries.begin(); i != pool->entries.end(); i++)
+		all.push_back(make_pair(i->second.added, i->first));
+	sort(all.begin(), all.end(), addedLater);
+
+	for(vector<pair<uint64_t, uint64_t> >::iterator i = all.begin(); i != all.end(); i++)
+	{
+		map<uint64_t, CacheEntry>::iterator entry = pool->entries.find(i->second);
+		if(entry->second.res->getUses())
+		{
+			//Someone still has it; freeing it now would leave them holding a dangling pointer
+			LOG(WARNING) << "Resource ID " << i->second << " still in use; keeping it cached";
+			continue;
+		}
+		pool->bytes -= entry->second.bytes;
+		delete entry->second.res;
+		pool->entries.erase(entry);
+	}
+}
+
+Image* ResourceCache::findImage(uint64_t id)
+{
+	return (Image*)find(&m_images, id);
+}
+
+void ResourceCache::addImage(uint64_t id, Image* img)
+{
+	add(&m_images, id, img);
 }
 
 Mesh3D* ResourceCache::findMesh(uint64_t id)
 {
-	map<uint64_t, Mesh3D*>::iterator i = meshIDMap.find(id);
-	if(i == meshIDMap.end())	//This image isn't here
-		return NULL;
-	return i->second;
+	return (Mesh3D*)find(&m_meshes, id);
 }
 
 void ResourceCache::addMesh(uint64_t id, Mesh3D* mesh)
 {
-	meshIDMap[id] = mesh;
+	add(&m_meshes, id, mesh);
+}
+
+void ResourceCache::setBudget(uint64_t textureBytes, uint64_t meshBytes)
+{
+	m_images.budget = textureBytes;
+	m_meshes.budget = meshBytes;
+	trim();
+}
+
+void ResourceCache::trim()
+{
+	trim(&m_images);
+	trim(&m_meshes);
 }
 
-void ResourceCache::clearMeshes()
+void ResourceCache::clear()
 {
-	for(map<uint64_t, Mesh3D*>::iterator i = meshIDMap.begin(); i != meshIDMap.end(); i++)
-		delete (i->second);
-	meshIDMap.clear();
+	clear(&m_images);
+	clear(&m_meshes);
 }
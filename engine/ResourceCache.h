@@ -1,21 +1,46 @@
 #pragma once
 #include <map>
+#include <inttypes.h>
 
 class Image;
 class Mesh3D;
+class CachedResource;
 
+#define DEFAULT_TEXTURE_BUDGET	(256*1024*1024)	//Bytes of textures to keep around, counting ones nobody's using
+#define DEFAULT_MESH_BUDGET		(64*1024*1024)	//Same for mesh vertex data
+
+//Images and meshes by content ID (see PakLoader::getContentID()), so paths with identical data
+// share one copy. Each find*()/add*() adds a use to what it returns (see
+// CachedResource). Once a pool is over its budget, unused entries are freed least recently used
+// first; anything still in use stays, even if that means going over budget.
 class ResourceCache
 {
-	std::map<Image*, uint32_t> imageUses;
-	std::map<uint64_t, Image*> imageIDMap;
+	typedef struct
+	{
+		CachedResource* res;
+		uint64_t bytes;		//Counted against the budget
+		uint64_t lastUsed;	//m_tick when it was last handed out
+		uint64_t added;		//m_tick when it was added. Later entries can hold uses of earlier ones (atlased images and their pages)
+	} CacheEntry;
+
+	typedef struct
+	{
+		std::map<uint64_t, CacheEntry> entries;
+		uint64_t bytes;		//Total of all entries
+		uint64_t budget;
+	} CachePool;
 
-	std::map<Mesh3D*, uint32_t> meshUses;
-	std::map<uint64_t, Mesh3D*> meshIDMap;
+	CachePool m_images;
+	CachePool m_meshes;
+	uint64_t m_tick;
 
-	void clearImages();
-	void clearMeshes();
+	CachedResource* find(CachePool* pool, uint64_t id);
+	void add(CachePool* pool, uint64_t id, CachedResource* res);
+	void trim(CachePool* pool);
+	void clear(CachePool* pool);
 
 public:
+	ResourceCache();
 	~ResourceCache();
 
 	Image* findImage(uint64_t id);
@@ -24,5 +49,16 @@ public:
 	Mesh3D* findMesh(uint64_t id);
 	void addMesh(uint64_t id, Mesh3D* mesh);
 
-	void clear() { clearImages(); clearMeshes(); };
-};
\ No newline at end of file
+	void setBudget(uint64_t textureBytes, uint64_t meshBytes);
+
+	//Free unused entries until both pools are within budget
+	void trim();
+
+	//Free every unused entry, regardless of budget. Anything still in use stays cached (and is logged)
+	void clear();
+
+	uint64_t getTextureBytes()	{return m_images.bytes;};
+	uint64_t getMeshBytes()		{return m_meshes.bytes;};
+	unsigned int getNumImages()	{return m_images.entries.size();};
+	unsigned int getNumMeshes()	{return m_meshes.entries.size();};
+};
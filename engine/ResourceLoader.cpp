@@ -3,774 +3,1101 @@
 #include "ParticleSystem.h"
 #include "easylogging++.h"
 #include "tinyxml2.h"
-#include "Random.h"
 #include "MouseCursor.h"
 #include "Object.h"
+#include "ObjectPrototype.h"
+#include "CompiledXML.h"
 #include "Box2D/Box2D.h"
 #include "ResourceCache.h"
 #include "PakLoader.h"
-#include "Parse.h"
+#include "ResourceArena.h"
+#include "Mesh3D.h"
+#include "FileOperations.h"
+#include "ResourceTypes.h"
+#include "ThreadPool.h"
+#include "stb_image.h"
+#include <SDL.h>
+#include <cstring>
+#include <algorithm>
 using namespace std;
 
+#define MESH_DATA_ALIGNMENT	4	//tiny3d data is read in place as floats and uints
+
+//Pak data that's only needed until the end of a synchronous load is decompressed in here, rather
+// than into a fresh new[] every time. One per thread, since loadDef() runs on workers too.
+static ResourceArena* scratchArena()
+{
+	static thread_local ResourceArena arena;
+	return &arena;
+}
+
 ResourceLoader::ResourceLoader(b2World* physicsWorld, string sPakDir)
 {
 	m_world = physicsWorld;
 	m_cache = new ResourceCache();
 	m_sPakDir = sPakDir;
-	m_pakLoader = new PakLoader(m_sPakDir);
+	m_pakLoader = new PakLoader(m_sPakDir, true);
+	m_decodedMutex = SDL_CreateMutex();
+	m_pool = new ThreadPool();
+	m_pakLoader->setTaskRunner(m_pool);
+	m_bRecording = false;
 }
 
 ResourceLoader::~ResourceLoader()
 {
+	m_pakLoader->setTaskRunner(NULL);
+	delete m_pool;	//Stop workers before anything they might be using goes away
+	for(set<ResourceRequest*>::iterator i = m_requests.begin(); i != m_requests.end(); i++)
+		delete *i;
+	SDL_DestroyMutex(m_decodedMutex);
+	clearParticleTemplates();	//Before the cache, since they hold image uses
+	clearObjPrototypes();
 	delete m_cache;
 	delete m_pakLoader;
 }
 
-//From http://stackoverflow.com/a/13487193
-uint64_t ResourceLoader::hash(string sHashStr)
+void ResourceLoader::clearCache()
 {
-	const char* str = sHashStr.c_str();
-	uint64_t hash = 5381;
-	int c;
+	flush();	//Decoded requests may be pointing into paks we're about to close
+	clearParticleTemplates();
+	clearObjPrototypes();
+	m_cache->clear();
+	m_pakLoader->clear();
+}
 
-	while(c = *str++)
-		hash = ((hash << 5) + hash) + c;
+bool ResourceLoader::loadData(const string& sID, uint64_t id, ResourceData* out, bool bFileFallback, unsigned int alignment, ResourceAllocator* allocator)
+{
+	out->owned = NULL;
+	out->bMalloced = false;
+	out->data = m_pakLoader->getResourceView(id, &out->len, alignment);	//Use mapped pak data in place if we can
+	if(!out->data && allocator)
+		out->data = m_pakLoader->loadResource(id, &out->len, allocator);	//Allocator memory isn't ours to free
+	else if(!out->data)
+		out->data = out->owned = m_pakLoader->loadResource(id, &out->len);
+	if(out->data && out->len)
+		return true;
+	freeData(out);
+
+	if(!bFileFallback)
+		return false;
+
+	LOG(TRACE) << "Pak miss - load from file";
+	out->data = out->owned = FileOperations::readFile(sID, &out->len);
+	out->bMalloced = true;
+	if(out->data && out->len)
+		return true;
+	freeData(out);
+	return false;
+}
 
-	return hash;
+void ResourceLoader::freeData(ResourceData* data)
+{
+	if(data->owned)
+	{
+		if(data->bMalloced)
+			free(data->owned);
+		else
+			delete[] data->owned;
+	}
+	data->owned = NULL;
+	data->data = NULL;
+	data->len = 0;
 }
 
-void ResourceLoader::clearCache()
+void ResourceLoader::freeImage(DecodedImage* img)
 {
-	m_cache->clear();
-	m_pakLoader->clear();
+	freeData(&img->raw);
+	if(img->stbiPixels)
+		stbi_image_free(img->stbiPixels);
+	img->stbiPixels = NULL;
+	img->pixels = NULL;
 }
 
-Image* ResourceLoader::getImage(string sID)
+bool ResourceLoader::decodeImage(const string& sID, uint64_t id, DecodedImage* out, ResourceAllocator* allocator)
 {
-	LOG(TRACE) << "Loading image " << sID;
-	uint64_t hashVal = hash(sID);
-	LOG(TRACE) << "Image has ID " << hashVal;
-	Image* img = m_cache->findImage(hashVal);
-	if(!img)	//This image isn't here; load it
+	out->stbiPixels = NULL;
+	out->pixels = NULL;
+	out->atlas.clear();
+	if(loadData(sID, id, &out->raw, false, 1, allocator))
 	{
-		LOG(TRACE) << "Cache miss";
-		unsigned int len = 0;
-		unsigned char* resource = m_pakLoader->loadResource(hashVal, &len);
-		if(!resource || !len)
+		LOG(TRACE) << "Pak hit - load from data";
+		if(out->raw.len < sizeof(TextureHeader))
 		{
-			LOG(TRACE) << "Pak miss - load from file";
-			img = new Image(sID);				//Create this image
-			m_cache->addImage(hashVal, img);	//Add to the cache
+			LOG(ERROR) << "Decompressed image data smaller than texture header";
+			freeData(&out->raw);
+			return false;
 		}
-		else
+
+		TextureHeader header;
+		memcpy(&header, out->raw.data, sizeof(TextureHeader));
+		if(header.bpp == TEXTURE_BPP_ATLAS)
+			return decodeAtlasRegion(header, out);
+
+		if(out->raw.len - sizeof(TextureHeader) < header.width * header.height * header.bpp / 8)
 		{
-			LOG(TRACE) << "Pak hit - load from data";
-			img = new Image(resource, len);
-			m_cache->addImage(hashVal, img);
-			free(resource);						//Free memory
+			LOG(ERROR) << "Insufficient image data. Expected: " << header.width * header.height * header.bpp / 8 << ", actual: " << out->raw.len - sizeof(TextureHeader);
+			freeData(&out->raw);
+			return false;
 		}
+
+		out->pixels = out->raw.data + sizeof(TextureHeader);
+		out->width = header.width;
+		out->height = header.height;
+		out->mode = (header.bpp == TEXTURE_BPP_RGB) ? GL_RGB : GL_RGBA;
+		return true;
+	}
+
+	LOG(TRACE) << "Pak miss - load from file";
+	int comp = 0;
+	int width = 0;
+	int height = 0;
+	out->stbiPixels = stbi_load(sID.c_str(), &width, &height, &comp, 0);
+	if(!out->stbiPixels || !width || !height)
+	{
+		freeImage(out);
+		return false;
+	}
+
+	out->pixels = out->stbiPixels;
+	out->width = width;
+	out->height = height;
+	out->mode = (comp == 3) ? GL_RGB : GL_RGBA;
+	return true;
+}
+
+//The compressor packed this one into an atlas page; all the entry holds is where
+bool ResourceLoader::decodeAtlasRegion(const TextureHeader& header, DecodedImage* out)
+{
+	AtlasRegion region;
+	bool bOk = out->raw.len >= sizeof(TextureHeader) + sizeof(AtlasRegion);
+	if(bOk)
+	{
+		memcpy(&region, out->raw.data + sizeof(TextureHeader), sizeof(AtlasRegion));
+		bOk = out->raw.len - sizeof(TextureHeader) - sizeof(AtlasRegion) >= region.pathLen;
+	}
+	if(!bOk)
+	{
+		LOG(ERROR) << "Atlas region data truncated";
+		freeData(&out->raw);
+		return false;
+	}
+
+	out->atlas.assign((const char*)out->raw.data + sizeof(TextureHeader) + sizeof(AtlasRegion), region.pathLen);
+	out->atlasX = region.x;
+	out->atlasY = region.y;
+	out->width = header.width;
+	out->height = header.height;
+	out->mode = GL_RGBA;
+	freeData(&out->raw);
+	return true;
+}
+
+uint64_t ResourceLoader::contentID(uint64_t id)
+{
+	return m_pakLoader->getContentID(id);
+}
+
+Image* ResourceLoader::imageFromDecoded(const string& sID, uint64_t id, DecodedImage* decoded, bool bDecoded)
+{
+	Image* img = m_cache->findImage(contentID(id));	//Someone else may have beaten us to it
+	if(img)
+		return img;
+
+	if(!bDecoded)
+		img = new Image(sID);	//Same as always; logs the error and gives us an empty image
+	else if(decoded->atlas.size())
+	{
+		//Usually cached already, since recorded manifests list the page along with the images on it
+		Image* atlas = getImage(decoded->atlas);
+		img = new Image(atlas, decoded->atlasX, decoded->atlasY, decoded->width, decoded->height);
 	}
 	else
-		LOG(TRACE) << "Cache hit" << sID;
+	{
+		img = new Image(decoded->pixels, decoded->width, decoded->height, decoded->mode);
+		if(decoded->stbiPixels)
+			img->_setFilename(sID);	//Loaded from a loose file, so it can be reloaded from there
+	}
+	m_cache->addImage(contentID(id), img);
 	return img;
 }
 
-Mesh3D* ResourceLoader::getMesh(string sID)
+Image* ResourceLoader::getImage(const string& sID)
 {
-	LOG(TRACE) << "Loading 3D object " << sID;
-	uint64_t hashVal = hash(sID);
-	LOG(TRACE) << "Mesh has ID " << hashVal;
-	Mesh3D* mesh = m_cache->findMesh(hashVal);
-	if(!mesh)	//This mesh isn't here; load it
+	return getImage(ResourceHash::hash(sID), sID.c_str());
+}
+
+Image* ResourceLoader::getImage(uint64_t id, const char* cID)
+{
+	record(MANIFEST_IMAGE, id, cID);
+	Image* img = m_cache->findImage(contentID(id));
+	if(!img)	//This image isn't here; load it
 	{
-		LOG(TRACE) << "Cache miss";
-		unsigned int len = 0;
-		unsigned char* resource = m_pakLoader->loadResource(hashVal, &len);
-		if(!resource || !len)
-		{
-			LOG(TRACE) << "Pak miss - load from file";
-			mesh = new Mesh3D(sID);				//Create this mesh
-			m_cache->addMesh(hashVal, mesh);	//Add to the cache
-		}
-		else
-		{
-			LOG(TRACE) << "Pak hit - load from data";
-			mesh = new Mesh3D(resource, len);
-			m_cache->addMesh(hashVal, mesh);
-			free(resource);						//Free memory
-		}
+		string sID(cID);
+		LOG(TRACE) << "Cache miss - loading image " << sID << " with ID " << id;
+		DecodedImage decoded = DecodedImage();
+		bool bDecoded = decodeImage(sID, id, &decoded, scratchArena());	//Uploaded right away, so it doesn't need to outlive this
+		img = imageFromDecoded(sID, id, &decoded, bDecoded);
+		freeImage(&decoded);
+		scratchArena()->reset();
+	}
+	return img;
+}
+
+bool ResourceLoader::decodeMesh(const string& sID, uint64_t id, ResourceData* out)
+{
+	//OBJ files are parsed straight into OpenGL; only tiny3d data can be loaded ahead of time
+	bool bOBJ = sID.find(".obj", sID.size() - 4) != string::npos;
+	return loadData(sID, id, out, !bOBJ, MESH_DATA_ALIGNMENT);
+}
+
+Mesh3D* ResourceLoader::meshFromDecoded(const string& sID, uint64_t id, ResourceData* decoded, bool bDecoded)
+{
+	Mesh3D* mesh = m_cache->findMesh(contentID(id));
+	if(mesh)
+		return mesh;
+
+	if(!bDecoded)
+	{
+		LOG(TRACE) << "Pak miss - load from file";
+		mesh = new Mesh3D(sID);
 	}
 	else
-		LOG(TRACE) << "Cache hit " << sID;
+	{
+		LOG(TRACE) << "Pak hit - load from data";
+		mesh = new Mesh3D(decoded->data, decoded->len);
+	}
+	m_cache->addMesh(contentID(id), mesh);
 	return mesh;
 }
 
-//Particle system
-ParticleSystem* ResourceLoader::getParticleSystem(string sID)
+Mesh3D* ResourceLoader::getMesh(const string& sID)
 {
-	ParticleSystem* ps = new ParticleSystem();
-	LOG(INFO) << "Loading particle system " << sID;
-	ps->_initValues();
+	return getMesh(ResourceHash::hash(sID), sID.c_str());
+}
+
+Mesh3D* ResourceLoader::getMesh(uint64_t id, const char* cID)
+{
+	record(MANIFEST_MESH, id, cID);
+	Mesh3D* mesh = m_cache->findMesh(contentID(id));
+	if(!mesh)	//This mesh isn't here; load it
+	{
+		string sID(cID);
+		LOG(TRACE) << "Cache miss - loading 3D object " << sID << " with ID " << id;
+		//Loose files take the old Mesh3D(filename) path so they can be reloaded
+		ResourceData decoded;
+		bool bDecoded = loadData(sID, id, &decoded, false, MESH_DATA_ALIGNMENT, scratchArena());
+		mesh = meshFromDecoded(sID, id, &decoded, bDecoded);
+		freeData(&decoded);
+		scratchArena()->reset();
+	}
+	return mesh;
+}
 
-	tinyxml2::XMLDocument* doc = new tinyxml2::XMLDocument();
+//Pak data is either a compiled record, or XML text from a pak built before those. Pak misses read
+// the loose XML file.
+template<class Def> bool ResourceLoader::loadDef(const string& sID, uint64_t id, Def* def)
+{
+	tinyxml2::XMLDocument doc;
 
-	//Load file
-	uint64_t hashVal = hash(sID);
-	//TODO Check cache first
-	unsigned int len = 0;
-	unsigned char* resource = m_pakLoader->loadResource(hashVal, &len);
+	ResourceData data;
 	int iErr;
-	if(!resource || !len)
+	if(!loadData(sID, id, &data, false, 1, scratchArena()))
 	{
 		LOG(TRACE) << "Pak miss";
-		iErr = doc->LoadFile(sID.c_str());
+		iErr = doc.LoadFile(sID.c_str());
+	}
+	else if(CompiledXML::isCompiled(data.data, data.len))
+	{
+		LOG(TRACE) << "Loading compiled XML from pak";
+		bool bOk = CompiledXML::read(data.data, data.len, def);
+		freeData(&data);
+		scratchArena()->reset();
+		if(!bOk)
+			LOG(ERROR) << "Error reading compiled XML " << sID;
+		return bOk;
 	}
 	else
 	{
 		LOG(TRACE) << "Loading from pak";
-		iErr = doc->Parse((const char*)resource, len);
-		free(resource);
+		iErr = doc.Parse((const char*)data.data, data.len);	//Parse() takes a copy
+		freeData(&data);
+		scratchArena()->reset();
 	}
-	
+
 	if(iErr != tinyxml2::XML_NO_ERROR)
 	{
 		LOG(ERROR) << "Error parsing XML file " << sID << ": Error " << iErr;
-		delete doc;
-		delete ps;
-		return NULL;
+		return false;
 	}
+	return CompiledXML::fromXML(&doc, sID, def);
+}
 
-	ps->m_sXMLFrom = sID;
+//Particle system
+ParticleSystem* ResourceLoader::getParticleSystem(const string& sID)
+{
+	return getParticleSystem(ResourceHash::hash(sID), sID.c_str());
+}
 
-	tinyxml2::XMLElement* root = doc->FirstChildElement("particlesystem");
-	if(root == NULL)
-	{
-		LOG(ERROR) << "Error: No toplevel \"particlesystem\" item in XML file " << sID;
-		delete doc;
-		delete ps;
+ParticleSystem* ResourceLoader::getParticleSystem(uint64_t id, const char* cID)
+{
+	record(MANIFEST_PARTICLESYSTEM, id, cID);
+	const ParticleSystem* tmpl = particleTemplate(id, cID, NULL);
+	if(!tmpl)
 		return NULL;
+	return tmpl->clone();
+}
+
+const ParticleSystem* ResourceLoader::particleTemplate(uint64_t id, const string& sID, const ParticleSystemDef* def)
+{
+	map<uint64_t, ParticleSystem*>::iterator i = m_particleTemplates.find(id);
+	if(i != m_particleTemplates.end())
+		return i->second;
+
+	//Not parsed yet; load it unless we've been handed it already
+	LOG(INFO) << "Loading particle system " << sID;
+	ParticleSystemDef loaded;
+	if(!def)
+	{
+		if(!loadDef(sID, id, &loaded))
+			return NULL;
+		def = &loaded;
 	}
 
-	const char* emfrom = root->Attribute("emitfrom");
-	if(emfrom != NULL)
-		ps->emitFrom.fromString(emfrom);
-	const char* emfromvel = root->Attribute("emitfromvel");
-	if(emfromvel != NULL)
-		ps->emissionVel = pointFromString(emfromvel);
+	ParticleSystem* tmpl = particleSystemFromDef(sID, *def);
+	m_particleTemplates[id] = tmpl;
+	return tmpl;
+}
+
+void ResourceLoader::clearParticleTemplates()
+{
+	for(map<uint64_t, ParticleSystem*>::iterator i = m_particleTemplates.begin(); i != m_particleTemplates.end(); i++)
+		delete i->second;	//Releases their images
+	m_particleTemplates.clear();
+}
 
-	root->QueryBoolAttribute("fireonstart", &ps->firing);
-//	root->QueryBoolAttribute("changecolor", &ps->changeColor);
+ParticleSystem* ResourceLoader::particleSystemFromDef(const string& sID, const ParticleSystemDef& def)
+{
+	ParticleSystem* ps = new ParticleSystem();
+	ps->_initValues();
+	ps->m_sXMLFrom = sID;
 
-	const char* blendmode = root->Attribute("blend");
-	if(blendmode != NULL)
+	if(def.mask & PS_EMITFROM)
+		ps->emitFrom = Rect(def.emitFrom[0], def.emitFrom[1], def.emitFrom[2], def.emitFrom[3]);
+	if(def.mask & PS_EMITFROMVEL)
+		ps->emissionVel = Vec2(def.emitFromVel[0], def.emitFromVel[1]);
+	if(def.mask & PS_FIREONSTART)
+		ps->firing = def.fireOnStart;
+	if(def.mask & PS_BLEND)
 	{
-		string sMode = blendmode;
-		if(sMode == "additive")
+		if(def.blend == PARTICLE_BLEND_ADDITIVE)
 			ps->blend = ADDITIVE;
-		else if(sMode == "normal")
-			ps->blend = NORMAL;
-		if(sMode == "subtractive")
+		else if(def.blend == PARTICLE_BLEND_SUBTRACTIVE)
 			ps->blend = SUBTRACTIVE;
+		else
+			ps->blend = NORMAL;
 	}
+	if(def.mask & PS_MAX)
+		ps->max = def.max;
+	if(def.mask & PS_RATE)
+		ps->rate = def.rate;
+	if(def.mask & PS_DECAY)
+		ps->decay = def.decay;
+	ps->decayVar = def.decayVar;	//Applied per system by clone()
+
+	if(def.mask & PS_IMG)
+		ps->img = getImage(def.img);
+	for(unsigned int i = 0; i + 4 <= def.imgRects.size(); i += 4)
+		ps->imgRect.push_back(Rect(def.imgRects[i], def.imgRects[i+1], def.imgRects[i+2], def.imgRects[i+3]));
+
+	if(def.mask & PS_EMITANGLE)
+		ps->emissionAngle = def.emitAngle;
+	if(def.mask & PS_EMITANGLEVAR)
+		ps->emissionAngleVar = def.emitAngleVar;
+	if(def.mask & PS_SIZESTART)
+		ps->sizeStart = Vec2(def.sizeStart[0], def.sizeStart[1]);
+	if(def.mask & PS_SIZEEND)
+		ps->sizeEnd = Vec2(def.sizeEnd[0], def.sizeEnd[1]);
+	if(def.mask & PS_SIZEVAR)
+		ps->sizeVar = def.sizeVar;
+	if(def.mask & PS_SPEED)
+		ps->speed = def.speed;
+	if(def.mask & PS_SPEEDVAR)
+		ps->speedVar = def.speedVar;
+	if(def.mask & PS_ACCEL)
+		ps->accel = Vec2(def.accel[0], def.accel[1]);
+	if(def.mask & PS_ACCELVAR)
+		ps->accelVar = Vec2(def.accelVar[0], def.accelVar[1]);
+	if(def.mask & PS_ROTSTART)
+		ps->rotStart = def.rotStart;
+	if(def.mask & PS_ROTSTARTVAR)
+		ps->rotStartVar = def.rotStartVar;
+	if(def.mask & PS_ROTVEL)
+		ps->rotVel = def.rotVel;
+	if(def.mask & PS_ROTVELVAR)
+		ps->rotVelVar = def.rotVelVar;
+	if(def.mask & PS_ROTACCEL)
+		ps->rotAccel = def.rotAccel;
+	if(def.mask & PS_ROTACCELVAR)
+		ps->rotAccelVar = def.rotAccelVar;
+	if(def.mask & PS_ROTAXIS)
+		ps->rotAxis = Vec3(def.rotAxis[0], def.rotAxis[1], def.rotAxis[2]);
+	if(def.mask & PS_ROTAXISVAR)
+		ps->rotAxisVar = Vec3(def.rotAxisVar[0], def.rotAxisVar[1], def.rotAxisVar[2]);
+	if(def.mask & PS_COLSTART)
+		ps->colStart.set(def.colStart[0], def.colStart[1], def.colStart[2], def.colStart[3]);
+	if(def.mask & PS_COLEND)
+		ps->colEnd.set(def.colEnd[0], def.colEnd[1], def.colEnd[2], def.colEnd[3]);
+	if(def.mask & PS_COLVAR)
+		ps->colVar.set(def.colVar[0], def.colVar[1], def.colVar[2], def.colVar[3]);
+	if(def.mask & PS_TANACCEL)
+		ps->tangentialAccel = def.tanAccel;
+	if(def.mask & PS_TANACCELVAR)
+		ps->tangentialAccelVar = def.tanAccelVar;
+	if(def.mask & PS_NORMACCEL)
+		ps->normalAccel = def.normAccel;
+	if(def.mask & PS_NORMACCELVAR)
+		ps->normalAccelVar = def.normAccelVar;
+	if(def.mask & PS_LIFE)
+		ps->lifetime = def.life;
+	if(def.mask & PS_LIFEVAR)
+		ps->lifetimeVar = def.lifeVar;
+	if(def.mask & PS_PREFADE)
+		ps->lifetimePreFade = def.preFade;
+	if(def.mask & PS_PREFADEVAR)
+		ps->lifetimePreFadeVar = def.preFadeVar;
+
+	ps->spawnOnDeath = def.spawnOnDeath;
 
-	root->QueryUnsignedAttribute("max", &ps->max);
-	root->QueryFloatAttribute("rate", &ps->rate);
-//	root->QueryBoolAttribute("velrotate", &ps->velRotate);
-	root->QueryFloatAttribute("decay", &ps->decay);
-	float fDecayVar = 0.0f;
-	root->QueryFloatAttribute("decayvar", &fDecayVar);
-	ps->decay += Random::randomFloat(-fDecayVar, fDecayVar);
+	return ps;
+}
+
+ResourceRequest* ResourceLoader::request(ResourceType type, const string& sID)
+{
+	ResourceRequest* req = new ResourceRequest(this, type, sID, ResourceHash::hash(sID));
+	m_requests.insert(req);
 
-	for(tinyxml2::XMLElement* elem = root->FirstChildElement(); elem != NULL; elem = elem->NextSiblingElement())
+	switch(type)
 	{
-		string sName = elem->Name();
-		if(sName == "img")
-		{
-			const char* cPath = elem->Attribute("path");
-			if(cPath != NULL)
-			{
-				ps->img = getImage(cPath);
-				for(tinyxml2::XMLElement* rect = elem->FirstChildElement("rect"); rect != NULL; rect = rect->NextSiblingElement("rect"))
-				{
-					const char* cVal = rect->Attribute("val");
-					if(cVal != NULL)
-					{
-						Rect rc;
-						rc.fromString(cVal);
-						ps->imgRect.push_back(rc);
-					}
-				}
-			}
-		}
-		else if(sName == "emit")
-		{
-			elem->QueryFloatAttribute("angle", &ps->emissionAngle);
-			elem->QueryFloatAttribute("var", &ps->emissionAngleVar);
-		}
-		else if(sName == "size")
-		{
-			const char* cStart = elem->Attribute("start");
-			if(cStart != NULL)
-				ps->sizeStart = pointFromString(cStart);
-			const char* cEnd = elem->Attribute("end");
-			if(cEnd != NULL)
-				ps->sizeEnd = pointFromString(cEnd);
-			elem->QueryFloatAttribute("var", &ps->sizeVar);
-		}
-		else if(sName == "speed")
-		{
-			elem->QueryFloatAttribute("value", &ps->speed);
-			elem->QueryFloatAttribute("var", &ps->speedVar);
-		}
-		else if(sName == "accel")
-		{
-			const char* cAccel = elem->Attribute("value");
-			if(cAccel != NULL)
-				ps->accel = pointFromString(cAccel);
-			const char* cAccelVar = elem->Attribute("var");
-			if(cAccelVar != NULL)
-				ps->accelVar = pointFromString(cAccelVar);
-		}
-		else if(sName == "rotstart")
-		{
-			elem->QueryFloatAttribute("value", &ps->rotStart);
-			elem->QueryFloatAttribute("var", &ps->rotStartVar);
-		}
-		else if(sName == "rotvel")
-		{
-			elem->QueryFloatAttribute("value", &ps->rotVel);
-			elem->QueryFloatAttribute("var", &ps->rotVelVar);
-		}
-		else if(sName == "rotaccel")
-		{
-			elem->QueryFloatAttribute("value", &ps->rotAccel);
-			elem->QueryFloatAttribute("var", &ps->rotAccelVar);
-		}
-		else if(sName == "rotaxis")
-		{
-			const char* cAxis = elem->Attribute("value");
-			if(cAxis && strlen(cAxis))
-				ps->rotAxis = vec3FromString(cAxis);
-			const char* cAxisVar = elem->Attribute("var");
-			if(cAxisVar && strlen(cAxisVar))
-				ps->rotAxisVar = vec3FromString(cAxisVar);
-		}
-		else if(sName == "col")
-		{
-			const char* cStartCol = elem->Attribute("start");
-			if(cStartCol != NULL)
-				ps->colStart.fromString(cStartCol);
-			const char* cEndCol = elem->Attribute("end");
-			if(cEndCol != NULL)
-				ps->colEnd.fromString(cEndCol);
-			const char* cColVar = elem->Attribute("var");
-			if(cColVar != NULL)
-				ps->colVar.fromString(cColVar);
-		}
-		else if(sName == "tanaccel")
-		{
-			elem->QueryFloatAttribute("value", &ps->tangentialAccel);
-			elem->QueryFloatAttribute("var", &ps->tangentialAccelVar);
-		}
-		else if(sName == "normaccel")
+		case RESOURCE_IMAGE:
+			record(MANIFEST_IMAGE, req->m_id, sID.c_str());
+			break;
+		case RESOURCE_MESH:
+			record(MANIFEST_MESH, req->m_id, sID.c_str());
+			break;
+		case RESOURCE_PARTICLESYSTEM:
+			record(MANIFEST_PARTICLESYSTEM, req->m_id, sID.c_str());
+			break;
+		case RESOURCE_OBJECT:
+			record(MANIFEST_OBJECT, req->m_id, sID.c_str());
+			break;
+		case RESOURCE_SCENE:
+			break;
+	}
+
+	//Already cached; nothing to do in the background
+	if(type == RESOURCE_IMAGE)
+		req->m_img = m_cache->findImage(contentID(req->m_id));
+	else if(type == RESOURCE_MESH)
+		req->m_mesh = m_cache->findMesh(contentID(req->m_id));
+	else if(type == RESOURCE_PARTICLESYSTEM)
+	{
+		map<uint64_t, ParticleSystem*>::iterator i = m_particleTemplates.find(req->m_id);
+		if(i != m_particleTemplates.end())
+			req->m_ps = i->second->clone();
+	}
+	else if(type == RESOURCE_OBJECT)
+		req->m_bDone = m_objPrototypes.count(req->m_id) > 0;
+	if(req->m_img || req->m_mesh || req->m_ps)
+		req->m_bDone = true;
+	if(req->m_bDone)
+		return req;
+
+	m_pool->addJob(req);
+	return req;
+}
+
+ResourceRequest* ResourceLoader::requestImage(const string& sID)
+{
+	return request(RESOURCE_IMAGE, sID);
+}
+
+ResourceRequest* ResourceLoader::requestMesh(const string& sID)
+{
+	return request(RESOURCE_MESH, sID);
+}
+
+ResourceRequest* ResourceLoader::requestParticleSystem(const string& sID)
+{
+	return request(RESOURCE_PARTICLESYSTEM, sID);
+}
+
+ResourceRequest* ResourceLoader::requestObject(const string& sXMLFilename)
+{
+	return request(RESOURCE_OBJECT, sXMLFilename);
+}
+
+ResourceRequest* ResourceLoader::requestScene(const string& sID)
+{
+	return request(RESOURCE_SCENE, sID);
+}
+
+void ResourceLoader::releaseRequest(ResourceRequest* req)
+{
+	if(!req)
+		return;
+
+	//Not started yet; just drop it. Otherwise, let update() clean it up once the worker's done
+	if(!req->m_bDone && !m_pool->removeJob(req))
+	{
+		req->m_bReleased = true;
+		return;
+	}
+
+	m_requests.erase(req);
+	delete req;
+}
+
+//Runs on a worker thread. Anything that doesn't decode here is loaded as usual when the prototype's built
+void ResourceLoader::decodeObjectResources(ResourceRequest* req)
+{
+	vector<string> images, meshes;
+	const ObjectDef& def = *req->m_objDef;
+	for(vector<ObjSegmentDef>::const_iterator i = def.segments.begin(); i != def.segments.end(); i++)
+	{
+		if(!i->bLayer)
+			continue;
+		if(i->layer.mask & LAYER_IMG)
+			images.push_back(i->layer.img);
+		if(i->layer.mask & LAYER_OBJ)
+			meshes.push_back(i->layer.obj);
+	}
+	if(!def.lattice.img.empty())
+		images.push_back(def.lattice.img);
+
+	for(vector<string>::iterator i = images.begin(); i != images.end(); i++)
+	{
+		if(find(req->m_sImageIDs.begin(), req->m_sImageIDs.end(), *i) != req->m_sImageIDs.end())
+			continue;
+		DecodedImage decoded = DecodedImage();
+		if(decodeImage(*i, ResourceHash::hash(*i), &decoded))
 		{
-			elem->QueryFloatAttribute("value", &ps->normalAccel);
-			elem->QueryFloatAttribute("var", &ps->normalAccelVar);
+			req->m_decodedImages.push_back(decoded);
+			req->m_sImageIDs.push_back(*i);
 		}
-		else if(sName == "life")
+	}
+	for(vector<string>::iterator i = meshes.begin(); i != meshes.end(); i++)
+	{
+		if(find(req->m_sMeshIDs.begin(), req->m_sMeshIDs.end(), *i) != req->m_sMeshIDs.end())
+			continue;
+		ResourceData decoded;
+		if(decodeMesh(*i, ResourceHash::hash(*i), &decoded))
 		{
-			elem->QueryFloatAttribute("value", &ps->lifetime);
-			elem->QueryFloatAttribute("var", &ps->lifetimeVar);
-			elem->QueryFloatAttribute("prefade", &ps->lifetimePreFade);
-			elem->QueryFloatAttribute("prefadevar", &ps->lifetimePreFadeVar);
+			req->m_decodedMeshes.push_back(decoded);
+			req->m_sMeshIDs.push_back(*i);
 		}
-		else if(sName == "spawnondeath")
+	}
+}
+
+//Runs on a worker thread
+void ResourceLoader::decodeRequest(ResourceRequest* req)
+{
+	switch(req->m_type)
+	{
+		case RESOURCE_IMAGE:
+			req->m_bDecoded = decodeImage(req->m_sID, req->m_id, &req->m_decodedImage);
+			break;
+
+		case RESOURCE_MESH:
+			req->m_bDecoded = decodeMesh(req->m_sID, req->m_id, &req->m_decodedMesh);
+			break;
+
+		case RESOURCE_PARTICLESYSTEM:
 		{
-//			const char* cDeathSpawnType = elem->Attribute("deathspawntype");
-//			if(cDeathSpawnType && strlen(cDeathSpawnType))
-//			{
-//				string sDeathSpawntype = cDeathSpawnType;
-//				if(sDeathSpawntype == "system")
-//					ps->particleDeathSpawn = false;
-//				else if(sDeathSpawntype == "particle")
-//					ps->particleDeathSpawn = true;
-//			}
-
-			for(tinyxml2::XMLElement* particle = elem->FirstChildElement("particle"); particle != NULL; particle = particle->NextSiblingElement("particle"))
+			req->m_psDef = new ParticleSystemDef;
+			if(!loadDef(req->m_sID, req->m_id, req->m_psDef))
+			{
+				delete req->m_psDef;
+				req->m_psDef = NULL;
+				break;
+			}
+
+			//Decode the particle system's image while we're here, so the main thread only has to upload it
+			if(req->m_psDef->mask & PS_IMG)
 			{
-				const char* cPath = particle->Attribute("path");
-				if(cPath != NULL)
-					ps->spawnOnDeath.push_back(cPath);
+				req->m_sImageID = req->m_psDef->img;
+				req->m_bDecoded = decodeImage(req->m_sImageID, ResourceHash::hash(req->m_sImageID), &req->m_decodedImage);
 			}
+			break;
 		}
-		else
-			LOG(WARNING) << "Warning: Unknown element type \"" << sName << "\" found in XML file " << sID << ". Ignoring...";
-	}
 
-	delete doc;
-	ps->init();
+		case RESOURCE_OBJECT:
+			req->m_objDef = new ObjectDef;
+			if(!loadDef(req->m_sID, req->m_id, req->m_objDef))
+			{
+				delete req->m_objDef;
+				req->m_objDef = NULL;
+				break;
+			}
+			decodeObjectResources(req);
+			break;
+
+		case RESOURCE_SCENE:
+			req->m_sceneDef = new SceneDef;
+			if(!loadDef(req->m_sID, req->m_id, req->m_sceneDef))
+			{
+				delete req->m_sceneDef;
+				req->m_sceneDef = NULL;
+			}
+			break;
+	}
 
-	return ps;
+	SDL_LockMutex(m_decodedMutex);
+	m_decoded.push_back(req);
+	SDL_UnlockMutex(m_decodedMutex);
 }
 
-MouseCursor* ResourceLoader::getCursor(string sID)
+void ResourceLoader::finishRequest(ResourceRequest* req)
 {
-	MouseCursor* cur = new MouseCursor();
-	cur->_init();
-
-	tinyxml2::XMLDocument* doc = new tinyxml2::XMLDocument();
-
-	uint64_t hashVal = hash(sID);
-	//TODO Check cache first
-	unsigned int len = 0;
-	unsigned char* resource = m_pakLoader->loadResource(hashVal, &len);
-	int iErr;
-	if(!resource || !len)
-	{
-		LOG(TRACE) << "Pak miss";
-		iErr = doc->LoadFile(sID.c_str());
-	}
-	else
+	if(req->m_bReleased)
 	{
-		LOG(TRACE) << "loading from pak";
-		iErr = doc->Parse((const char*)resource, len);
-		free(resource);
+		m_requests.erase(req);
+		delete req;
+		return;
 	}
 
-	if(iErr != tinyxml2::XML_NO_ERROR)
+	switch(req->m_type)
 	{
-		LOG(ERROR) << "Error parsing XML file " << sID << ": Error " << iErr;
-		delete doc;
-		return cur;
+		case RESOURCE_IMAGE:
+			req->m_img = imageFromDecoded(req->m_sID, req->m_id, &req->m_decodedImage, req->m_bDecoded);
+			break;
+
+		case RESOURCE_MESH:
+			req->m_mesh = meshFromDecoded(req->m_sID, req->m_id, &req->m_decodedMesh, req->m_bDecoded);
+			break;
+
+		case RESOURCE_PARTICLESYSTEM:
+		{
+			Image* img = NULL;
+			if(req->m_bDecoded)
+				img = imageFromDecoded(req->m_sImageID, ResourceHash::hash(req->m_sImageID), &req->m_decodedImage, true);	//So the particle system finds it in the cache
+			if(req->m_psDef)
+			{
+				const ParticleSystem* tmpl = particleTemplate(req->m_id, req->m_sID, req->m_psDef);
+				if(tmpl)
+					req->m_ps = tmpl->clone();
+			}
+			if(img)
+				img->release();	//The particle system has its own use of it
+			req->m_bFailed = !req->m_ps;
+			break;
+		}
+
+		case RESOURCE_OBJECT:
+		{
+			//Upload what the worker decoded, so the prototype finds it all in the cache
+			vector<Image*> imgs;
+			vector<Mesh3D*> meshes;
+			for(unsigned int i = 0; i < req->m_decodedImages.size(); i++)
+				imgs.push_back(imageFromDecoded(req->m_sImageIDs[i], ResourceHash::hash(req->m_sImageIDs[i]), &req->m_decodedImages[i], true));
+			for(unsigned int i = 0; i < req->m_decodedMeshes.size(); i++)
+				meshes.push_back(meshFromDecoded(req->m_sMeshIDs[i], ResourceHash::hash(req->m_sMeshIDs[i]), &req->m_decodedMeshes[i], true));
+
+			if(req->m_objDef && !m_objPrototypes.count(req->m_id))
+				m_objPrototypes[req->m_id] = objectPrototypeFromDef(*req->m_objDef);
+
+			//The prototype has its own uses of these
+			for(vector<Image*>::iterator i = imgs.begin(); i != imgs.end(); i++)
+				(*i)->release();
+			for(vector<Mesh3D*>::iterator i = meshes.begin(); i != meshes.end(); i++)
+				(*i)->release();
+			req->m_bFailed = !req->m_objDef;
+			break;
+		}
+
+		case RESOURCE_SCENE:
+			req->m_bFailed = !req->m_sceneDef;
+			break;
 	}
 
-	tinyxml2::XMLElement* root = doc->FirstChildElement("cursor");
-	if(root == NULL)
+	//Done with the intermediate data
+	freeImage(&req->m_decodedImage);
+	freeData(&req->m_decodedMesh);
+	delete req->m_psDef;
+	req->m_psDef = NULL;
+	delete req->m_objDef;
+	req->m_objDef = NULL;
+	for(vector<DecodedImage>::iterator i = req->m_decodedImages.begin(); i != req->m_decodedImages.end(); i++)
+		freeImage(&(*i));
+	for(vector<ResourceData>::iterator i = req->m_decodedMeshes.begin(); i != req->m_decodedMeshes.end(); i++)
+		freeData(&(*i));
+	req->m_decodedImages.clear();
+	req->m_decodedMeshes.clear();
+	req->m_bDone = true;
+}
+
+void ResourceLoader::update(float fBudgetMs)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	Uint64 budget = (Uint64)(fBudgetMs * (double)SDL_GetPerformanceFrequency() / 1000.0);
+
+	while(true)
 	{
-		LOG(ERROR) << "Error: No toplevel \"cursor\" item in XML file " << sID;
-		delete doc;
-		return cur;
+		SDL_LockMutex(m_decodedMutex);
+		if(m_decoded.empty())
+		{
+			SDL_UnlockMutex(m_decodedMutex);
+			break;
+		}
+		ResourceRequest* req = m_decoded.front();
+		m_decoded.pop_front();
+		SDL_UnlockMutex(m_decodedMutex);
+
+		finishRequest(req);
+
+		if(SDL_GetPerformanceCounter() - start >= budget)
+			break;
 	}
 
-	const char* cImgPath = root->Attribute("path");
-	if(cImgPath)
-		cur->img = getImage(cImgPath);	//TODO REMOVE
+	m_cache->trim();	//Drop whatever's gone unused since last frame, if we're over budget
+}
 
-	const char* cSize = root->Attribute("size");
-	if(cSize)
-		cur->size = pointFromString(cSize);
+void ResourceLoader::setCacheBudget(uint64_t textureBytes, uint64_t meshBytes)
+{
+	m_cache->setBudget(textureBytes, meshBytes);
+}
 
-	const char* cHotSpot = root->Attribute("hotspot");
-	if(cHotSpot)
-		cur->hotSpot = pointFromString(cHotSpot);
+uint64_t ResourceLoader::getTextureMemory()
+{
+	return m_cache->getTextureBytes();
+}
 
-	delete doc;
-	return cur;
+uint64_t ResourceLoader::getMeshMemory()
+{
+	return m_cache->getMeshBytes();
 }
 
-ObjSegment* ResourceLoader::getObjSegment(tinyxml2::XMLElement* layer)
+void ResourceLoader::flush()
 {
-	ObjSegment* seg = new ObjSegment();
+	m_pool->wait();
+	SDL_LockMutex(m_decodedMutex);
+	list<ResourceRequest*> decoded;
+	decoded.swap(m_decoded);
+	SDL_UnlockMutex(m_decodedMutex);
+
+	for(list<ResourceRequest*>::iterator i = decoded.begin(); i != decoded.end(); i++)
+		finishRequest(*i);
+}
 
-	const char* cLayerFilename = layer->Attribute("img");
-	if(cLayerFilename != NULL)
-		seg->img = getImage(cLayerFilename);	//TODO REMOVE
+MouseCursor* ResourceLoader::getCursor(const string& sID)
+{
+	MouseCursor* cur = new MouseCursor();
+	cur->_init();
 
-	const char* cSegPos = layer->Attribute("pos");
-	if(cSegPos != NULL)
-		seg->pos = pointFromString(cSegPos);
+	//TODO Check cache first
+	CursorDef def;
+	if(!loadDef(sID, ResourceHash::hash(sID), &def))
+		return cur;
 
-	const char* cSegTile = layer->Attribute("tile");
-	if(cSegTile != NULL)
-		seg->tile = pointFromString(cSegTile);
+	if(def.mask & CURSOR_IMG)
+		cur->img = getImage(def.img);	//TODO REMOVE
+	if(def.mask & CURSOR_SIZE)
+		cur->size = Vec2(def.size[0], def.size[1]);
+	if(def.mask & CURSOR_HOTSPOT)
+		cur->hotSpot = Vec2(def.hotSpot[0], def.hotSpot[1]);
 
-	layer->QueryFloatAttribute("rot", &seg->rot);
-	layer->QueryFloatAttribute("depth", &seg->depth);
+	return cur;
+}
 
-	const char* cSegSz = layer->Attribute("size");
-	if(cSegSz != NULL)
-		seg->size = pointFromString(cSegSz);
+bool ResourceLoader::getScene(const string& sID, SceneDef* out)
+{
+	return loadDef(sID, ResourceHash::hash(sID), out);
+}
 
-	const char* cSegCol = layer->Attribute("col");
-	if(cSegCol != NULL)
-		seg->col.fromString(cSegCol);
+ObjSegment* ResourceLoader::objSegmentFromDef(const ObjLayerDef& layer)
+{
+	ObjSegment* seg = new ObjSegment();
 
-	const char* cSegObj = layer->Attribute("obj");
-	if(cSegObj != NULL)
-		seg->obj3D = getMesh(cSegObj);
+	if(layer.mask & LAYER_IMG)
+		seg->img = getImage(layer.img);	//TODO REMOVE
+	if(layer.mask & LAYER_POS)
+		seg->pos = Vec2(layer.pos[0], layer.pos[1]);
+	if(layer.mask & LAYER_TILE)
+		seg->tile = Vec2(layer.tile[0], layer.tile[1]);
+	if(layer.mask & LAYER_ROT)
+		seg->rot = layer.rot;
+	if(layer.mask & LAYER_DEPTH)
+		seg->depth = layer.depth;
+	if(layer.mask & LAYER_SIZE)
+		seg->size = Vec2(layer.size[0], layer.size[1]);
+	if(layer.mask & LAYER_COL)
+		seg->col.set(layer.col[0], layer.col[1], layer.col[2], layer.col[3]);
+	if(layer.mask & LAYER_OBJ)
+		seg->obj3D = getMesh(layer.obj);
 
 	return seg;
 }
 
-Object* ResourceLoader::objFromXML(string sType, Vec2 ptOffset, Vec2 ptVel)
+Object* ResourceLoader::objFromXML(const string& sType, Vec2 ptOffset, Vec2 ptVel)
 {
-	ostringstream oss;
-	oss << "res/obj/" << sType << ".xml";
-	string sXMLFilename = oss.str();
+	//Hash res/obj/<type>.xml piecewise, so a cached prototype doesn't cost a path string
+	uint64_t id = ResourceHash::hash(".xml", ResourceHash::hash(sType.c_str(), RES_ID("res/obj/")));
+	const ObjectPrototype* proto = objectPrototype(id, NULL, &sType);
+	if(!proto)
+		return NULL;
+	return proto->instantiate(m_world, ptOffset);
+}
 
-	LOG(INFO) << "Parsing object XML file " << sXMLFilename;
-	//Open file
-	tinyxml2::XMLDocument* doc = new tinyxml2::XMLDocument;
-	
-	uint64_t hashVal = hash(sXMLFilename);
-	//TODO Check cache first
-	unsigned int len = 0;
-	unsigned char* resource = m_pakLoader->loadResource(hashVal, &len);
-	int iErr;
-	if(!resource || !len)
-	{
-		LOG(TRACE) << "Pak miss";
-		iErr = doc->LoadFile(sXMLFilename.c_str());
-	}
+Object* ResourceLoader::objFromXML(uint64_t id, const char* cXMLFilename, Vec2 ptOffset, Vec2 ptVel)
+{
+	const ObjectPrototype* proto = objectPrototype(id, cXMLFilename, NULL);
+	if(!proto)
+		return NULL;
+	return proto->instantiate(m_world, ptOffset);
+}
+
+const ObjectPrototype* ResourceLoader::objectPrototype(uint64_t id, const char* cXMLFilename, const string* sType)
+{
+	map<uint64_t, ObjectPrototype*>::iterator i = m_objPrototypes.find(id);
+	if(i != m_objPrototypes.end() && !m_bRecording)
+		return i->second;
+
+	string sXMLFilename;
+	if(cXMLFilename)
+		sXMLFilename = cXMLFilename;
 	else
-	{
-		LOG(TRACE) << "load from pak";
-		iErr = doc->Parse((const char*)resource, len);
-		free(resource);
-	}
+		sXMLFilename = "res/obj/" + *sType + ".xml";
 
-	if(iErr != tinyxml2::XML_NO_ERROR)
-	{
-		LOG(ERROR) << "Error parsing object XML file: Error " << iErr;
-		delete doc;
-		return NULL;
-	}
+	record(MANIFEST_OBJECT, id, sXMLFilename.c_str());
+	if(i != m_objPrototypes.end())
+		return i->second;
 
-	//Grab root element
-	tinyxml2::XMLElement* root = doc->RootElement();
-	if(root == NULL)
-	{
-		LOG(ERROR) << "Error: Root element NULL in XML file.";
-		delete doc;
+	LOG(INFO) << "Parsing object XML file " << sXMLFilename;
+	ObjectDef def;
+	if(!loadDef(sXMLFilename, id, &def))
 		return NULL;
-	}
 
-	Object* o = new Object;
+	ObjectPrototype* proto = objectPrototypeFromDef(def);
+	m_objPrototypes[id] = proto;
+	return proto;
+}
 
-	const char* cLuaClass = root->Attribute("luaclass");
-	if(cLuaClass != NULL)
-		o->luaClass = cLuaClass;
+ObjectPrototype* ResourceLoader::objectPrototypeFromDef(const ObjectDef& def)
+{
+	ObjectPrototype* proto = new ObjectPrototype;
 
-	map<string, b2Body*> mBodyNames;
+	if(def.bLuaClass)
+		proto->luaClass = def.luaClass;
 
-	//Add segments
-	for(tinyxml2::XMLElement* segment = root->FirstChildElement("segment"); segment != NULL; segment = segment->NextSiblingElement("segment"))
+	for(vector<ObjSegmentDef>::const_iterator i = def.segments.begin(); i != def.segments.end(); i++)
 	{
+		//Start from a segment built the usual way, so anything the XML leaves out gets the same defaults
 		ObjSegment* seg;
-		//TODO Unify this. It looks like we're loading from XML multiple ways
-		tinyxml2::XMLElement* layer = segment->FirstChildElement("layer");
-		if(layer != NULL)
-			seg = getObjSegment(layer);
+		if(i->bLayer)
+			seg = objSegmentFromDef(i->layer);
 		else
 			seg = new ObjSegment;
-		seg->parent = o;
-		tinyxml2::XMLElement* body = segment->FirstChildElement("body");
-		if(body != NULL)
-		{
-			string sBodyName;
-			const char* cBodyName = body->Attribute("name");
-			if(cBodyName)
-				sBodyName = cBodyName;
-
-			Vec2 pos = ptOffset;
-			const char* cBodyPos = body->Attribute("pos");
-			if(cBodyPos)
-			{
-				Vec2 p = pointFromString(cBodyPos);
-				pos.x += p.x;
-				pos.y += p.y;
-			}
-
-			string sBodyType = "dynamic";
-			const char* cBodyType = body->Attribute("type");
-			if(cBodyType)
-				sBodyType = cBodyType;
 
-			b2BodyDef bodyDef;
-
-			if(sBodyType == "dynamic")
+		SegmentPrototype sp;
+		sp.img = seg->img;
+		sp.obj3D = seg->obj3D;
+		sp.pos = seg->pos;
+		sp.tile = seg->tile;
+		sp.rot = seg->rot;
+		sp.depth = seg->depth;
+		sp.size = seg->size;
+		sp.col = seg->col;
+		seg->img = NULL;	//The prototype keeps these uses
+		seg->obj3D = NULL;
+		delete seg;
+
+		sp.bBody = i->bBody;
+		if(i->bBody)
+		{
+			b2BodyDef& bodyDef = sp.bodyDef;
+			if(i->bodyType == BODY_DYNAMIC)
 				bodyDef.type = b2_dynamicBody;
-			else if(sBodyType == "kinematic")
+			else if(i->bodyType == BODY_KINEMATIC)
 				bodyDef.type = b2_kinematicBody;
 			else
 				bodyDef.type = b2_staticBody;
-			bodyDef.position = b2Vec2(pos.x, pos.y);
-
-			bodyDef.linearDamping = 0;
-			body->QueryFloatAttribute("linearDamping", &bodyDef.linearDamping);
-
-			//Fixed rotation (true for sprites, false for physical objects)
-			bodyDef.fixedRotation = false;
-			body->QueryBoolAttribute("fixedrot", &bodyDef.fixedRotation);
-
-			//Create body now
-			b2Body* bod = m_world->CreateBody(&bodyDef);
-			seg->body = bod;
-			bod->SetUserData((void*)seg);	//Store user data, so when collisions occur we know what segments are colliding
-			mBodyNames[sBodyName] = bod;
+			bodyDef.position = b2Vec2(i->bodyPos[0], i->bodyPos[1]);
+			bodyDef.linearDamping = i->linearDamping;
+			bodyDef.fixedRotation = i->fixedRotation;
 
-			//Create body fixtures
-			for(tinyxml2::XMLElement* fixture = body->FirstChildElement("fixture"); fixture != NULL; fixture = fixture->NextSiblingElement("fixture"))
-				readFixture(fixture, bod);
-		}
-		o->addSegment(seg);
-	}
-	//Create joints
-	for(tinyxml2::XMLElement* joint = root->FirstChildElement("joint"); joint != NULL; joint = joint->NextSiblingElement("joint"))
-	{
-		const char* cJointType = joint->Attribute("type");
-		if(cJointType)
-		{
-			string sJointType = cJointType;
-
-			if(sJointType == "distance")
+			for(vector<ObjFixtureDef>::const_iterator j = i->fixtures.begin(); j != i->fixtures.end(); j++)
 			{
-				b2DistanceJointDef jd;
-				const char* cBodyA = joint->Attribute("bodyA");
-				const char* cBodyB = joint->Attribute("bodyB");
-				if(!cBodyA || !cBodyB) continue;
-				if(!mBodyNames.count(cBodyA) || !mBodyNames.count(cBodyB)) continue;
-
-				jd.bodyA = mBodyNames[cBodyA];
-				jd.bodyB = mBodyNames[cBodyB];
-
-				jd.frequencyHz = 2.0f;
-				jd.dampingRatio = 0.0f;
-
-				joint->QueryFloatAttribute("frequencyHz", &jd.frequencyHz);
-				joint->QueryFloatAttribute("dampingRatio", &jd.dampingRatio);
-
-				const char* cAnchorA = joint->Attribute("anchorA");
-				const char* cAnchorB = joint->Attribute("anchorB");
-
-				jd.localAnchorA.Set(0, 0);
-				jd.localAnchorB.Set(0, 0);
-				if(cAnchorA)
-				{
-					Vec2 p = pointFromString(cAnchorA);
-					jd.localAnchorA = b2Vec2(p.x, p.y);
-				}
-				if(cAnchorB)
-				{
-					Vec2 p = pointFromString(cAnchorB);
-					jd.localAnchorB = b2Vec2(p.x, p.y);
-				}
-
-				b2Vec2 p1, p2, d;
-				p1 = jd.bodyA->GetWorldPoint(jd.localAnchorA);
-				p2 = jd.bodyB->GetWorldPoint(jd.localAnchorB);
-				d = p2 - p1;
-				jd.length = d.Length();
-
-				m_world->CreateJoint(&jd);
+				b2FixtureDef fixtureDef;
+				if(fixtureFromDef(*j, &fixtureDef))
+					sp.fixtures.push_back(fixtureDef);
 			}
-			//else TODO
 		}
+		proto->segments.push_back(sp);
 	}
 
-
-	tinyxml2::XMLElement* latticeElem = root->FirstChildElement("lattice");
-	if(latticeElem)
+	for(vector<ObjJointDef>::const_iterator i = def.joints.begin(); i != def.joints.end(); i++)
 	{
-		const char* cMeshImg = latticeElem->Attribute("img");
-		const char* cBodyRes = latticeElem->Attribute("resolution");
-		const char* cMeshImgSize = latticeElem->Attribute("size");
-
-		//Default lattice resolution = 10, 10
-		Vec2 pMeshSize(10, 10);
-
-		if(cMeshImg && cMeshImgSize)
-		{
-			o->img = getImage(cMeshImg);
-			o->meshSize = pointFromString(cMeshImgSize);
-
-			const char* cLatticeType = latticeElem->Attribute("type");
-			if(cLatticeType)
-			{
-				if(cBodyRes)
-					pMeshSize = pointFromString(cBodyRes);
-
-				o->meshLattice = new Lattice((int)pMeshSize.x, (int)pMeshSize.y);
-
-				string sLatticeType = cLatticeType;
-				if(sLatticeType == "softbody")
-				{
-					const char* cBodyCenter = latticeElem->Attribute("centerbody");
-					if(cBodyCenter && mBodyNames.count(cBodyCenter))
-					{
-						//Override default mesh size if we've provided one
-
-						SoftBodyAnim* manim = new SoftBodyAnim(o->meshLattice);
-						manim->addBody(mBodyNames[cBodyCenter], true);
-						manim->size = o->meshSize;
-						for(map<string, b2Body*>::iterator i = mBodyNames.begin(); i != mBodyNames.end(); i++)
-						{
-							if(i->first != cBodyCenter)
-								manim->addBody(i->second);
-						}
-						manim->init();
-						o->meshAnim = manim;
-						//o->meshSize.Set(1,1);	//Can't take this into account on draw time; mesh will deform by hand
-					}
-				}
-				else if(sLatticeType == "sin")
-				{
-					SinLatticeAnim* manim = new SinLatticeAnim(o->meshLattice);
-
-					latticeElem->QueryFloatAttribute("amp", &manim->amp);
-					latticeElem->QueryFloatAttribute("freq", &manim->freq);
-					latticeElem->QueryFloatAttribute("vtime", &manim->vtime);
-
-					manim->init();
-					o->meshAnim = manim;
-				}
-				else if(sLatticeType == "wobble")
-				{
-					WobbleLatticeAnim* manim = new WobbleLatticeAnim(o->meshLattice);
-
-					latticeElem->QueryFloatAttribute("speed", &manim->speed);
-					latticeElem->QueryFloatAttribute("dist", &manim->startdist);
-					latticeElem->QueryFloatAttribute("distvar", &manim->distvar);
-					latticeElem->QueryFloatAttribute("angle", &manim->startangle);
-					latticeElem->QueryFloatAttribute("anglevar", &manim->anglevar);
-					latticeElem->QueryFloatAttribute("hfac", &manim->hfac);
-					latticeElem->QueryFloatAttribute("vfac", &manim->vfac);
-
-					manim->init();
-					o->meshAnim = manim;
-				}
-				//else TODO
-			}
-
-		}
+		JointPrototype jp;
+		jp.bodyA = i->bodyA;
+		jp.bodyB = i->bodyB;
+		jp.def.frequencyHz = i->frequencyHz;
+		jp.def.dampingRatio = i->dampingRatio;
+		jp.def.localAnchorA = b2Vec2(i->anchorA[0], i->anchorA[1]);
+		jp.def.localAnchorB = b2Vec2(i->anchorB[0], i->anchorB[1]);
+		proto->joints.push_back(jp);
 	}
 
+	const ObjLatticeDef& lat = def.lattice;
+	if(!lat.img.empty())
+	{
+		proto->latticeImg = getImage(lat.img);
+		proto->meshSize = Vec2(lat.size[0], lat.size[1]);
+	}
+	proto->latticeRes = Vec2(lat.resolution[0], lat.resolution[1]);
+	switch(lat.type)
+	{
+		case LATTICEDEF_PLAIN:
+			proto->latticeType = LATTICE_PLAIN;
+			break;
+
+		case LATTICEDEF_SOFTBODY:
+			proto->latticeType = LATTICE_SOFTBODY;
+			proto->centerBody = lat.centerBody;
+			proto->softBodies.assign(lat.softBodies.begin(), lat.softBodies.end());
+			break;
+
+		case LATTICEDEF_SIN:
+			proto->latticeType = LATTICE_SIN;
+			if(lat.mask & LATTICE_AMP)
+				proto->amp = lat.amp;
+			if(lat.mask & LATTICE_FREQ)
+				proto->freq = lat.freq;
+			if(lat.mask & LATTICE_VTIME)
+				proto->vtime = lat.vtime;
+			break;
+
+		case LATTICEDEF_WOBBLE:
+			proto->latticeType = LATTICE_WOBBLE;
+			if(lat.mask & LATTICE_SPEED)
+				proto->speed = lat.speed;
+			if(lat.mask & LATTICE_DIST)
+				proto->startdist = lat.dist;
+			if(lat.mask & LATTICE_DISTVAR)
+				proto->distvar = lat.distVar;
+			if(lat.mask & LATTICE_ANGLE)
+				proto->startangle = lat.angle;
+			if(lat.mask & LATTICE_ANGLEVAR)
+				proto->anglevar = lat.angleVar;
+			if(lat.mask & LATTICE_HFAC)
+				proto->hfac = lat.hfac;
+			if(lat.mask & LATTICE_VFAC)
+				proto->vfac = lat.vfac;
+			break;
+
+		default:
+			proto->latticeType = LATTICE_NONE;
+			break;
+	}
 
-
-	//------------------------------------------------------------------------
-	//Done
-
-	delete doc;
-	return o;
+	return proto;
 }
 
-void ResourceLoader::readFixture(tinyxml2::XMLElement* fixture, b2Body* bod)
+void ResourceLoader::clearObjPrototypes()
 {
-	b2FixtureDef fixtureDef;
-	b2PolygonShape dynamicBox;
-	b2CircleShape dynamicCircle;
-	b2ChainShape dynamicChain;
-
-	Vec2 pos;
+	for(map<uint64_t, ObjectPrototype*>::iterator i = m_objPrototypes.begin(); i != m_objPrototypes.end(); i++)
+		delete i->second;	//Releases their images and meshes
+	m_objPrototypes.clear();
+}
 
-	const char* cFixType = fixture->Attribute("type");
-	if(!cFixType)
-	{
-		LOG(ERROR) << "readFixture ERR: No fixture type";
-		return;
-	}
-	string sFixType = cFixType;
-	if(sFixType == "box")
+bool ResourceLoader::fixtureFromDef(const ObjFixtureDef& fixture, b2FixtureDef* out)
+{
+	switch(fixture.type)
 	{
-		const char* cBoxSize = fixture->Attribute("size");
-		if(!cBoxSize)
+		case FIXTURE_BOX:
 		{
-			LOG(ERROR) << "readFixture ERR: No box size";
-			return;
+			b2PolygonShape* box = new b2PolygonShape;
+			box->SetAsBox(fixture.size[0] / 2.0f, fixture.size[1] / 2.0f, b2Vec2(fixture.pos[0], fixture.pos[1]), fixture.rot);
+			out->shape = box;
+			break;
 		}
 
-		//Get position (center of box)
-		Vec2 p(0, 0);
-		const char* cPos = fixture->Attribute("pos");
-		if(cPos)
-		{
-			p = pointFromString(cPos);
-			pos = p;
-		}
-
-		//Get rotation (angle) of box
-		float fRot = 0.0f;
-		fixture->QueryFloatAttribute("rot", &fRot);
-
-		bool bHollow = false;
-		fixture->QueryBoolAttribute("hollow", &bHollow);
-
-		Vec2 pBoxSize = pointFromString(cBoxSize);
-		if(bHollow)
+		case FIXTURE_HOLLOWBOX:
 		{
-			//Create hollow box
 			b2Vec2 verts[4];
-			verts[0].Set(pBoxSize.x / 2.0f, pBoxSize.y / 2.0f);
-			verts[1].Set(-pBoxSize.x / 2.0f, pBoxSize.y / 2.0f);
-			verts[2].Set(-pBoxSize.x / 2.0f, -pBoxSize.y / 2.0f);
-			verts[3].Set(pBoxSize.x / 2.0f, -pBoxSize.y / 2.0f);
-			dynamicChain.CreateLoop(verts, 4);
-			fixtureDef.shape = &dynamicChain;
+			verts[0].Set(fixture.size[0] / 2.0f, fixture.size[1] / 2.0f);
+			verts[1].Set(-fixture.size[0] / 2.0f, fixture.size[1] / 2.0f);
+			verts[2].Set(-fixture.size[0] / 2.0f, -fixture.size[1] / 2.0f);
+			verts[3].Set(fixture.size[0] / 2.0f, -fixture.size[1] / 2.0f);
+			b2ChainShape* chain = new b2ChainShape;
+			chain->CreateLoop(verts, 4);
+			out->shape = chain;
+			break;
 		}
-		else
+
+		case FIXTURE_CIRCLE:
 		{
-			//Create box
-			dynamicBox.SetAsBox(pBoxSize.x / 2.0f, pBoxSize.y / 2.0f, b2Vec2(p.x, p.y), fRot);
-			fixtureDef.shape = &dynamicBox;
+			b2CircleShape* circle = new b2CircleShape;
+			circle->m_p = b2Vec2(fixture.pos[0], fixture.pos[1]);
+			circle->m_radius = fixture.radius;
+			out->shape = circle;
+			break;
 		}
-	}
-	else if(sFixType == "circle")
-	{
-		dynamicCircle.m_p.SetZero();
-		const char* cCircPos = fixture->Attribute("pos");
-		if(cCircPos)
+
+		case FIXTURE_LINE:
 		{
-			pos = pointFromString(cCircPos);
-			dynamicCircle.m_p = b2Vec2(pos.x, pos.y);
+			b2Vec2 verts[2];
+			verts[0].Set(0, fixture.length / 2.0f);
+			verts[1].Set(0, -fixture.length / 2.0f);
+			b2ChainShape* chain = new b2ChainShape;
+			chain->CreateChain(verts, 2);
+			out->shape = chain;
+			break;
 		}
 
-		dynamicCircle.m_radius = 1.0f;
-		fixture->QueryFloatAttribute("radius", &dynamicCircle.m_radius);
-		fixtureDef.shape = &dynamicCircle;
+		default:
+			LOG(ERROR) << "Unknown fixture type " << fixture.type;
+			return false;
 	}
-	else if(sFixType == "line")
-	{
-		float fLen = 1.0f;
-		fixture->QueryFloatAttribute("length", &fLen);
-
-		b2Vec2 verts[2];
-		verts[0].Set(0, fLen / 2.0f);
-		verts[1].Set(0, -fLen / 2.0f);
-
-		dynamicChain.CreateChain(verts, 2);
-		fixtureDef.shape = &dynamicChain;
-	}
-	//else TODO
-
-	fixtureDef.density = 1.0f;
-	fixtureDef.friction = 0.3f;
-	fixtureDef.isSensor = false;
-	fixture->QueryFloatAttribute("friction", &fixtureDef.friction);
-	fixture->QueryFloatAttribute("density", &fixtureDef.density);
-	fixture->QueryBoolAttribute("sensor", &fixtureDef.isSensor);
 
-	//TODO: Figure out how to do this if map ends up in here
+	out->density = fixture.density;
+	out->friction = fixture.friction;
+	out->isSensor = fixture.sensor;
+	return true;
+}
 
-	//Create node if this is one
-	//const char* cLua = fixture->Attribute("luaclass");
-	//if(cLua)
-	//{
-	//	Node* n = new Node();
-	//	n->luaClass = cLua;
-	//	n->lua = Lua;			//TODO: Better handling of node/object LuaInterfaces
-	//	n->pos = pos;
+void ResourceLoader::record(uint32_t type, uint64_t id, const char* cID)
+{
+	if(!m_bRecording || !m_recordedIDs.insert(id).second)
+		return;
 
-	//	const char* cName = fixture->Attribute("name");
-	//	if(cName)
-	//		n->name = cName;
+	ManifestEntry entry;
+	entry.type = type;
+	entry.path = cID;
+	m_recorded.push_back(entry);
+}
 
-	//	//Populate this node with ALL THE INFO in case Lua wants it
-	//	for(const tinyxml2::XMLAttribute* attrib = fixture->FirstAttribute(); attrib != NULL; attrib = attrib->Next())
-	//		n->setProperty(attrib->Name(), attrib->Value());
+void ResourceLoader::startRecording()
+{
+	m_bRecording = true;
+	m_recorded.clear();
+	m_recordedIDs.clear();
+}
 
-	//	getEntityManager()->add(n);
-	//	fixtureDef.userData = (void*)n;	//TODO: Use heavy userdata
-	//}
+void ResourceLoader::stopRecording(vector<ManifestEntry>* out)
+{
+	m_bRecording = false;
+	out->swap(m_recorded);
+	m_recorded.clear();
+	m_recordedIDs.clear();
+}
 
-	bod->CreateFixture(&fixtureDef);
-}
\ No newline at end of file
+bool ResourceLoader::getManifest(const string& sID, vector<ManifestEntry>* out)
+{
+	ResourceData data;
+	if(!loadData(sID, ResourceHash::hash(sID), &data, true, 1, scratchArena()))
+		return false;
+
+	ResourceManifest::parse((const char*)data.data, data.len, out);
+	freeData(&data);
+	scratchArena()->reset();
+	return true;
+}
@@ -1,52 +1,146 @@
 #pragma once
 #include <map>
+#include <set>
+#include <list>
 #include <string>
 #include <inttypes.h>
 #include "tinyxml2.h"
 #include "Rect.h"
+#include "ResourceRequest.h"
+#include "ResourceHash.h"
+#include "ResourceManifest.h"
+#include "ResourceTypes.h"
+
+#define RESOURCE(path) RES_ID(path), path	//Both arguments of the get*(uint64_t id, const char* cID) overloads
 
 class Image;
 class Object;
 class ParticleSystem;
 class MouseCursor;
 class ObjSegment;
+class ObjectPrototype;
+struct b2FixtureDef;
 class b2World;
 class b2Body;
 class ResourceCache;
 class Mesh3D;
 class PakLoader;
+class ThreadPool;
+class ResourceAllocator;
+struct SDL_mutex;
 
 class ResourceLoader
 {
+	friend class ResourceRequest;
+
 	b2World* m_world;
 	ResourceCache* m_cache;
 	PakLoader* m_pakLoader;
 	std::string m_sPakDir;
 
-	uint64_t hash(std::string sHashStr);
+	ThreadPool* m_pool;
+	SDL_mutex* m_decodedMutex;
+	std::list<ResourceRequest*> m_decoded;		//Requests the workers are done with, waiting on the main thread. Guarded by m_decodedMutex
+	std::set<ResourceRequest*> m_requests;		//Every request that hasn't been deleted yet
+
+	std::map<uint64_t, ParticleSystem*> m_particleTemplates;	//Parsed particle system XML, by ID. Never modified; get*() hands out clones
+	void clearParticleTemplates();
+
+	//Worker-thread safe: these only touch the pak loader and the filesystem
+	//Without an allocator, pak data is new[]ed and freed by freeData(). With one, it lives in the allocator.
+	bool loadData(const std::string& sID, uint64_t id, ResourceData* out, bool bFileFallback, unsigned int alignment = 1, ResourceAllocator* allocator = NULL);
+	bool decodeImage(const std::string& sID, uint64_t id, DecodedImage* out, ResourceAllocator* allocator = NULL);
+	bool decodeAtlasRegion(const TextureHeader& header, DecodedImage* out);
+	bool decodeMesh(const std::string& sID, uint64_t id, ResourceData* out);
+	template<class Def> bool loadDef(const std::string& sID, uint64_t id, Def* def);	//Particle system, object, cursor or scene, compiled or XML
+	void decodeObjectResources(ResourceRequest* req);	//Images and meshes of req->m_objDef
+	void decodeRequest(ResourceRequest* req);
+	static void freeData(ResourceData* data);
+	static void freeImage(DecodedImage* img);
+
+	//Main thread only: GL uploads and cache
+	Image* imageFromDecoded(const std::string& sID, uint64_t id, DecodedImage* decoded, bool bDecoded);
+	Mesh3D* meshFromDecoded(const std::string& sID, uint64_t id, ResourceData* decoded, bool bDecoded);
+	ParticleSystem* particleSystemFromDef(const std::string& sID, const ParticleSystemDef& def);	//Template; not init()ed
+	const ParticleSystem* particleTemplate(uint64_t id, const std::string& sID, const ParticleSystemDef* def);
+	void finishRequest(ResourceRequest* req);
+	ResourceRequest* request(ResourceType type, const std::string& sID);
+
+	std::map<uint64_t, ObjectPrototype*> m_objPrototypes;	//Compiled object XML, by ID of the XML path
+	const ObjectPrototype* objectPrototype(uint64_t id, const char* cXMLFilename, const std::string* sType);	//Path from whichever isn't NULL
+	ObjectPrototype* objectPrototypeFromDef(const ObjectDef& def);
+	void clearObjPrototypes();
+
+	bool m_bRecording;
+	std::vector<ManifestEntry> m_recorded;	//Resources asked for since startRecording(), in order
+	std::set<uint64_t> m_recordedIDs;
+	void record(uint32_t type, uint64_t id, const char* cID);	//Main thread only
+
+	//Resources with identical data in the paks share one cache entry
+	uint64_t contentID(uint64_t id);
 
-	void readFixture(tinyxml2::XMLElement* fixture, b2Body* bod);
 	ResourceLoader() {};
 public:
 	ResourceLoader(b2World* physicsWorld, std::string sPakDir);
 	~ResourceLoader();
 
+	//Frees every cached image and mesh nobody's using, along with particle system templates and
+	// object prototypes. Ones still in use stay cached until they're released and trimmed
 	void clearCache();
 
+	//Images and meshes handed out by get*() and requests each count as a use; release() them once
+	// done. Unused ones are kept until the cache goes over this many bytes of textures or meshes,
+	// then freed least recently used first.
+	void setCacheBudget(uint64_t textureBytes, uint64_t meshBytes);
+	uint64_t getTextureMemory();	//Bytes of texture memory currently cached, used or not
+	uint64_t getMeshMemory();
+
+	//Asynchronous loading. Requests are read, decompressed and decoded on worker threads, then
+	// finished (uploaded to OpenGL, cached) on the main thread in update(). Poll the returned
+	// request with isDone(), and hand it back to releaseRequest() once finished with it.
+	ResourceRequest* requestImage(const std::string& sID);
+	ResourceRequest* requestMesh(const std::string& sID);
+	ResourceRequest* requestParticleSystem(const std::string& sID);
+	ResourceRequest* requestObject(const std::string& sXMLFilename);	//Object XML path, res/obj/<type>.xml
+	ResourceRequest* requestScene(const std::string& sID);
+	void releaseRequest(ResourceRequest* req);
+
+	//Finish off decoded requests, stopping once fBudgetMs milliseconds have been spent (at least
+	// one request is always finished, so loading keeps moving). Call once per frame.
+	void update(float fBudgetMs);
+	void flush();	//Block until every outstanding request is done
+
+	//Resources can also be fetched by a precomputed ID, which skips hashing the path. cID is only
+	// looked at if the resource has to be loaded. RESOURCE() fills in both from a literal, e.g.
+	// getImage(RESOURCE("res/gfx/foo.png")).
+
 	//Images
-	Image* getImage(std::string sID);
+	Image* getImage(const std::string& sID);
+	Image* getImage(uint64_t id, const char* cID);
 
 	//Meshes
-	Mesh3D* getMesh(std::string sID);
+	Mesh3D* getMesh(const std::string& sID);
+	Mesh3D* getMesh(uint64_t id, const char* cID);
 
 	//Particles
-	ParticleSystem* getParticleSystem(std::string sID);
+	ParticleSystem* getParticleSystem(const std::string& sID);
+	ParticleSystem* getParticleSystem(uint64_t id, const char* cID);
 
 	//Mouse cursors
-	MouseCursor* getCursor(std::string sID);
+	MouseCursor* getCursor(const std::string& sID);
+
+	//Manifests. While recording, each resource fetched or requested is noted the first time it's asked
+	// for, so a scene's manifest can be written out and used to prefetch it next time
+	void startRecording();	//Starts a fresh list
+	void stopRecording(std::vector<ManifestEntry>* out);
+	bool isRecording()	{return m_bRecording;};
+	bool getManifest(const std::string& sID, std::vector<ManifestEntry>* out);	//From a pak or loose file. False if there isn't one
 
-	//TODO: Private
-	ObjSegment* getObjSegment(tinyxml2::XMLElement* layer);
+	//Scenes. Building one is up to the game; these hand back the def, and make its parts
+	bool getScene(const std::string& sID, SceneDef* out);
+	ObjSegment* objSegmentFromDef(const ObjLayerDef& layer);
+	bool fixtureFromDef(const ObjFixtureDef& fixture, b2FixtureDef* out);	//out->shape is new'd
 
-	Object* objFromXML(std::string sType, Vec2 ptOffset, Vec2 ptVel);
+	Object* objFromXML(const std::string& sType, Vec2 ptOffset, Vec2 ptVel);
+	Object* objFromXML(uint64_t id, const char* cXMLFilename, Vec2 ptOffset, Vec2 ptVel);	//ID of the full path, res/obj/<type>.xml
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "ResourceRequest.h"
+#include "ResourceLoader.h"
+#include "ParticleSystem.h"
+#include "Image.h"
+#include "Mesh3D.h"
+#include "tinyxml2.h"
+#include <cstring>
+using namespace std;
+
+ResourceRequest::ResourceRequest(ResourceLoader* loader, ResourceType type, const string& sID, uint64_t id)
+{
+	m_loader = loader;
+	m_type = type;
+	m_sID = sID;
+	m_id = id;
+	m_bDone = false;
+	m_bFailed = false;
+	m_bReleased = false;
+	m_bDecoded = false;
+	m_decodedImage = DecodedImage();	//Zeroes everything but the string; memset would trash it
+	memset(&m_decodedMesh, 0, sizeof(ResourceData));
+	m_psDef = NULL;
+	m_objDef = NULL;
+	m_img = NULL;
+	m_mesh = NULL;
+	m_ps = NULL;
+	m_sceneDef = NULL;
+}
+
+ResourceRequest::~ResourceRequest()
+{
+	ResourceLoader::freeImage(&m_decodedImage);
+	ResourceLoader::freeData(&m_decodedMesh);
+	delete m_psDef;
+	delete m_objDef;
+	for(vector<DecodedImage>::iterator i = m_decodedImages.begin(); i != m_decodedImages.end(); i++)
+		ResourceLoader::freeImage(&(*i));
+	for(vector<ResourceData>::iterator i = m_decodedMeshes.begin(); i != m_decodedMeshes.end(); i++)
+		ResourceLoader::freeData(&(*i));
+	delete m_ps;	//Nobody took it
+	delete m_sceneDef;
+	if(m_img)
+		m_img->release();
+	if(m_mesh)
+		m_mesh->release();
+}
+
+void ResourceRequest::run()
+{
+	m_loader->decodeRequest(this);
+}
+
+ParticleSystem* ResourceRequest::takeParticleSystem()
+{
+	ParticleSystem* ps = m_ps;
+	m_ps = NULL;
+	return ps;
+}
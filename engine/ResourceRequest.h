@@ -0,0 +1,103 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <inttypes.h>
+#include "ThreadPool.h"
+#include "CompiledXML.h"
+
+class ResourceLoader;
+class Image;
+class Mesh3D;
+class ParticleSystem;
+
+//Raw bytes of a resource, either pointing into a memory-mapped pak or owned by us
+typedef struct
+{
+	const unsigned char* data;
+	unsigned int len;
+	unsigned char* owned;	//Buffer to free once we're done with data. NULL if data points into a mapped pak
+	bool bMalloced;			//owned came from malloc() (loose files) rather than new[] (paks)
+} ResourceData;
+
+//Image decoded to raw pixels on the CPU, ready to hand to OpenGL
+typedef struct
+{
+	ResourceData raw;			//Pixels point in here if this came from a pak
+	unsigned char* stbiPixels;	//Pixels point in here if this was decoded from a loose image file
+	const unsigned char* pixels;
+	unsigned int width, height;
+	int mode;					//GL_RGB or GL_RGBA
+	std::string atlas;			//If set, there are no pixels; the image is the width x height part of this page at atlasX, atlasY
+	unsigned int atlasX, atlasY;
+} DecodedImage;
+
+typedef enum
+{
+	RESOURCE_IMAGE,
+	RESOURCE_MESH,
+	RESOURCE_PARTICLESYSTEM,
+	RESOURCE_OBJECT,
+	RESOURCE_SCENE,
+} ResourceType;
+
+//Handle for a resource being loaded in the background by ResourceLoader. Pak I/O, decompression
+// and decoding happen on a worker thread; the rest (anything that touches OpenGL) happens on the
+// main thread in ResourceLoader::update(). Only touch this from the main thread.
+class ResourceRequest : public ThreadJob
+{
+	friend class ResourceLoader;
+
+	ResourceLoader* m_loader;
+	ResourceType m_type;
+	std::string m_sID;
+	uint64_t m_id;
+	bool m_bDone;
+	bool m_bFailed;
+	bool m_bReleased;	//Nobody wants this anymore; delete it as soon as the worker is done with it
+
+	//Filled in on a worker thread
+	bool m_bDecoded;
+	DecodedImage m_decodedImage;	//Image, or a particle system's image
+	std::string m_sImageID;			//Which image m_decodedImage is, for particle systems
+	ResourceData m_decodedMesh;
+	ParticleSystemDef* m_psDef;
+	ObjectDef* m_objDef;
+	std::vector<DecodedImage> m_decodedImages;	//An object's images and meshes, by ID below. Only the ones that decoded
+	std::vector<std::string> m_sImageIDs;
+	std::vector<ResourceData> m_decodedMeshes;
+	std::vector<std::string> m_sMeshIDs;
+
+	//Filled in on the main thread once done
+	Image* m_img;
+	Mesh3D* m_mesh;
+	ParticleSystem* m_ps;
+	SceneDef* m_sceneDef;
+
+	ResourceRequest(ResourceLoader* loader, ResourceType type, const std::string& sID, uint64_t id);
+	ResourceRequest();
+	ResourceRequest(const ResourceRequest&);
+	ResourceRequest& operator=(const ResourceRequest&);
+	~ResourceRequest();	//Use ResourceLoader::releaseRequest()
+
+public:
+	void run();	//Worker thread side
+
+	ResourceType getType()		{return m_type;};
+	const std::string& getID()	{return m_sID;};
+
+	bool isDone()				{return m_bDone;};
+	bool failed()				{return m_bFailed;};
+
+	//Results; NULL until isDone(). Images and meshes belong to the ResourceLoader cache as usual.
+	// The request holds one use of them until it's released; addUse() to keep one around longer.
+	Image* getImage()			{return m_img;};
+	Mesh3D* getMesh()			{return m_mesh;};
+
+	//The caller owns the returned particle system, same as ResourceLoader::getParticleSystem().
+	// Returns NULL if it isn't done yet or was already taken.
+	ParticleSystem* takeParticleSystem();
+
+	//Objects have no result; once done, their prototype is cached and objFromXML() won't touch the disk.
+	//Scenes are only read, not built. The def belongs to the request.
+	const SceneDef* getScene()	{return m_sceneDef;};
+};
@@ -0,0 +1,156 @@
+#include "SceneLoader.h"
+#include "ResourceLoader.h"
+#include "ResourceRequest.h"
+#include "easylogging++.h"
+using namespace std;
+
+SceneLoader::SceneLoader(ResourceLoader* loader)
+{
+	m_loader = loader;
+	m_sceneReq = NULL;
+	m_bPrefetching = false;
+	m_bRecording = false;
+}
+
+SceneLoader::~SceneLoader()
+{
+	cancel();
+	setRecording(false);
+}
+
+void SceneLoader::setRecording(bool bRecording)
+{
+	if(m_bRecording && !bRecording)
+		writeManifest();
+	m_bRecording = bRecording;
+}
+
+void SceneLoader::writeManifest()
+{
+	if(!m_loader->isRecording())
+		return;
+
+	vector<ManifestEntry> entries;
+	m_loader->stopRecording(&entries);
+	if(m_sRecording.empty())
+		return;
+
+	string sFilename = ResourceManifest::filenameFor(m_sRecording);
+	LOG(INFO) << "Writing " << entries.size() << " resources to manifest " << sFilename;
+	ResourceManifest::write(sFilename, entries);
+}
+
+void SceneLoader::load(const string& sID)
+{
+	cancel();
+	LOG(INFO) << "Loading scene " << sID << " in the background";
+	m_sScene = sID;
+
+	//Whatever the last scene used, it's done using now
+	if(m_bRecording)
+	{
+		writeManifest();
+		m_sRecording = sID;
+		m_loader->startRecording();
+	}
+
+	m_sceneReq = m_loader->requestScene(sID);
+	prefetchManifest(sID);
+}
+
+void SceneLoader::cancel()
+{
+	for(vector<ResourceRequest*>::iterator i = m_prefetch.begin(); i != m_prefetch.end(); i++)
+		m_loader->releaseRequest(*i);
+	m_prefetch.clear();
+	m_requested.clear();
+	m_loader->releaseRequest(m_sceneReq);
+	m_sceneReq = NULL;
+	m_bPrefetching = false;
+}
+
+bool SceneLoader::update()
+{
+	if(!m_sceneReq || !m_sceneReq->isDone())
+		return false;
+
+	if(m_sceneReq->failed())
+	{
+		LOG(ERROR) << "Error loading scene " << m_sScene;
+		cancel();
+		return false;
+	}
+
+	if(!m_bPrefetching)
+	{
+		prefetch(*m_sceneReq->getScene());
+		m_bPrefetching = true;
+	}
+
+	//Failed ones are fine; building the scene tries them again and logs whatever's wrong
+	for(vector<ResourceRequest*>::iterator i = m_prefetch.begin(); i != m_prefetch.end(); i++)
+	{
+		if(!(*i)->isDone())
+			return false;
+	}
+	return true;
+}
+
+const SceneDef* SceneLoader::getScene()
+{
+	if(!m_sceneReq || !m_sceneReq->isDone())
+		return NULL;
+	return m_sceneReq->getScene();
+}
+
+void SceneLoader::prefetch(uint32_t type, const string& sPath)
+{
+	if(!m_requested.insert(sPath).second)
+		return;
+
+	switch(type)
+	{
+		case MANIFEST_IMAGE:
+			m_prefetch.push_back(m_loader->requestImage(sPath));
+			break;
+		case MANIFEST_MESH:
+			m_prefetch.push_back(m_loader->requestMesh(sPath));
+			break;
+		case MANIFEST_PARTICLESYSTEM:
+			m_prefetch.push_back(m_loader->requestParticleSystem(sPath));
+			break;
+		case MANIFEST_OBJECT:
+			m_prefetch.push_back(m_loader->requestObject(sPath));
+			break;
+	}
+}
+
+void SceneLoader::prefetch(const SceneDef& scene)
+{
+	for(vector<ObjLayerDef>::const_iterator i = scene.layers.begin(); i != scene.layers.end(); i++)
+	{
+		if(i->mask & LAYER_IMG)
+			prefetch(MANIFEST_IMAGE, i->img);
+		if(i->mask & LAYER_OBJ)
+			prefetch(MANIFEST_MESH, i->obj);
+	}
+
+	//Scenes tend to place the same object lots of times; prefetch() only loads each once
+	for(vector<SceneObjectDef>::const_iterator i = scene.objects.begin(); i != scene.objects.end(); i++)
+		prefetch(MANIFEST_OBJECT, i->path);
+
+	for(vector<SceneParticlesDef>::const_iterator i = scene.particles.begin(); i != scene.particles.end(); i++)
+		prefetch(MANIFEST_PARTICLESYSTEM, i->path);
+}
+
+//Covers what Lua asks for too, which the scene itself can't tell us about
+void SceneLoader::prefetchManifest(const string& sID)
+{
+	vector<ManifestEntry> entries;
+	if(!m_loader->getManifest(ResourceManifest::filenameFor(sID), &entries))
+		return;
+
+	LOG(TRACE) << "Prefetching " << entries.size() << " resources from manifest";
+	for(vector<ManifestEntry>::iterator i = entries.begin(); i != entries.end(); i++)
+		prefetch(i->type, i->path);
+}
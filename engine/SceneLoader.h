@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <set>
+#include "CompiledXML.h"
+
+class ResourceLoader;
+class ResourceRequest;
+
+//Loads a scene in the background while the current one keeps running. The scene is read on a
+// worker thread, then everything it uses (layer images and meshes, object prototypes, particle
+// systems) is requested, so it gets decoded on workers and uploaded a slice at a time by
+// ResourceLoader::update(). Once ready, building the scene only has to create bodies and entities.
+//
+//If the scene has a manifest (see ResourceManifest.h), everything in it is requested right away,
+// alongside the scene itself. With recording on, each scene's manifest is written out when the
+// next scene starts loading (or the loader goes away), covering everything used while it ran.
+class SceneLoader
+{
+	ResourceLoader* m_loader;
+	std::string m_sScene;
+	ResourceRequest* m_sceneReq;
+	std::vector<ResourceRequest*> m_prefetch;	//These hold uses of the scene's images and meshes until it's built
+	bool m_bPrefetching;
+	std::set<std::string> m_requested;	//Paths in m_prefetch, so the scene doesn't ask for them again
+
+	bool m_bRecording;
+	std::string m_sRecording;	//Scene we're recording a manifest for
+
+	void prefetch(uint32_t type, const std::string& sPath);	//MANIFEST_* type
+	void prefetch(const SceneDef& scene);
+	void prefetchManifest(const std::string& sID);
+	void writeManifest();
+
+	SceneLoader() {};
+	SceneLoader(const SceneLoader&);
+	SceneLoader& operator=(const SceneLoader&);
+public:
+	SceneLoader(ResourceLoader* loader);
+	~SceneLoader();
+
+	void load(const std::string& sID);	//Start loading; drops whatever was loading before
+	void cancel();						//Stop loading, and let go of everything
+
+	//Record manifests for every scene loaded from here on, overwriting old ones
+	void setRecording(bool bRecording);
+
+	bool isLoading()				{return m_sceneReq != NULL;};
+	const std::string& getID()		{return m_sScene;};
+
+	//Call once per frame, after ResourceLoader::update(). True once the scene is ready to build.
+	// If reading the scene fails, it logs the error and stops loading.
+	bool update();
+
+	//The scene to build, once update() says it's ready. Good until finish() or cancel()
+	const SceneDef* getScene();
+	void finish()					{cancel();};	//Done building it
+};
@@ -0,0 +1,72 @@
+#include "SpriteBatch.h"
+#include "Image.h"
+#include "glmx.h"
+using namespace std;
+
+SpriteBatch::SpriteBatch()
+{
+	m_tex = 0;
+	m_blend = SPRITE_BLEND_ALPHA;
+	m_verts.reserve(4096);	//A thousand sprites before we have to grow
+}
+
+void SpriteBatch::add(Image* img, const glm::mat4& xform, Vec2 size, const Color& col, Vec2 tile, int blend)
+{
+	if(img == NULL)
+		return;
+
+	//Can't mix textures or blend modes in one draw; draw what we have so far so order is kept
+	if(m_verts.size() && (img->_getTex() != m_tex || blend != m_blend))
+		flush();
+	m_tex = img->_getTex();
+	m_blend = blend;
+
+	const float corners[4][4] =
+	{
+		//x, y, u, v. Same layout as Image::render()
+		{-size.x / 2.0f,  size.y / 2.0f, 0.0f,   0.0f},		// upper left
+		{ size.x / 2.0f,  size.y / 2.0f, tile.x, 0.0f},		// upper right
+		{ size.x / 2.0f, -size.y / 2.0f, tile.x, tile.y},	// lower right
+		{-size.x / 2.0f, -size.y / 2.0f, 0.0f,   tile.y},	// lower left
+	};
+
+	for(int i = 0; i < 4; i++)
+	{
+		glm::vec4 p = xform * glm::vec4(corners[i][0], corners[i][1], 0.0f, 1.0f);
+		SpriteVertex v;
+		v.x = p.x;
+		v.y = p.y;
+		v.z = p.z;
+		v.u = img->texU(corners[i][2]);
+		v.v = img->texV(corners[i][3]);
+		v.r = col.r;
+		v.g = col.g;
+		v.b = col.b;
+		v.a = col.a;
+		m_verts.push_back(v);
+	}
+}
+
+void SpriteBatch::flush()
+{
+	if(m_verts.empty())
+		return;
+
+	glBindTexture(GL_TEXTURE_2D, m_tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);	//For tiling, same as Image::render()
+	if(m_blend == SPRITE_BLEND_ADDITIVE)
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+
+	//Vertex and texcoord arrays are always on; see engine_gl.cpp
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(SpriteVertex), &m_verts[0].x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(SpriteVertex), &m_verts[0].u);
+	glColorPointer(4, GL_FLOAT, sizeof(SpriteVertex), &m_verts[0].r);
+	glDrawArrays(GL_QUADS, 0, m_verts.size());
+	glDisableClientState(GL_COLOR_ARRAY);
+
+	if(m_blend == SPRITE_BLEND_ADDITIVE)
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+	m_verts.clear();	//Keeps its capacity, so we don't reallocate every frame
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include "Rect.h"
+#include "Color.h"
+#include "opengl-api.h"
+
+class Image;
+
+#define SPRITE_BLEND_ALPHA		0	//The usual GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+#define SPRITE_BLEND_ADDITIVE	1	//GL_SRC_ALPHA, GL_ONE
+
+//Collects textured quads, transformed on the CPU, and draws runs of them that share a texture and
+// blend mode with one glDrawArrays(). Quads are drawn in the order they're added, so anything drawn
+// some other way in between has to flush() first. Atlased images (see Image::isAtlased()) share
+// their page's texture, so they batch together.
+class SpriteBatch
+{
+	typedef struct
+	{
+		float x, y, z;
+		float u, v;
+		float r, g, b, a;
+	} SpriteVertex;
+
+	std::vector<SpriteVertex> m_verts;
+	GLuint m_tex;		//Texture of everything in m_verts
+	int m_blend;		//SPRITE_BLEND_* of everything in m_verts
+
+	SpriteBatch(const SpriteBatch&);
+	SpriteBatch& operator=(const SpriteBatch&);
+public:
+	SpriteBatch();
+
+	//Add a size.x by size.y quad centered on xform's origin, showing img tile.x by tile.y times
+	// (like Image::render(); atlased images can't tile)
+	void add(Image* img, const glm::mat4& xform, Vec2 size, const Color& col, Vec2 tile = Vec2(1.0f, 1.0f), int blend = SPRITE_BLEND_ALPHA);
+
+	//Draw everything added so far. Leaves the current color white
+	void flush();
+};
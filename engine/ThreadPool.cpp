@@ -0,0 +1,200 @@
+#include "ThreadPool.h"
+#include <SDL.h>
+#include <SDL_thread.h>
+#include <sstream>
+#include "easylogging++.h"
+using namespace std;
+
+ThreadPool::ThreadPool(unsigned int iNumThreads)
+{
+	m_mutex = SDL_CreateMutex();
+	m_jobAdded = SDL_CreateCond();
+	m_jobDone = SDL_CreateCond();
+	m_iBusy = 0;
+	m_bQuit = false;
+
+	if(!iNumThreads)
+	{
+		int iCPUs = SDL_GetCPUCount();
+		iNumThreads = (iCPUs > 2) ? iCPUs - 1 : 1;
+	}
+
+	for(unsigned int i = 0; i < iNumThreads; i++)
+	{
+		ostringstream oss;
+		oss << "worker" << i;
+		SDL_Thread* thread = SDL_CreateThread(workerThread, oss.str().c_str(), (void*)this);
+		if(!thread)
+		{
+			LOG(WARNING) << "Could not create worker thread: " << SDL_GetError();
+			break;
+		}
+		m_threads.push_back(thread);
+	}
+	LOG(INFO) << "Started " << m_threads.size() << " worker threads";
+}
+
+ThreadPool::~ThreadPool()
+{
+	SDL_LockMutex(m_mutex);
+	m_bQuit = true;
+	m_jobs.clear();
+	SDL_CondBroadcast(m_jobAdded);
+	SDL_UnlockMutex(m_mutex);
+
+	for(vector<SDL_Thread*>::iterator i = m_threads.begin(); i != m_threads.end(); i++)
+		SDL_WaitThread(*i, NULL);
+
+	SDL_DestroyCond(m_jobDone);
+	SDL_DestroyCond(m_jobAdded);
+	SDL_DestroyMutex(m_mutex);
+}
+
+int ThreadPool::workerThread(void* data)
+{
+	ThreadPool* pool = (ThreadPool*)data;
+
+	SDL_LockMutex(pool->m_mutex);
+	while(true)
+	{
+		while(!pool->m_bQuit && pool->m_jobs.empty())
+			SDL_CondWait(pool->m_jobAdded, pool->m_mutex);
+		if(pool->m_bQuit)
+			break;
+
+		ThreadJob* job = pool->m_jobs.front();
+		pool->m_jobs.pop_front();
+		pool->m_iBusy++;
+		SDL_UnlockMutex(pool->m_mutex);
+
+		job->run();
+
+		SDL_LockMutex(pool->m_mutex);
+		pool->m_iBusy--;
+		SDL_CondBroadcast(pool->m_jobDone);
+	}
+	SDL_UnlockMutex(pool->m_mutex);
+	return 0;
+}
+
+void ThreadPool::addJob(ThreadJob* job)
+{
+	if(m_threads.empty())
+	{
+		job->run();	//No workers; do it here
+		return;
+	}
+
+	SDL_LockMutex(m_mutex);
+	m_jobs.push_back(job);
+	SDL_CondSignal(m_jobAdded);
+	SDL_UnlockMutex(m_mutex);
+}
+
+bool ThreadPool::removeJob(ThreadJob* job)
+{
+	bool bRemoved = false;
+	SDL_LockMutex(m_mutex);
+	for(list<ThreadJob*>::iterator i = m_jobs.begin(); i != m_jobs.end(); i++)
+	{
+		if(*i == job)
+		{
+			m_jobs.erase(i);
+			bRemoved = true;
+			break;
+		}
+	}
+	SDL_UnlockMutex(m_mutex);
+	return bRemoved;
+}
+
+void ThreadPool::wait()
+{
+	SDL_LockMutex(m_mutex);
+	while(!m_jobs.empty() || m_iBusy)
+		SDL_CondWait(m_jobDone, m_mutex);
+	SDL_UnlockMutex(m_mutex);
+}
+
+//Shared state for one parallelFor() call
+typedef struct
+{
+	TaskFunc func;
+	void* data;
+	uint32_t count;
+	SDL_atomic_t next;			//Next index to hand out
+	SDL_mutex* mutex;
+	SDL_cond* helperDone;
+	unsigned int helpersLeft;	//Helper jobs that haven't finished yet (or been pulled back out of the queue)
+} ParallelForState;
+
+static void parallelForWork(ParallelForState* state)
+{
+	int i;
+	while((i = SDL_AtomicAdd(&state->next, 1)) < (int)state->count)
+		state->func(i, state->data);
+}
+
+class ParallelForJob : public ThreadJob
+{
+public:
+	ParallelForState* state;
+
+	void run()
+	{
+		parallelForWork(state);
+		SDL_LockMutex(state->mutex);
+		state->helpersLeft--;
+		SDL_CondSignal(state->helperDone);
+		SDL_UnlockMutex(state->mutex);
+	}
+};
+
+void ThreadPool::parallelFor(TaskFunc func, void* data, uint32_t count)
+{
+	unsigned int numHelpers = m_threads.size();
+	if(count && count - 1 < numHelpers)
+		numHelpers = count - 1;	//Caller takes one share itself
+
+	if(!numHelpers)
+	{
+		for(uint32_t i = 0; i < count; i++)
+			func(i, data);
+		return;
+	}
+
+	ParallelForState state;
+	state.func = func;
+	state.data = data;
+	state.count = count;
+	SDL_AtomicSet(&state.next, 0);
+	state.mutex = SDL_CreateMutex();
+	state.helperDone = SDL_CreateCond();
+	state.helpersLeft = numHelpers;
+
+	vector<ParallelForJob> helpers(numHelpers);
+	for(unsigned int i = 0; i < numHelpers; i++)
+	{
+		helpers[i].state = &state;
+		addJob(&helpers[i]);
+	}
+
+	parallelForWork(&state);
+
+	//Helpers that haven't started by now have nothing left to do; don't wait on them
+	unsigned int iRemoved = 0;
+	for(unsigned int i = 0; i < numHelpers; i++)
+	{
+		if(removeJob(&helpers[i]))
+			iRemoved++;
+	}
+
+	SDL_LockMutex(state.mutex);
+	state.helpersLeft -= iRemoved;
+	while(state.helpersLeft)
+		SDL_CondWait(state.helperDone, state.mutex);
+	SDL_UnlockMutex(state.mutex);
+
+	SDL_DestroyCond(state.helperDone);
+	SDL_DestroyMutex(state.mutex);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <list>
+#include <vector>
+#include "TaskRunner.h"
+
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+
+//Something to do on a worker thread. The pool doesn't own jobs; whoever adds them cleans them up.
+class ThreadJob
+{
+public:
+	virtual ~ThreadJob() {};
+	virtual void run() = 0;
+};
+
+class ThreadPool : public TaskRunner
+{
+	std::vector<SDL_Thread*> m_threads;
+	std::list<ThreadJob*> m_jobs;
+	SDL_mutex* m_mutex;
+	SDL_cond* m_jobAdded;	//Signaled when there's something to do (or we're quitting)
+	SDL_cond* m_jobDone;	//Signaled when a worker finishes a job
+	unsigned int m_iBusy;	//How many workers are in the middle of a job
+	bool m_bQuit;
+
+	static int workerThread(void* data);
+
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+
+public:
+	//Pass 0 threads to use one per CPU core, minus one for the main thread
+	ThreadPool(unsigned int iNumThreads = 0);
+	~ThreadPool();	//Jobs that haven't started yet are dropped; running ones are finished first
+
+	void addJob(ThreadJob* job);
+	bool removeJob(ThreadJob* job);	//Pull a job back out if it hasn't started yet. Returns true if it was removed
+	void wait();	//Block until every queued job has finished
+
+	//Split func across the workers. The calling thread works on it too rather than just waiting,
+	// so this is safe to call from inside a job.
+	void parallelFor(TaskFunc func, void* data, uint32_t count);
+
+	unsigned int getNumThreads()	{return m_threads.size();};
+};
@@ -1,6 +1,9 @@
 #include "Engine.h"
 #include "opengl-api.h"
 #include "easylogging++.h"
+#include <cstdlib>
+
+#define NULL_GL_ENV	"NULL_GL"	//Set this (to anything) to run without OpenGL; see OpenGLAPI::LoadNullSymbols()
 
 void Engine::setup_sdl()
 {
@@ -14,9 +17,12 @@ void Engine::setup_sdl()
 	if (SDL_InitSubSystem(SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER | SDL_INIT_HAPTIC) < 0)
 		LOG(ERROR) << "Unable to init SDL2 gamepad subsystem.";
 
+	//Has to be decided before there's a window, since a window without OpenGL can't get a context later
+	bool bNullGL = (getenv(NULL_GL_ENV) != NULL);
+
 	LOG(INFO) << "Loading OpenGL...";
 
-	if (SDL_GL_LoadLibrary(NULL) == -1)
+	if (!bNullGL && SDL_GL_LoadLibrary(NULL) == -1)
 	{
 		LOG(ERROR) << "SDL_GL_LoadLibrary Error: " << SDL_GetError();
 		exit(1);
@@ -37,7 +43,7 @@ void Engine::setup_sdl()
 	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);	//Apparently double-buffering or something
 	
 	// Create SDL window
-	Uint32 flags = SDL_WINDOW_OPENGL;
+	Uint32 flags = bNullGL ? 0 : SDL_WINDOW_OPENGL;
 	if(m_bResizable)
 		flags |= SDL_WINDOW_RESIZABLE;
 	
@@ -53,10 +59,13 @@ void Engine::setup_sdl()
 		LOG(ERROR) << "Couldn't set video mode: " << SDL_GetError();
 		exit(1);
 	}
-	SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1); //Share objects between OpenGL contexts
-	SDL_GL_CreateContext(m_Window);
-	if(SDL_GL_SetSwapInterval(-1) == -1) //Apparently Vsync or something
-		SDL_GL_SetSwapInterval(1);
+	if(!bNullGL)
+	{
+		SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1); //Share objects between OpenGL contexts
+		SDL_GL_CreateContext(m_Window);
+		if(SDL_GL_SetSwapInterval(-1) == -1) //Apparently Vsync or something
+			SDL_GL_SetSwapInterval(1);
+	}
 
 	SDL_DisplayMode mode;
 	SDL_GetDisplayMode(0, 0, &mode);
@@ -81,7 +90,10 @@ void Engine::setup_sdl()
 	//Hide system cursor for SDL, so we can use our own
 	SDL_ShowCursor(0);
 	
-	OpenGLAPI::LoadSymbols();	//Load our OpenGL symbols to use
+	if(bNullGL)
+		OpenGLAPI::LoadNullSymbols();	//Nothing gets drawn, but every call is still counted
+	else
+		OpenGLAPI::LoadSymbols();	//Load our OpenGL symbols to use
 	
 	_loadicon();	//Load our window icon
 	
@@ -121,8 +133,8 @@ void Engine::setup_opengl()
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
 	
-    glm::mat4 persp = glm::tweakedInfinitePerspective(glm::radians(45.0f), (float)m_iWidth/(float)m_iHeight, 0.1f);
-    glLoadMatrixf(glm::value_ptr(persp));
+    m_projection = glm::tweakedInfinitePerspective(glm::radians(45.0f), (float)m_iWidth/(float)m_iHeight, 0.1f);
+    glLoadMatrixf(glm::value_ptr(m_projection));
 
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
@@ -1,10 +1,20 @@
 #include "Engine.h"
 #include <SDL_syswm.h>
 #include "easylogging++.h"
+#include "opengl-api.h"
 
 void Engine::changeScreenResolution(float w, float h)
 {
 	LOG(INFO) << "Changing screen resolution to " << w << ", " << h;
+	if(OpenGLAPI::IsNull())
+	{
+		//No context to recreate
+		m_iWidth = w;
+		m_iHeight = h;
+		SDL_SetWindowSize(m_Window, m_iWidth, m_iHeight);
+		setup_opengl();
+		return;
+	}
 	int vsync = SDL_GL_GetSwapInterval();
 //In Windoze, we copy the graphics memory to our new context, so we don't have to reload all of our images and stuff every time the resolution changes
 //TODO: Look into SDL_GL_SHARE_WITH_CURRENT_CONTEXT for newer versions of SDL instead
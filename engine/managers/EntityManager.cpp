@@ -5,6 +5,7 @@
 #include "Object.h"
 #include "ObjectManager.h"
 #include "SceneryManager.h"
+#include "RenderQueue.h"
 using namespace std;
 
 EntityManager::EntityManager(ResourceLoader* resourceLoader, b2World* world)
@@ -13,6 +14,7 @@ EntityManager::EntityManager(ResourceLoader* resourceLoader, b2World* world)
 	nodeManager = new NodeManager();
 	objectManager = new ObjectManager(world);
 	sceneryManager = new SceneryManager();
+	renderQueue = new RenderQueue();
 }
 
 EntityManager::~EntityManager()
@@ -21,6 +23,7 @@ EntityManager::~EntityManager()
 	delete nodeManager;
 	delete objectManager;
 	delete sceneryManager;
+	delete renderQueue;
 }
 
 //General methods
@@ -34,10 +37,13 @@ void EntityManager::update(float dt)
 
 void EntityManager::render(glm::mat4 mat)
 {
-	sceneryManager->renderBackground(mat);
-	objectManager->render(mat);
-	particleSystemManager->render(mat);
-	sceneryManager->renderForeground(mat);
+	//Order doesn't matter here; the queue sorts by layer
+	renderQueue->setView(mat);
+	sceneryManager->renderBackground(renderQueue);
+	objectManager->render(renderQueue);
+	particleSystemManager->render(renderQueue);
+	sceneryManager->renderForeground(renderQueue);
+	renderQueue->execute();
 }
 
 void EntityManager::cleanup()
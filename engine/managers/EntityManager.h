@@ -13,6 +13,7 @@ class Object;
 class ObjSegment;
 class b2World;
 class SceneryManager;
+class RenderQueue;
 
 class EntityManager
 {
@@ -20,13 +21,15 @@ class EntityManager
 	NodeManager* nodeManager;
 	ObjectManager* objectManager;
 	SceneryManager* sceneryManager;
+	RenderQueue* renderQueue;	//Everything draws through this, sorted so like draws end up together
 
 public:
 	EntityManager(ResourceLoader* resourceLoader, b2World* world);
 	~EntityManager();
 
 	void update(float dt);
-	void render(glm::mat4 mat);
+	void render(glm::mat4 mat);	//mat is projection * modelview, for culling offscreen things
+	RenderQueue* getRenderQueue()	{return renderQueue;};
 
 	void cleanup();
 
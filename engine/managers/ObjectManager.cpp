@@ -1,5 +1,6 @@
 #include "ObjectManager.h"
 #include "Object.h"
+#include "RenderQueue.h"
 #include "Box2D/Box2D.h"
 using namespace std;
 
@@ -33,10 +34,16 @@ ObjectManager::~ObjectManager()
 	cleanup();
 }
 
-void ObjectManager::render(glm::mat4 mat)	//TODO Use mat
+void ObjectManager::render(RenderQueue* queue)
 {
 	for(list<Object*>::iterator i = m_lObjects.begin(); i != m_lObjects.end(); i++)	//Add objects
-		(*i)->draw();
+	{
+		Rect rc;
+		float nearDepth, farDepth;
+		if((*i)->getBounds(&rc, &nearDepth, &farDepth) && !queue->isVisible(rc, nearDepth, farDepth))
+			continue;	//Offscreen
+		(*i)->draw(queue, RENDER_LAYER_OBJECTS);
+	}
 }
 
 void ObjectManager::add(Object * o)
@@ -5,6 +5,7 @@
 
 class Object;
 class b2World;
+class RenderQueue;
 
 class ObjectManager
 {
@@ -17,7 +18,7 @@ public:
 	ObjectManager(b2World* world);
 	~ObjectManager();
 
-	void render(glm::mat4 mat);
+	void render(RenderQueue* queue);
 	void add(Object* o);
 	void cleanup();
 	void update(float dt);
@@ -1,5 +1,6 @@
 #include "ParticleSystemManager.h"
 #include "ParticleSystem.h"
+#include "RenderQueue.h"
 using namespace std;
 
 ParticleSystemManager::ParticleSystemManager(ResourceLoader* loader)
@@ -38,11 +39,18 @@ void ParticleSystemManager::cleanup()
 	m_updateParticles.clear();
 }
 
-void ParticleSystemManager::render(glm::mat4 mat)
+static void drawParticles(void* data, bool bDebugInfo)
+{
+	((ParticleSystem*)data)->draw();
+}
+
+void ParticleSystemManager::render(RenderQueue* queue)
 {
-	//TODO Use mat
 	for(list<ParticleSystem*>::iterator i = m_particles.begin(); i != m_particles.end(); i++)
-		(*i)->draw();
+	{
+		if(queue->isVisible((*i)->getBounds(), 0.0f))
+			queue->addFunc(RENDER_LAYER_PARTICLES, 0.0f, drawParticles, *i);
+	}
 }
 
 void ParticleSystemManager::update(float dt)
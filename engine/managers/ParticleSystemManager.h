@@ -6,6 +6,7 @@
 #include "glmx.h"
 
 class ParticleSystem;
+class RenderQueue;
 
 class ParticleSystemManager : public Observer
 {
@@ -23,7 +24,7 @@ public:
 
 	void add(ParticleSystem* sys);
 	void cleanup();
-	void render(glm::mat4 mat);
+	void render(RenderQueue* queue);
 	void update(float dt);
 
 	virtual void onNotify(std::string sParticleFilename, Vec2 pos);
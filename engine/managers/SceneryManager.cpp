@@ -1,5 +1,6 @@
 #include "SceneryManager.h"
 #include "Object.h"
+#include "RenderQueue.h"
 using namespace std;
 
 SceneryManager::~SceneryManager()
@@ -15,16 +16,26 @@ void SceneryManager::update(float dt)
 		(*i)->update(dt);
 }
 
-void SceneryManager::renderForeground(glm::mat4 mat)
+void SceneryManager::renderForeground(RenderQueue* queue)
 {
 	for(multiset<ObjSegment*>::iterator i = m_lSceneryFg.begin(); i != m_lSceneryFg.end(); i++)
-		(*i)->draw();	//TODO Use mat
+	{
+		Rect rc;
+		if((*i)->getBounds(&rc) && !queue->isVisible(rc, (*i)->depth))
+			continue;	//Offscreen
+		(*i)->draw(queue, RENDER_LAYER_FOREGROUND);
+	}
 }
 
-void SceneryManager::renderBackground(glm::mat4 mat)
+void SceneryManager::renderBackground(RenderQueue* queue)
 {
 	for(multiset<ObjSegment*>::iterator i = m_lSceneryBg.begin(); i != m_lSceneryBg.end(); i++)
-		(*i)->draw();	//TODO Use mat
+	{
+		Rect rc;
+		if((*i)->getBounds(&rc) && !queue->isVisible(rc, (*i)->depth))
+			continue;	//Offscreen
+		(*i)->draw(queue, RENDER_LAYER_BACKGROUND);
+	}
 }
 
 void SceneryManager::add(ObjSegment * seg)
@@ -4,6 +4,8 @@
 #include <set>
 #include "Object.h"
 
+class RenderQueue;
+
 //TODO: Use SceneryLayer rather than ObjSegment
 class SceneryManager
 {
@@ -23,8 +25,8 @@ public:
 	~SceneryManager();
 
 	void update(float dt);
-	void renderForeground(glm::mat4 mat);
-	void renderBackground(glm::mat4 mat);
+	void renderForeground(RenderQueue* queue);
+	void renderBackground(RenderQueue* queue);
 	void add(ObjSegment* seg);
 	void cleanup();
 };
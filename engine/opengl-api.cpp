@@ -4,22 +4,250 @@
 #include <SDL_opengl_glext.h>
 
 #include <iostream>
+#include <cstring>
 #include "opengl-api.h"
 #include "easylogging++.h"
 
 
+// Index of every entry point, for counting calls to each
+enum
+{
+#define GL_FUNC(ret,fn,params,call,rt) GLFN_##fn,
+#define GL_PTR(pty, fn) GLFN_##fn,
+#include "opengl-stubs.h"
+    GLFN_COUNT
+};
+
+static const char* s_fnNames[] =
+{
+#define GL_FUNC(ret,fn,params,call,rt) #fn,
+#define GL_PTR(pty, fn) #fn,
+#include "opengl-stubs.h"
+};
+
+static unsigned int s_calls[GLFN_COUNT];
+static GLStats s_stats;
+static bool s_bNull = false;
+
+
 // Populate global namespace with static function pointers pFUNC,
-// and function stubs FUNC that call their associated function pointer
+// and function stubs FUNC that count the call and call their associated function pointer
 #define GL_FUNC(ret,fn,params,call,rt) \
     extern "C" { \
     static ret (GLAPIENTRY *p##fn) params = NULL; \
-    ret GLAPIENTRY fn params { rt p##fn call; } \
+    ret GLAPIENTRY fn params { s_calls[GLFN_##fn]++; rt p##fn call; } \
     }
 #define GL_PTR(pty, fn) pty fn = NULL;
 
 #include "opengl-stubs.h"
 
 
+// GL_PTR entry points get called straight through their pointer, so point them at one of these,
+// which counts the call and calls the loaded function
+template<int idx, typename F> struct CountedPtr;
+template<int idx, typename R, typename... A> struct CountedPtr<idx, R (GLAPIENTRY *)(A...)>
+{
+    static R (GLAPIENTRY *real)(A...);
+    static R GLAPIENTRY stub(A... args) { s_calls[idx]++; return real(args...); }
+};
+template<int idx, typename R, typename... A> R (GLAPIENTRY *CountedPtr<idx, R (GLAPIENTRY *)(A...)>::real)(A...) = NULL;
+
+#define GL_PTR_REAL(fn) CountedPtr<GLFN_##fn, decltype(fn)>::real
+
+
+//------------------------------------
+// Null backend
+//------------------------------------
+
+// Does nothing, and returns 0/NULL/false
+template<typename F> struct NullGL;
+template<typename R, typename... A> struct NullGL<R (GLAPIENTRY *)(A...)>
+{
+    static R GLAPIENTRY stub(A...) { return R(); }
+};
+
+// The few calls whose results the engine depends on get made-up but sane ones
+static GLuint s_nextName = 1;
+
+static void GLAPIENTRY null_genNames(GLsizei n, GLuint *names)
+{
+    for(GLsizei i = 0; i < n; i++)
+        names[i] = s_nextName++;
+}
+
+static GLuint GLAPIENTRY null_glCreateShader(GLenum)
+{
+    return s_nextName++;
+}
+
+static GLuint GLAPIENTRY null_glCreateProgram(void)
+{
+    return s_nextName++;
+}
+
+static const GLubyte * GLAPIENTRY null_glGetString(GLenum)
+{
+    return (const GLubyte *)"null";
+}
+
+static unsigned int null_getCount(GLenum pname)
+{
+    switch(pname)
+    {
+        case GL_VIEWPORT:
+        case GL_SCISSOR_BOX:
+        case GL_COLOR_CLEAR_VALUE:
+            return 4;
+        case GL_POLYGON_MODE:
+            return 2;
+        case GL_MODELVIEW_MATRIX:
+        case GL_PROJECTION_MATRIX:
+        case GL_TEXTURE_MATRIX:
+            return 16;
+    }
+    return 1;
+}
+
+static void GLAPIENTRY null_glGetIntegerv(GLenum pname, GLint *params)
+{
+    memset(params, 0, null_getCount(pname) * sizeof(GLint));
+}
+
+static void GLAPIENTRY null_glGetFloatv(GLenum pname, GLfloat *params)
+{
+    memset(params, 0, null_getCount(pname) * sizeof(GLfloat));
+}
+
+static void GLAPIENTRY null_glGetDoublev(GLenum pname, GLdouble *params)
+{
+    memset(params, 0, null_getCount(pname) * sizeof(GLdouble));
+}
+
+static void GLAPIENTRY null_getObjectiv(GLuint, GLenum pname, GLint *params)
+{
+    *params = (pname == GL_COMPILE_STATUS || pname == GL_LINK_STATUS || pname == GL_VALIDATE_STATUS) ? GL_TRUE : 0;
+}
+
+static GLenum GLAPIENTRY null_glCheckFramebufferStatus(GLenum)
+{
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+
+//------------------------------------
+// Stats, whichever backend is loaded
+//------------------------------------
+
+#ifdef __APPLE__
+typedef GLenum TexInternalFormat;
+#else
+typedef GLint TexInternalFormat;
+#endif
+
+static void (GLAPIENTRY *r_glBindTexture)(GLenum, GLuint);
+static void (GLAPIENTRY *r_glTexImage2D)(GLenum, GLint, TexInternalFormat, GLsizei, GLsizei, GLint, GLenum, GLenum, const GLvoid *);
+static void (GLAPIENTRY *r_glTexSubImage2D)(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, const GLvoid *);
+static void (GLAPIENTRY *r_glDrawArrays)(GLenum, GLint, GLsizei);
+static void (GLAPIENTRY *r_glDrawElements)(GLenum, GLsizei, GLenum, const GLvoid *);
+static void (GLAPIENTRY *r_glBegin)(GLenum);
+static void (GLAPIENTRY *r_glVertex2f)(GLfloat, GLfloat);
+static void (GLAPIENTRY *r_glVertex3f)(GLfloat, GLfloat, GLfloat);
+static void (GLAPIENTRY *r_glVertex3i)(GLint, GLint, GLint);
+static PFNGLBUFFERDATAPROC r_glBufferData;
+
+static uint64_t texBytes(GLsizei width, GLsizei height, GLenum format)
+{
+    unsigned int bpp = 4;
+    if(format == GL_RGB)
+        bpp = 3;
+    else if(format == GL_ALPHA || format == GL_LUMINANCE)
+        bpp = 1;
+    return (uint64_t)width * height * bpp;
+}
+
+static void GLAPIENTRY track_glBindTexture(GLenum target, GLuint name)
+{
+    s_stats.textureBinds++;
+    r_glBindTexture(target, name);
+}
+
+static void GLAPIENTRY track_glTexImage2D(GLenum target, GLint level, TexInternalFormat internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid *pixels)
+{
+    s_stats.textureUploads++;
+    s_stats.textureBytes += texBytes(width, height, format);
+    r_glTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+}
+
+static void GLAPIENTRY track_glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *pixels)
+{
+    s_stats.textureUploads++;
+    s_stats.textureBytes += texBytes(width, height, format);
+    r_glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+}
+
+static void GLAPIENTRY track_glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    s_stats.drawCalls++;
+    s_stats.vertices += count;
+    r_glDrawArrays(mode, first, count);
+}
+
+static void GLAPIENTRY track_glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices)
+{
+    s_stats.drawCalls++;
+    s_stats.vertices += count;
+    r_glDrawElements(mode, count, type, indices);
+}
+
+static void GLAPIENTRY track_glBegin(GLenum mode)
+{
+    s_stats.drawCalls++;
+    r_glBegin(mode);
+}
+
+static void GLAPIENTRY track_glVertex2f(GLfloat x, GLfloat y)
+{
+    s_stats.vertices++;
+    r_glVertex2f(x, y);
+}
+
+static void GLAPIENTRY track_glVertex3f(GLfloat x, GLfloat y, GLfloat z)
+{
+    s_stats.vertices++;
+    r_glVertex3f(x, y, z);
+}
+
+static void GLAPIENTRY track_glVertex3i(GLint x, GLint y, GLint z)
+{
+    s_stats.vertices++;
+    r_glVertex3i(x, y, z);
+}
+
+static void APIENTRY track_glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+{
+    s_stats.bufferBytes += size;
+    r_glBufferData(target, size, data, usage);
+}
+
+// Put the trackers between the stubs and whichever backend just got loaded
+static void install_trackers(void)
+{
+#define TRACK(fn) r_##fn = p##fn; p##fn = track_##fn;
+    TRACK(glBindTexture)
+    TRACK(glTexImage2D)
+    TRACK(glTexSubImage2D)
+    TRACK(glDrawArrays)
+    TRACK(glDrawElements)
+    TRACK(glBegin)
+    TRACK(glVertex2f)
+    TRACK(glVertex3f)
+    TRACK(glVertex3i)
+#undef TRACK
+    r_glBufferData = GL_PTR_REAL(glBufferData);
+    GL_PTR_REAL(glBufferData) = track_glBufferData;
+}
+
+
 static bool lookup_glsym(const char *funcname, void **func)
 {
     *func = SDL_GL_GetProcAddress(funcname);
@@ -37,7 +265,8 @@ static bool lookup_all_glsyms(void)
 #define GL_FUNC(ret,fn,params,call,rt) \
     if (!lookup_glsym(#fn, (void **) &p##fn)) retval = false;
 #define GL_PTR(_, fn) \
-    if (!lookup_glsym(#fn, (void **) &fn)) retval = false;
+    if (!lookup_glsym(#fn, (void **) &GL_PTR_REAL(fn))) retval = false; \
+    fn = CountedPtr<GLFN_##fn, decltype(fn)>::stub;
 #include "opengl-stubs.h"
     return retval;
 }
@@ -49,7 +278,36 @@ namespace OpenGLAPI {
 
 bool LoadSymbols()
 {
-    return lookup_all_glsyms();
+    s_bNull = false;
+    bool retval = lookup_all_glsyms();
+    install_trackers();
+    return retval;
+}
+
+void LoadNullSymbols()
+{
+    s_bNull = true;
+    #define GL_FUNC(ret,fn,params,call,rt) p##fn = NullGL<decltype(p##fn)>::stub;
+    #define GL_PTR(pty, fn) GL_PTR_REAL(fn) = NullGL<pty>::stub; fn = CountedPtr<GLFN_##fn, pty>::stub;
+    #include "opengl-stubs.h"
+
+    pglGenTextures = null_genNames;
+    pglGetString = null_glGetString;
+    pglGetIntegerv = null_glGetIntegerv;
+    pglGetFloatv = null_glGetFloatv;
+    pglGetDoublev = null_glGetDoublev;
+    GL_PTR_REAL(glGenBuffers) = null_genNames;
+    GL_PTR_REAL(glGenVertexArrays) = null_genNames;
+    GL_PTR_REAL(glGenFramebuffers) = null_genNames;
+    GL_PTR_REAL(glGenRenderbuffers) = null_genNames;
+    GL_PTR_REAL(glCreateShader) = null_glCreateShader;
+    GL_PTR_REAL(glCreateProgram) = null_glCreateProgram;
+    GL_PTR_REAL(glGetShaderiv) = null_getObjectiv;
+    GL_PTR_REAL(glGetProgramiv) = null_getObjectiv;
+    GL_PTR_REAL(glCheckFramebufferStatus) = null_glCheckFramebufferStatus;
+
+    install_trackers();
+    LOG(INFO) << "Using null OpenGL";
 }
 
 void ClearSymbols()
@@ -57,10 +315,54 @@ void ClearSymbols()
     // reset all the entry points to NULL, so we know exactly what happened
     //  if we call a GL function after shutdown.
     #define GL_FUNC(ret,fn,params,call,rt) p##fn = NULL;
-    #define GL_PTR(pty, fn) fn = NULL;
+    #define GL_PTR(pty, fn) fn = NULL; GL_PTR_REAL(fn) = NULL;
     #include "opengl-stubs.h"
 }
 
+bool IsNull()
+{
+    return s_bNull;
+}
 
-}; // end namespace OpenGLAPI
+void ResetCallCount()
+{
+    memset(s_calls, 0, sizeof(s_calls));
+    memset(&s_stats, 0, sizeof(s_stats));
+}
 
+unsigned int GetCallCount()
+{
+    unsigned int total = 0;
+    for(unsigned int i = 0; i < GLFN_COUNT; i++)
+        total += s_calls[i];
+    return total;
+}
+
+unsigned int GetCallCount(const char* fn)
+{
+    for(unsigned int i = 0; i < GLFN_COUNT; i++)
+    {
+        if(!strcmp(s_fnNames[i], fn))
+            return s_calls[i];
+    }
+    return 0;
+}
+
+GLStats GetStats()
+{
+    GLStats stats = s_stats;
+    stats.calls = GetCallCount();
+    return stats;
+}
+
+void LogCallCounts()
+{
+    for(unsigned int i = 0; i < GLFN_COUNT; i++)
+    {
+        if(s_calls[i])
+            LOG(INFO) << s_fnNames[i] << ": " << s_calls[i];
+    }
+}
+
+
+}; // end namespace OpenGLAPI
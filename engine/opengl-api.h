@@ -8,6 +8,7 @@
 //#define APIENTRY
 #include <SDL_opengl.h>
 #include <SDL_opengl_glext.h>
+#include <stdint.h>
 
 #define GL_FUNC(ret,fn,params,call,rt)
 #define GL_PTR(pty, fn) extern pty fn;
@@ -20,11 +21,30 @@
 #endif
 
 
+//What's gone through OpenGL since the last ResetCallCount()
+typedef struct
+{
+	unsigned int calls;				//Every GL call
+	unsigned int drawCalls;			//glDrawArrays(), glDrawElements() and glBegin()
+	uint64_t vertices;				//Sent by glDrawArrays()/glDrawElements() and glVertex*()
+	unsigned int textureBinds;
+	unsigned int textureUploads;	//glTexImage2D() and glTexSubImage2D()
+	uint64_t textureBytes;
+	uint64_t bufferBytes;			//glBufferData()
+} GLStats;
+
 namespace OpenGLAPI
 {
-    bool LoadSymbols();
+    bool LoadSymbols();		//The real thing, from the current context
+    void LoadNullSymbols();	//No OpenGL at all; calls are counted and otherwise do nothing. Needs no context
     void ClearSymbols();
+    bool IsNull();
+
+    //Calls are counted with either set of symbols, so these work in production too
     void ResetCallCount();
     unsigned int GetCallCount();
+    unsigned int GetCallCount(const char* fn);	//Calls to one entry point, e.g. "glDrawArrays"
+    GLStats GetStats();
+    void LogCallCounts();	//Every entry point called since the last reset, and how often
 };
 
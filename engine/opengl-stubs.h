@@ -56,10 +56,12 @@ GL_FUNC(void,glRotatef,(GLfloat angle, GLfloat x, GLfloat y, GLfloat z),(angle,x
 GL_FUNC(void,glScalef,(GLfloat x, GLfloat y, GLfloat z),(x,y,z),)
 GL_FUNC(void,glTranslatef,(GLfloat x, GLfloat y, GLfloat z),(x,y,z),)
 GL_FUNC(void,glLoadMatrixf,(const GLfloat *m),(m),)
+GL_FUNC(void,glMultMatrixf,(const GLfloat *m),(m),)
 
 // drawing
 GL_FUNC(void,glVertexPointer,(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer),(size,type,stride,pointer),)
 GL_FUNC(void,glTexCoordPointer,(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer),(size,type,stride,pointer),)
+GL_FUNC(void,glNormalPointer,(GLenum type, GLsizei stride, const GLvoid *pointer),(type,stride,pointer),)
 GL_FUNC(void,glDrawArrays,(GLenum mode, GLint first, GLsizei count),(mode,first,count),)
 GL_FUNC(void,glDrawElements,(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices),(mode,count,type,indices),)
 
@@ -68,13 +70,8 @@ GL_FUNC(void,glVertex3i,(GLint x, GLint y, GLint z),(x,y,z),)
 GL_FUNC(void,glVertex2f,(GLfloat x, GLfloat y),(x,y),)
 GL_FUNC(void,glPointSize,(GLfloat size),(size),)
 GL_FUNC(void,glNormal3f,(GLfloat x, GLfloat y, GLfloat z),(x,y,z),)
-GL_FUNC(void,glDeleteLists,(GLuint list, GLsizei range),(list,range),)
-GL_FUNC(GLuint,glGenLists,(GLsizei range),(range),return)
-GL_FUNC(void,glNewList,(GLuint list, GLenum mode),(list,mode),)
 GL_FUNC(void,glTexCoord2f,(GLfloat u, GLfloat v),(u,v),)
-GL_FUNC(void,glEndList,(void),(),)
 GL_FUNC(void,glPolygonMode,(GLenum face, GLenum mode),(face,mode),)
-GL_FUNC(void,glCallList,(GLuint list),(list),)
 GL_FUNC(void,glColor4f,(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha),(red,green,blue,alpha),)
 GL_FUNC(void,glColor3f,(GLfloat red, GLfloat green, GLfloat blue),(red,green,blue),)
 GL_FUNC(void,glClearDepth,(GLdouble depth),(depth),)
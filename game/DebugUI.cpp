@@ -1,9 +1,11 @@
 #include "DebugUI.h"
 #include "imgui/imgui.h"
 #include "GameEngine.h"
+#include "EntityManager.h"
+#include "RenderQueue.h"
 
 DebugUI::DebugUI(GameEngine *ge)
-: visible(false), hadFocus(false), _ge(ge), showTestWindow(false)
+: visible(false), hadFocus(false), _ge(ge), showTestWindow(false), showRenderStats(false)
 {
 }
 
@@ -34,6 +36,7 @@ void DebugUI::_draw()
 			ImGui::MenuItem("ImGui Test", NULL, &showTestWindow);
 #endif
 			ImGui::MenuItem("Memory debugger", NULL, &memEdit.Open);
+			ImGui::MenuItem("Render stats", NULL, &showRenderStats);
 
 			ImGui::EndMenu();
 		}
@@ -44,12 +47,34 @@ void DebugUI::_draw()
 	if(memEdit.Open)
 		memEdit.Draw("GameEngine memory", (unsigned char*)_ge, sizeof(*_ge));
 
+	if(showRenderStats)
+		_drawRenderStats();
+
 #ifdef _DEBUG
 	if(showTestWindow)
 		ImGui::ShowTestWindow(&showTestWindow);
 #endif
 }
 
+void DebugUI::_drawRenderStats()
+{
+	const GLStats& stats = _ge->getFrameGLStats();
+	RenderQueue* queue = _ge->getEntityManager()->getRenderQueue();
+	if(ImGui::Begin("Render stats", &showRenderStats, ImGuiWindowFlags_AlwaysAutoResize))
+	{
+		ImGui::Text("GL calls: %u", stats.calls);
+		ImGui::Text("Draw calls: %u", stats.drawCalls);
+		ImGui::Text("Vertices: %llu", (unsigned long long)stats.vertices);
+		ImGui::Text("Texture binds: %u", stats.textureBinds);
+		ImGui::Text("Texture uploads: %u (%llu KB)", stats.textureUploads, (unsigned long long)stats.textureBytes / 1024);
+		ImGui::Text("Buffer uploads: %llu KB", (unsigned long long)stats.bufferBytes / 1024);
+		ImGui::Separator();
+		ImGui::Text("Render commands: %u (%u draws)", queue->getLastCommandCount(), queue->getLastDrawCount());
+		ImGui::Text("Culled: %u, drawn: %u", queue->getLastCulledCount(), queue->getLastVisibleCount());
+	}
+	ImGui::End();
+}
+
 bool DebugUI::hasFocus()
 {
 	return visible && (hadFocus || ImGui::IsMouseHoveringAnyWindow());
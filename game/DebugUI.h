@@ -17,8 +17,10 @@ public:
 
 private:
 	void _draw();
+	void _drawRenderStats();
 	MemoryEditor memEdit;
 	GameEngine *_ge;
 
 	bool showTestWindow;
+	bool showRenderStats;
 };
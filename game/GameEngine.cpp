@@ -12,6 +12,7 @@
 #include "DebugUI.h"
 #include "ResourceLoader.h"
 #include "EntityManager.h"
+#include "SceneLoader.h"
 using namespace std;
 
 //#define DEBUG_INPUT
@@ -93,12 +94,14 @@ Engine(iWidth, iHeight, sTitle, sAppName, sIcon, bResizable)
 	g_fParticleFac = 1.0f;
 
 	m_debugUI = new DebugUI(this);
+	m_sceneLoader = new SceneLoader(getResourceLoader());
 }
 
 GameEngine::~GameEngine()
 {
 	LOG(INFO) << "~GameEngine()";
 	saveConfig(getSaveLocation() + "config.xml");
+	delete m_sceneLoader;	//Before the resource loader goes away
 	getEntityManager()->cleanup();
 	delete m_Cursor;
 }
@@ -110,11 +113,18 @@ void GameEngine::frame(float dt)
 	stepPhysics(dt);
 	getEntityManager()->update(dt);
 	
-	//Load a new scene after updating if we've been told to
+	//Start loading a new scene if we've been told to. The current one keeps running meanwhile
 	if(m_sLoadScene.size())
 	{
-		loadScene(m_sLoadScene);
+		m_sceneLoader->load(m_sLoadScene);
 		m_sLoadScene.clear();
+	}
+	
+	//Swap it in once everything it needs is loaded
+	if(m_sceneLoader->update())
+	{
+		buildScene(m_sceneLoader->getID(), *m_sceneLoader->getScene());
+		m_sceneLoader->finish();	//Objects in the scene hold their own uses of its resources now
 		if(m_sLoadNode.size())
 		{
 			//Warp to node on map
@@ -214,7 +224,7 @@ void GameEngine::draw()
     //glLoadMatrixf(glm::value_ptr(look));
 	
 	glDisable(GL_LIGHTING);
-	glm::mat4 mat;	//TODO Use real mat
+	glm::mat4 mat = getProjection() * glm::translate(glm::mat4(1.0f), CameraPos);	//Same as what's loaded into GL now
 	getEntityManager()->render(mat);
 	drawDebug();
 	
@@ -233,7 +243,11 @@ void GameEngine::init(list<commandlineArg> sArgs)
 {
 	//Run through list for arguments we recognize
 	for (list<commandlineArg>::iterator i = sArgs.begin(); i != sArgs.end(); i++)
+	{
 		LOG(DEBUG) << "Commandline argument. Switch: " << i->sSwitch << ", value: " << i->sValue;
+		if(i->sSwitch == "record-manifests")	//Write out prefetch manifests for the scenes we play through
+			m_sceneLoader->setRecording(true);
+	}
 		
 	//Load our last screen position and such
 	loadConfig(getSaveLocation() + "config.xml");
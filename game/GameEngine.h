@@ -12,8 +12,10 @@
 
 #include "Mesh3D.h"
 #include "tinyxml2.h"
+#include "CompiledXML.h"
 
 class DebugUI;
+class SceneLoader;
 
 #define DEFAULT_WIDTH	800
 #define DEFAULT_HEIGHT	600
@@ -80,6 +82,7 @@ private:
 	std::string m_sLoadScene;	//If this is ever set, on the next frame we'll load this map	TODO: Better way of doing this
 	std::string m_sLoadNode;		//If the above is set and this is also set, warp to this named node when loading the map
 	std::string m_sLastScene;
+	SceneLoader* m_sceneLoader;	//Loads m_sLoadScene in the background; the current scene runs until it's ready
 
 	DebugUI *m_debugUI;
 
@@ -106,8 +109,9 @@ public:
 	//Functions dealing with loading/saving from XML - defined in GameEngine_xmlparse.cpp
 	bool loadConfig(std::string sFilename);
 	void saveConfig(std::string sFilename);
-	void loadScene(std::string sXMLFilename);	//Load scene from file
-	void readFixture(tinyxml2::XMLElement* fixture, b2Body* bod);	//Load a fixture from an XML element & add it to the given body
+	void loadScene(std::string sXMLFilename);	//Load scene from file, right away
+	void buildScene(const std::string& sXMLFilename, const SceneDef& scene);	//Replace the current scene with this one
+	void addGeom(const SceneGeomDef& geom, b2Body* bod);	//Add level geometry (and its node, if any) to the given body
 	
 	//Other stuff in GameEngine.cpp
 	void rumbleController(float strength, float sec, int priority = 0);	//Rumble the controller
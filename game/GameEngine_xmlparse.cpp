@@ -214,33 +214,28 @@ void GameEngine::saveConfig(string sFilename)
 //---------------------------------------------------------------------------------------------------------------------------
 void GameEngine::loadScene(string sXMLFilename)
 {
-	getEntityManager()->cleanup();
-	player = NULL;
 	LOG(INFO) << "Loading scene " << sXMLFilename;
-	CameraPos = Vec3(0,0,m_fDefCameraZ);	//Reset camera
-	tinyxml2::XMLDocument* doc = new tinyxml2::XMLDocument;
-	int iErr = doc->LoadFile(sXMLFilename.c_str());
-	if(iErr != tinyxml2::XML_NO_ERROR)
-	{
-		LOG(ERROR) << "Error parsing object XML file " << sXMLFilename << ": Error " << iErr;
-		delete doc;
-		return;
-	}
 	
-	//Grab root element
-	tinyxml2::XMLElement* root = doc->RootElement();
-	if(root == NULL)
+	//Compiled scene from a pak if there is one, the XML otherwise
+	SceneDef scene;
+	if(!getResourceLoader()->getScene(sXMLFilename, &scene))
 	{
-		LOG(ERROR) << "Error: Root element NULL in XML file " << sXMLFilename;
-		delete doc;
+		LOG(ERROR) << "Error loading scene " << sXMLFilename;
 		return;
 	}
+	buildScene(sXMLFilename, scene);
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Replace the current scene
+//---------------------------------------------------------------------------------------------------------------------------
+void GameEngine::buildScene(const string& sXMLFilename, const SceneDef& scene)
+{
+	getEntityManager()->cleanup();
+	player = NULL;
+	CameraPos = Vec3(0,0,m_fDefCameraZ);	//Reset camera
 	
-	Vec2 pGravity(0, -9.8);
-	const char* cGravity = root->Attribute("gravity");
-	if(cGravity)
-		pGravity = pointFromString(cGravity);
-	setGravity(pGravity);
+	setGravity(Vec2(scene.gravity[0], scene.gravity[1]));
 	
 	//Create ground body, for adding map geometry to
 	b2BodyDef groundBodyDef;
@@ -249,11 +244,10 @@ void GameEngine::loadScene(string sXMLFilename)
 	b2Body* groundBody = getWorld()->CreateBody(&groundBodyDef);
 	
 	//Scene boundaries
-	const char* cCamBounds = root->Attribute("bounds");
-	if(cCamBounds != NULL)
+	if(scene.bBounds)
 	{
 		//Save bounds for camera
-		rcSceneBounds.fromString(cCamBounds);
+		rcSceneBounds.set(scene.bounds[0], scene.bounds[1], scene.bounds[2], scene.bounds[3]);
 		
 		//Create boundary lines in physics
 		b2FixtureDef fixtureDef;
@@ -271,208 +265,86 @@ void GameEngine::loadScene(string sXMLFilename)
 	}
 	
 	//Load layers for the scene
-	for(tinyxml2::XMLElement* layer = root->FirstChildElement("layer"); layer != NULL; layer = layer->NextSiblingElement("layer"))
+	for(vector<ObjLayerDef>::const_iterator i = scene.layers.begin(); i != scene.layers.end(); i++)
 	{
-		ObjSegment* seg = getResourceLoader()->getObjSegment(layer);
+		ObjSegment* seg = getResourceLoader()->objSegmentFromDef(*i);
 		getEntityManager()->add(seg);
 	}
 	
 	//Load objects
-	for(tinyxml2::XMLElement* object = root->FirstChildElement("object"); object != NULL; object = object->NextSiblingElement("object"))
+	for(vector<SceneObjectDef>::const_iterator i = scene.objects.begin(); i != scene.objects.end(); i++)
 	{
-		const char* cObjType = object->Attribute("type");
-		const char* cName = object->Attribute("name");
-		const char* cPos = object->Attribute("pos");
-		const char* cVel = object->Attribute("vel");
-		if(cObjType != NULL)
+		Object* o = getResourceLoader()->objFromXML(i->id, i->path.c_str(), Vec2(i->pos[0], i->pos[1]), Vec2(i->vel[0], i->vel[1]));
+		if(o == NULL)
+			continue;
+		
+		o->lua = Lua;	//TODO better Lua handling
+		if(i->name == "ship")	//TODO: Remove & move logic elsewhere
 		{
-			Vec2 pos(0,0);
-			Vec2 vel(0,0);
-			
-			if(cPos != NULL)
-				pos = pointFromString(cPos);
-			
-			if(cVel != NULL)
-				vel = pointFromString(cVel);
-			
-			Object* o = getResourceLoader()->objFromXML(cObjType, pos, vel);
-			
-			if(o != NULL)
+			vector<ObjSegment*>::iterator segiter = o->segments.begin();
+			if(segiter != o->segments.end())
 			{
-				o->lua = Lua;	//TODO better Lua handling
-				if(cName != NULL)
+				ObjSegment* sg = *segiter;
+				if(sg->obj3D != NULL)
 				{
-					string s = cName;
-					if(s == "ship")	//TODO: Remove & move logic elsewhere
-					{
-						vector<ObjSegment*>::iterator segiter = o->segments.begin();
-						if(segiter != o->segments.end())
-						{
-							ObjSegment* sg = *segiter;
-							if(sg->obj3D != NULL)
-							{
-								sg->obj3D->useGlobalLight = false;
-								sg->obj3D->lightPos[0] = 0.0f;
-								sg->obj3D->lightPos[1] = 0.0f;
-								sg->obj3D->lightPos[2] = 3.0f;
-								sg->obj3D->lightPos[3] = 1.0f;
-							}
-						}
-					}
+					sg->obj3D->useGlobalLight = false;
+					sg->obj3D->lightPos[0] = 0.0f;
+					sg->obj3D->lightPos[1] = 0.0f;
+					sg->obj3D->lightPos[2] = 3.0f;
+					sg->obj3D->lightPos[3] = 1.0f;
 				}
-				
-				//Populate this obj with ALL THE INFO in case Lua wants it
-				for(const tinyxml2::XMLAttribute* attrib = object->FirstAttribute(); attrib != NULL; attrib = attrib->Next())
-					o->setProperty(attrib->Name(), attrib->Value());
-				
-				getEntityManager()->add(o);
 			}
 		}
+		
+		//Populate this obj with ALL THE INFO in case Lua wants it
+		for(PropertyTable::const_iterator prop = i->properties.begin(); prop != i->properties.end(); prop++)
+			o->setProperty(prop->first, prop->second);
+		
+		getEntityManager()->add(o);
 	}
 	
 	//Load particles
-	for(tinyxml2::XMLElement* particles = root->FirstChildElement("particles"); particles != NULL; particles = particles->NextSiblingElement("particles"))
+	for(vector<SceneParticlesDef>::const_iterator i = scene.particles.begin(); i != scene.particles.end(); i++)
 	{
-		const char* cFilename = particles->Attribute("file");
-		if(cFilename != NULL)
-		{
-			ParticleSystem* pSys = getResourceLoader()->getParticleSystem(cFilename);
-			getEntityManager()->add(pSys);
-		}
+		ParticleSystem* pSys = getResourceLoader()->getParticleSystem(i->id, i->path.c_str());
+		getEntityManager()->add(pSys);
 	}
 	
 	//Load level geometry
-	for(tinyxml2::XMLElement* geom = root->FirstChildElement("geom"); geom != NULL; geom = geom->NextSiblingElement("geom"))
-	{
-		readFixture(geom, groundBody);
-	}
+	for(vector<SceneGeomDef>::const_iterator i = scene.geom.begin(); i != scene.geom.end(); i++)
+		addGeom(*i, groundBody);
 	
 	//TODO: Load other things
 	
-	delete doc;
-	
 	m_sLastScene = sXMLFilename;
 }
 
 //---------------------------------------------------------------------------------------------------------------------------
-// Load Box2D fixture from XML
+// Add level geometry to the given body
 //---------------------------------------------------------------------------------------------------------------------------
-//TODO: Remove since it exists in ResourceLoader
-void GameEngine::readFixture(tinyxml2::XMLElement* fixture, b2Body* bod)
+void GameEngine::addGeom(const SceneGeomDef& geom, b2Body* bod)
 {
 	b2FixtureDef fixtureDef;
-	b2PolygonShape dynamicBox;
-	b2CircleShape dynamicCircle;
-	b2ChainShape dynamicChain;
-	
-	Vec2 pos;
-	
-	const char* cFixType = fixture->Attribute("type");
-	if(!cFixType)
-	{
-		LOG(ERROR) << "readFixture ERR: No fixture type";
+	if(!getResourceLoader()->fixtureFromDef(geom.fixture, &fixtureDef))
 		return;
-	}
-	string sFixType = cFixType;
-	if(sFixType == "box")
-	{
-		const char* cBoxSize = fixture->Attribute("size");
-		if(!cBoxSize)
-		{
-			LOG(ERROR) << "readFixture ERR: No box size";
-			return;
-		}
-		
-		//Get position (center of box)
-		Vec2 p(0,0);
-		const char* cPos = fixture->Attribute("pos");
-		if(cPos)
-		{
-			p = pointFromString(cPos);
-			pos = p;
-		}
-		
-		//Get rotation (angle) of box
-		float fRot = 0.0f;
-		fixture->QueryFloatAttribute("rot", &fRot);
-		
-		bool bHollow = false;
-		fixture->QueryBoolAttribute("hollow", &bHollow);
-		
-		Vec2 pBoxSize = pointFromString(cBoxSize);
-		if(bHollow)
-		{
-			//Create hollow box
-			b2Vec2 verts[4];
-			verts[0].Set(pBoxSize.x/2.0f, pBoxSize.y/2.0f);
-			verts[1].Set(-pBoxSize.x/2.0f, pBoxSize.y/2.0f);
-			verts[2].Set(-pBoxSize.x/2.0f, -pBoxSize.y/2.0f);
-			verts[3].Set(pBoxSize.x/2.0f, -pBoxSize.y/2.0f);
-			dynamicChain.CreateLoop(verts, 4);
-			fixtureDef.shape = &dynamicChain;
-		}
-		else
-		{
-			//Create box
-			dynamicBox.SetAsBox(pBoxSize.x/2.0f, pBoxSize.y/2.0f, b2Vec2(p.x, p.y), fRot);
-			fixtureDef.shape = &dynamicBox;
-		}
-	}
-	else if(sFixType == "circle")
-	{
-		dynamicCircle.m_p.SetZero();
-		const char* cCircPos = fixture->Attribute("pos");
-		if(cCircPos)
-		{
-            pos = pointFromString(cCircPos);
-			dynamicCircle.m_p = b2Vec2(pos.x, pos.y);
-		}
-			
-		dynamicCircle.m_radius = 1.0f;
-		fixture->QueryFloatAttribute("radius", &dynamicCircle.m_radius);
-		fixtureDef.shape = &dynamicCircle;
-	}
-	else if(sFixType == "line")
-	{
-		float fLen = 1.0f;
-		fixture->QueryFloatAttribute("length", &fLen);
-		
-		b2Vec2 verts[2];
-		verts[0].Set(0, fLen/2.0f);
-		verts[1].Set(0, -fLen/2.0f);
-		
-		dynamicChain.CreateChain(verts, 2);
-		fixtureDef.shape = &dynamicChain;
-	}
-	//else TODO
-	
-	fixtureDef.density = 1.0f;
-	fixtureDef.friction = 0.3f;
-	fixtureDef.isSensor = false;
-	fixture->QueryFloatAttribute("friction", &fixtureDef.friction);
-	fixture->QueryFloatAttribute("density", &fixtureDef.density);
-	fixture->QueryBoolAttribute("sensor", &fixtureDef.isSensor);
 	
 	//Create node if this is one
-	const char* cLua = fixture->Attribute("luaclass");
-	if(cLua)
+	if(geom.bNode)
 	{
 		Node* n = new Node();
-		n->luaClass = cLua;
+		n->luaClass = geom.luaClass;
 		n->lua = Lua;			//TODO: Better handling of node/object LuaInterfaces
-		n->pos = pos;
-		
-		const char* cName = fixture->Attribute("name");
-		if(cName)
-			n->name = cName;
+		n->pos = Vec2(geom.fixture.pos[0], geom.fixture.pos[1]);
+		n->name = geom.name;
 		
 		//Populate this node with ALL THE INFO in case Lua wants it
-		for(const tinyxml2::XMLAttribute* attrib = fixture->FirstAttribute(); attrib != NULL; attrib = attrib->Next())
-			n->setProperty(attrib->Name(), attrib->Value());
+		for(PropertyTable::const_iterator prop = geom.properties.begin(); prop != geom.properties.end(); prop++)
+			n->setProperty(prop->first, prop->second);
 		
 		getEntityManager()->add(n);
 		fixtureDef.userData = (void*)n;	//TODO: Use heavy userdata
 	}
 	
-	bod->CreateFixture(&fixtureDef);
+	bod->CreateFixture(&fixtureDef);	//Box2D copies the shape
+	delete fixtureDef.shape;
 }
\ No newline at end of file
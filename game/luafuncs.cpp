@@ -32,7 +32,7 @@ public:
 		g_pGlobalEngine->CameraPos.y = -pt.y;
 	}
 	
-	static Object* xmlParseObj(string sClassName, Vec2 ptOffset = Vec2(0,0), Vec2 ptVel = Vec2(0,0))
+	static Object* xmlParseObj(const string& sClassName, Vec2 ptOffset = Vec2(0,0), Vec2 ptVel = Vec2(0,0))
 	{
 		Object* o = g_pGlobalEngine->getResourceLoader()->objFromXML(sClassName, ptOffset, ptVel);
 		if(o)
@@ -95,7 +95,7 @@ public:
 		return g_pGlobalEngine->worldPosFromCursor(p, g_pGlobalEngine->CameraPos);
 	}
 	
-	static ParticleSystem* createParticles(string sName)
+	static ParticleSystem* createParticles(const string& sName)
 	{
 		ParticleSystem* pSys = g_pGlobalEngine->getResourceLoader()->getParticleSystem(sName);
 		g_pGlobalEngine->getEntityManager()->add(pSys);
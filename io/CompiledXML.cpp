@@ -0,0 +1,1211 @@
+#include "CompiledXML.h"
+#include "ResourceTypes.h"
+#include "ResourceHash.h"
+#include "Parse.h"
+#include "easylogging++.h"
+#include <map>
+#include <sstream>
+#include <cstring>
+#include <cstddef>
+using namespace std;
+
+#define COMPILED_XML_SIG	"CXML"
+
+//------------------------------------
+// XML attribute helpers
+//------------------------------------
+
+//Comma- or space-separated floats, same as pointFromString() and Rect::fromString(): all or nothing
+static void parseFloats(const char* s, float* out, int count)
+{
+	istringstream iss(Parse::stripCommas(s));
+	for(int i = 0; i < count; i++)
+	{
+		if(!(iss >> out[i]))
+		{
+			memset(out, 0, count * sizeof(float));
+			return;
+		}
+	}
+}
+
+//Same as Color::fromString(): three or four 0-255 values, or nothing
+static bool parseColor(const char* s, float* out)
+{
+	istringstream iss(Parse::stripCommas(s));
+	int r, g, b, a;
+	if(!(iss >> r >> g >> b))
+		return false;
+	if(!(iss >> a))
+		a = 255;
+	out[0] = (float)r / 255.0;
+	out[1] = (float)g / 255.0;
+	out[2] = (float)b / 255.0;
+	out[3] = (float)a / 255.0;
+	return true;
+}
+
+template<typename Mask> static void queryFloat(const tinyxml2::XMLElement* elem, const char* name, float* out, uint64_t bit, Mask* mask)
+{
+	if(elem->QueryFloatAttribute(name, out) == tinyxml2::XML_NO_ERROR)
+		*mask |= (Mask)bit;
+}
+
+template<typename Mask> static void queryFloats(const tinyxml2::XMLElement* elem, const char* name, float* out, int count, uint64_t bit, Mask* mask)
+{
+	const char* cVal = elem->Attribute(name);
+	if(cVal != NULL)
+	{
+		parseFloats(cVal, out, count);
+		*mask |= (Mask)bit;
+	}
+}
+
+template<typename Mask> static void queryColor(const tinyxml2::XMLElement* elem, const char* name, float* out, uint64_t bit, Mask* mask)
+{
+	const char* cVal = elem->Attribute(name);
+	if(cVal != NULL && parseColor(cVal, out))
+		*mask |= (Mask)bit;
+}
+
+//------------------------------------
+// Binary records
+//------------------------------------
+
+//Appends values to a record in native byte order, same as the rest of the pak
+class RecordWriter
+{
+	vector<unsigned char>* m_out;
+
+	void bytes(const void* data, size_t len)
+	{
+		const unsigned char* p = (const unsigned char*)data;
+		m_out->insert(m_out->end(), p, p + len);
+	}
+
+public:
+	RecordWriter(vector<unsigned char>* out) {m_out = out;};
+
+	void u32(uint32_t v)			{bytes(&v, sizeof(v));};
+	void u64(uint64_t v)			{bytes(&v, sizeof(v));};
+	void b(bool v)					{u32(v ? 1 : 0);};
+	void f(float v)					{bytes(&v, sizeof(v));};
+	void f(const float* v, int count)	{bytes(v, count * sizeof(float));};
+	void str(const string& s)		{u32(s.length()); bytes(s.data(), s.length());};
+};
+
+//Reads back what RecordWriter wrote. Once anything runs off the end, ok() is false and every read gives 0
+class RecordReader
+{
+	const unsigned char* m_cur;
+	const unsigned char* m_end;
+	bool m_bOk;
+
+	bool bytes(void* out, size_t len)
+	{
+		if(!m_bOk || (size_t)(m_end - m_cur) < len)
+		{
+			m_bOk = false;
+			memset(out, 0, len);
+			return false;
+		}
+		memcpy(out, m_cur, len);
+		m_cur += len;
+		return true;
+	}
+
+public:
+	RecordReader(const unsigned char* data, unsigned int len) {m_cur = data; m_end = data + len; m_bOk = true;};
+
+	bool ok()	{return m_bOk;};
+
+	uint32_t u32()					{uint32_t v; bytes(&v, sizeof(v)); return v;};
+	uint64_t u64()					{uint64_t v; bytes(&v, sizeof(v)); return v;};
+	bool b()						{return u32() != 0;};
+	float f()						{float v; bytes(&v, sizeof(v)); return v;};
+	void f(float* v, int count)		{bytes(v, count * sizeof(float));};
+	string str()
+	{
+		uint32_t len = u32();
+		if(!m_bOk || (size_t)(m_end - m_cur) < len)
+		{
+			m_bOk = false;
+			return string();
+		}
+		string s((const char*)m_cur, len);
+		m_cur += len;
+		return s;
+	}
+
+	//Element count, sanity-checked against how much data is left so a damaged record can't make us allocate the world
+	uint32_t count(size_t minElemSize)
+	{
+		uint32_t n = u32();
+		if(m_bOk && n > (size_t)(m_end - m_cur) / minElemSize)
+			m_bOk = false;
+		return m_bOk ? n : 0;
+	}
+};
+
+static void beginRecord(uint32_t type, vector<unsigned char>* out, size_t* headerPos)
+{
+	CompiledXMLHeader header;
+	memcpy(header.sig, COMPILED_XML_SIG, 4);
+	header.version = COMPILED_XML_VERSION;
+	header.type = type;
+	header.size = 0;	//Filled in by endRecord()
+	*headerPos = out->size();
+	out->insert(out->end(), (const unsigned char*)&header, (const unsigned char*)&header + sizeof(CompiledXMLHeader));
+}
+
+static void endRecord(vector<unsigned char>* out, size_t headerPos)
+{
+	uint32_t size = out->size() - headerPos - sizeof(CompiledXMLHeader);
+	memcpy(&(*out)[headerPos + offsetof(CompiledXMLHeader, size)], &size, sizeof(uint32_t));
+}
+
+//Check the header, and return the record data following it
+static bool openRecord(const unsigned char* data, unsigned int len, uint32_t type, const unsigned char** record, unsigned int* recordLen)
+{
+	if(!CompiledXML::isCompiled(data, len))
+		return false;
+
+	CompiledXMLHeader header;
+	memcpy(&header, data, sizeof(CompiledXMLHeader));
+	if(header.version != COMPILED_XML_VERSION)
+	{
+		LOG(ERROR) << "Compiled XML version " << header.version << " doesn't match ours (" << COMPILED_XML_VERSION << "). Rebuild your paks.";
+		return false;
+	}
+	if(header.type != type)
+	{
+		LOG(ERROR) << "Compiled XML type " << header.type << ", expected " << type;
+		return false;
+	}
+	if(header.size > len - sizeof(CompiledXMLHeader))
+	{
+		LOG(ERROR) << "Compiled XML record truncated. Expected: " << header.size << ", actual: " << len - sizeof(CompiledXMLHeader);
+		return false;
+	}
+
+	*record = data + sizeof(CompiledXMLHeader);
+	*recordLen = header.size;
+	return true;
+}
+
+namespace CompiledXML
+{
+	bool isCompiled(const unsigned char* data, unsigned int len)
+	{
+		return len >= sizeof(CompiledXMLHeader) && !memcmp(data, COMPILED_XML_SIG, 4);
+	}
+
+	//------------------------------------
+	// Particle systems
+	//------------------------------------
+	bool fromXML(const tinyxml2::XMLDocument* doc, const string& sID, ParticleSystemDef* out)
+	{
+		*out = ParticleSystemDef();
+		out->mask = 0;
+		out->decayVar = 0.0f;
+
+		const tinyxml2::XMLElement* root = doc->FirstChildElement("particlesystem");
+		if(root == NULL)
+		{
+			LOG(ERROR) << "Error: No toplevel \"particlesystem\" item in XML file " << sID;
+			return false;
+		}
+
+		queryFloats(root, "emitfrom", out->emitFrom, 4, PS_EMITFROM, &out->mask);
+		queryFloats(root, "emitfromvel", out->emitFromVel, 2, PS_EMITFROMVEL, &out->mask);
+		if(root->QueryBoolAttribute("fireonstart", &out->fireOnStart) == tinyxml2::XML_NO_ERROR)
+			out->mask |= PS_FIREONSTART;
+
+		const char* blendmode = root->Attribute("blend");
+		if(blendmode != NULL)
+		{
+			string sMode = blendmode;
+			out->mask |= PS_BLEND;
+			if(sMode == "additive")
+				out->blend = PARTICLE_BLEND_ADDITIVE;
+			else if(sMode == "normal")
+				out->blend = PARTICLE_BLEND_NORMAL;
+			else if(sMode == "subtractive")
+				out->blend = PARTICLE_BLEND_SUBTRACTIVE;
+			else
+				out->mask &= ~PS_BLEND;	//Leave it alone
+		}
+
+		if(root->QueryUnsignedAttribute("max", &out->max) == tinyxml2::XML_NO_ERROR)
+			out->mask |= PS_MAX;
+		queryFloat(root, "rate", &out->rate, PS_RATE, &out->mask);
+		queryFloat(root, "decay", &out->decay, PS_DECAY, &out->mask);
+		root->QueryFloatAttribute("decayvar", &out->decayVar);
+
+		for(const tinyxml2::XMLElement* elem = root->FirstChildElement(); elem != NULL; elem = elem->NextSiblingElement())
+		{
+			string sName = elem->Name();
+			if(sName == "img")
+			{
+				const char* cPath = elem->Attribute("path");
+				if(cPath != NULL)
+				{
+					out->img = cPath;
+					out->mask |= PS_IMG;
+					for(const tinyxml2::XMLElement* rect = elem->FirstChildElement("rect"); rect != NULL; rect = rect->NextSiblingElement("rect"))
+					{
+						const char* cVal = rect->Attribute("val");
+						if(cVal != NULL)
+						{
+							float rc[4];
+							parseFloats(cVal, rc, 4);
+							out->imgRects.insert(out->imgRects.end(), rc, rc + 4);
+						}
+					}
+				}
+			}
+			else if(sName == "emit")
+			{
+				queryFloat(elem, "angle", &out->emitAngle, PS_EMITANGLE, &out->mask);
+				queryFloat(elem, "var", &out->emitAngleVar, PS_EMITANGLEVAR, &out->mask);
+			}
+			else if(sName == "size")
+			{
+				queryFloats(elem, "start", out->sizeStart, 2, PS_SIZESTART, &out->mask);
+				queryFloats(elem, "end", out->sizeEnd, 2, PS_SIZEEND, &out->mask);
+				queryFloat(elem, "var", &out->sizeVar, PS_SIZEVAR, &out->mask);
+			}
+			else if(sName == "speed")
+			{
+				queryFloat(elem, "value", &out->speed, PS_SPEED, &out->mask);
+				queryFloat(elem, "var", &out->speedVar, PS_SPEEDVAR, &out->mask);
+			}
+			else if(sName == "accel")
+			{
+				queryFloats(elem, "value", out->accel, 2, PS_ACCEL, &out->mask);
+				queryFloats(elem, "var", out->accelVar, 2, PS_ACCELVAR, &out->mask);
+			}
+			else if(sName == "rotstart")
+			{
+				queryFloat(elem, "value", &out->rotStart, PS_ROTSTART, &out->mask);
+				queryFloat(elem, "var", &out->rotStartVar, PS_ROTSTARTVAR, &out->mask);
+			}
+			else if(sName == "rotvel")
+			{
+				queryFloat(elem, "value", &out->rotVel, PS_ROTVEL, &out->mask);
+				queryFloat(elem, "var", &out->rotVelVar, PS_ROTVELVAR, &out->mask);
+			}
+			else if(sName == "rotaccel")
+			{
+				queryFloat(elem, "value", &out->rotAccel, PS_ROTACCEL, &out->mask);
+				queryFloat(elem, "var", &out->rotAccelVar, PS_ROTACCELVAR, &out->mask);
+			}
+			else if(sName == "rotaxis")
+			{
+				//Only x and y, same as vec3FromString(); z stays 0
+				const char* cAxis = elem->Attribute("value");
+				if(cAxis && strlen(cAxis))
+					queryFloats(elem, "value", out->rotAxis, 2, PS_ROTAXIS, &out->mask);
+				const char* cAxisVar = elem->Attribute("var");
+				if(cAxisVar && strlen(cAxisVar))
+					queryFloats(elem, "var", out->rotAxisVar, 2, PS_ROTAXISVAR, &out->mask);
+			}
+			else if(sName == "col")
+			{
+				queryColor(elem, "start", out->colStart, PS_COLSTART, &out->mask);
+				queryColor(elem, "end", out->colEnd, PS_COLEND, &out->mask);
+				queryColor(elem, "var", out->colVar, PS_COLVAR, &out->mask);
+			}
+			else if(sName == "tanaccel")
+			{
+				queryFloat(elem, "value", &out->tanAccel, PS_TANACCEL, &out->mask);
+				queryFloat(elem, "var", &out->tanAccelVar, PS_TANACCELVAR, &out->mask);
+			}
+			else if(sName == "normaccel")
+			{
+				queryFloat(elem, "value", &out->normAccel, PS_NORMACCEL, &out->mask);
+				queryFloat(elem, "var", &out->normAccelVar, PS_NORMACCELVAR, &out->mask);
+			}
+			else if(sName == "life")
+			{
+				queryFloat(elem, "value", &out->life, PS_LIFE, &out->mask);
+				queryFloat(elem, "var", &out->lifeVar, PS_LIFEVAR, &out->mask);
+				queryFloat(elem, "prefade", &out->preFade, PS_PREFADE, &out->mask);
+				queryFloat(elem, "prefadevar", &out->preFadeVar, PS_PREFADEVAR, &out->mask);
+			}
+			else if(sName == "spawnondeath")
+			{
+				for(const tinyxml2::XMLElement* particle = elem->FirstChildElement("particle"); particle != NULL; particle = particle->NextSiblingElement("particle"))
+				{
+					const char* cPath = particle->Attribute("path");
+					if(cPath != NULL)
+						out->spawnOnDeath.push_back(cPath);
+				}
+			}
+			else
+				LOG(WARNING) << "Warning: Unknown element type \"" << sName << "\" found in XML file " << sID << ". Ignoring...";
+		}
+		return true;
+	}
+
+	void write(const ParticleSystemDef& def, vector<unsigned char>* out)
+	{
+		size_t headerPos;
+		beginRecord(COMPILED_XML_PARTICLESYSTEM, out, &headerPos);
+
+		RecordWriter w(out);
+		w.u64(def.mask);
+		w.f(def.emitFrom, 4);
+		w.f(def.emitFromVel, 2);
+		w.b(def.fireOnStart);
+		w.u32(def.blend);
+		w.u32(def.max);
+		w.f(def.rate);
+		w.f(def.decay);
+		w.f(def.decayVar);
+		w.str(def.img);
+		w.u32(def.imgRects.size() / 4);
+		if(def.imgRects.size())
+			w.f(&def.imgRects[0], def.imgRects.size());
+		w.f(def.emitAngle);
+		w.f(def.emitAngleVar);
+		w.f(def.sizeStart, 2);
+		w.f(def.sizeEnd, 2);
+		w.f(def.sizeVar);
+		w.f(def.speed);
+		w.f(def.speedVar);
+		w.f(def.accel, 2);
+		w.f(def.accelVar, 2);
+		w.f(def.rotStart);
+		w.f(def.rotStartVar);
+		w.f(def.rotVel);
+		w.f(def.rotVelVar);
+		w.f(def.rotAccel);
+		w.f(def.rotAccelVar);
+		w.f(def.rotAxis, 3);
+		w.f(def.rotAxisVar, 3);
+		w.f(def.colStart, 4);
+		w.f(def.colEnd, 4);
+		w.f(def.colVar, 4);
+		w.f(def.tanAccel);
+		w.f(def.tanAccelVar);
+		w.f(def.normAccel);
+		w.f(def.normAccelVar);
+		w.f(def.life);
+		w.f(def.lifeVar);
+		w.f(def.preFade);
+		w.f(def.preFadeVar);
+		w.u32(def.spawnOnDeath.size());
+		for(vector<string>::const_iterator i = def.spawnOnDeath.begin(); i != def.spawnOnDeath.end(); i++)
+			w.str(*i);
+
+		endRecord(out, headerPos);
+	}
+
+	bool read(const unsigned char* data, unsigned int len, ParticleSystemDef* out)
+	{
+		const unsigned char* record;
+		unsigned int recordLen;
+		if(!openRecord(data, len, COMPILED_XML_PARTICLESYSTEM, &record, &recordLen))
+			return false;
+
+		RecordReader r(record, recordLen);
+		out->mask = r.u64();
+		r.f(out->emitFrom, 4);
+		r.f(out->emitFromVel, 2);
+		out->fireOnStart = r.b();
+		out->blend = r.u32();
+		out->max = r.u32();
+		out->rate = r.f();
+		out->decay = r.f();
+		out->decayVar = r.f();
+		out->img = r.str();
+		out->imgRects.resize(r.count(4 * sizeof(float)) * 4);
+		if(out->imgRects.size())
+			r.f(&out->imgRects[0], out->imgRects.size());
+		out->emitAngle = r.f();
+		out->emitAngleVar = r.f();
+		r.f(out->sizeStart, 2);
+		r.f(out->sizeEnd, 2);
+		out->sizeVar = r.f();
+		out->speed = r.f();
+		out->speedVar = r.f();
+		r.f(out->accel, 2);
+		r.f(out->accelVar, 2);
+		out->rotStart = r.f();
+		out->rotStartVar = r.f();
+		out->rotVel = r.f();
+		out->rotVelVar = r.f();
+		out->rotAccel = r.f();
+		out->rotAccelVar = r.f();
+		r.f(out->rotAxis, 3);
+		r.f(out->rotAxisVar, 3);
+		r.f(out->colStart, 4);
+		r.f(out->colEnd, 4);
+		r.f(out->colVar, 4);
+		out->tanAccel = r.f();
+		out->tanAccelVar = r.f();
+		out->normAccel = r.f();
+		out->normAccelVar = r.f();
+		out->life = r.f();
+		out->lifeVar = r.f();
+		out->preFade = r.f();
+		out->preFadeVar = r.f();
+		out->spawnOnDeath.resize(r.count(sizeof(uint32_t)));
+		for(vector<string>::iterator i = out->spawnOnDeath.begin(); i != out->spawnOnDeath.end(); i++)
+			*i = r.str();
+
+		if(!r.ok())
+			LOG(ERROR) << "Compiled particle system record damaged";
+		return r.ok();
+	}
+
+	//------------------------------------
+	// Objects
+	//------------------------------------
+	void layerFromXML(const tinyxml2::XMLElement* layer, ObjLayerDef* out)
+	{
+		*out = ObjLayerDef();
+		out->mask = 0;
+
+		const char* cLayerFilename = layer->Attribute("img");
+		if(cLayerFilename != NULL)
+		{
+			out->img = cLayerFilename;
+			out->mask |= LAYER_IMG;
+		}
+		queryFloats(layer, "pos", out->pos, 2, LAYER_POS, &out->mask);
+		queryFloats(layer, "tile", out->tile, 2, LAYER_TILE, &out->mask);
+		queryFloat(layer, "rot", &out->rot, LAYER_ROT, &out->mask);
+		queryFloat(layer, "depth", &out->depth, LAYER_DEPTH, &out->mask);
+		queryFloats(layer, "size", out->size, 2, LAYER_SIZE, &out->mask);
+		queryColor(layer, "col", out->col, LAYER_COL, &out->mask);
+
+		const char* cSegObj = layer->Attribute("obj");
+		if(cSegObj != NULL)
+		{
+			out->obj = cSegObj;
+			out->mask |= LAYER_OBJ;
+		}
+	}
+
+	static bool fixtureFromXML(const tinyxml2::XMLElement* fixture, ObjFixtureDef* out)
+	{
+		memset(out, 0, sizeof(ObjFixtureDef));
+
+		const char* cFixType = fixture->Attribute("type");
+		if(!cFixType)
+		{
+			LOG(ERROR) << "readFixture ERR: No fixture type";
+			return false;
+		}
+		string sFixType = cFixType;
+		if(sFixType == "box")
+		{
+			const char* cBoxSize = fixture->Attribute("size");
+			if(!cBoxSize)
+			{
+				LOG(ERROR) << "readFixture ERR: No box size";
+				return false;
+			}
+			parseFloats(cBoxSize, out->size, 2);
+
+			//Position (center of box) and rotation (angle); hollow boxes ignore these
+			const char* cPos = fixture->Attribute("pos");
+			if(cPos)
+				parseFloats(cPos, out->pos, 2);
+			fixture->QueryFloatAttribute("rot", &out->rot);
+
+			bool bHollow = false;
+			fixture->QueryBoolAttribute("hollow", &bHollow);
+			out->type = bHollow ? FIXTURE_HOLLOWBOX : FIXTURE_BOX;
+		}
+		else if(sFixType == "circle")
+		{
+			out->type = FIXTURE_CIRCLE;
+			const char* cCircPos = fixture->Attribute("pos");
+			if(cCircPos)
+				parseFloats(cCircPos, out->pos, 2);
+
+			out->radius = 1.0f;
+			fixture->QueryFloatAttribute("radius", &out->radius);
+		}
+		else if(sFixType == "line")
+		{
+			out->type = FIXTURE_LINE;
+			out->length = 1.0f;
+			fixture->QueryFloatAttribute("length", &out->length);
+		}
+		else	//TODO
+		{
+			LOG(ERROR) << "readFixture ERR: Unknown fixture type " << sFixType;
+			return false;
+		}
+
+		out->density = 1.0f;
+		out->friction = 0.3f;
+		out->sensor = false;
+		fixture->QueryFloatAttribute("friction", &out->friction);
+		fixture->QueryFloatAttribute("density", &out->density);
+		fixture->QueryBoolAttribute("sensor", &out->sensor);
+		return true;
+	}
+
+	bool fromXML(const tinyxml2::XMLDocument* doc, const string& sID, ObjectDef* out)
+	{
+		*out = ObjectDef();
+		out->bLuaClass = false;
+		out->lattice.size[0] = out->lattice.size[1] = 0;
+		out->lattice.type = LATTICEDEF_NONE;
+		out->lattice.resolution[0] = out->lattice.resolution[1] = 10;	//Default lattice resolution = 10, 10
+		out->lattice.centerBody = 0;
+		out->lattice.mask = 0;
+
+		//Grab root element
+		const tinyxml2::XMLElement* root = doc->RootElement();
+		if(root == NULL)
+		{
+			LOG(ERROR) << "Error: Root element NULL in XML file " << sID;
+			return false;
+		}
+
+		const char* cLuaClass = root->Attribute("luaclass");
+		if(cLuaClass != NULL)
+		{
+			out->luaClass = cLuaClass;
+			out->bLuaClass = true;
+		}
+
+		map<string, uint32_t> mBodyNames;	//Segment index by body name
+
+		//Segments
+		for(const tinyxml2::XMLElement* segment = root->FirstChildElement("segment"); segment != NULL; segment = segment->NextSiblingElement("segment"))
+		{
+			ObjSegmentDef seg;
+			seg.bLayer = false;
+			seg.bBody = false;
+			seg.bodyType = BODY_DYNAMIC;
+			seg.bodyPos[0] = seg.bodyPos[1] = 0;
+			seg.linearDamping = 0;
+			seg.fixedRotation = false;	//True for sprites, false for physical objects
+
+			const tinyxml2::XMLElement* layer = segment->FirstChildElement("layer");
+			if(layer != NULL)
+			{
+				seg.bLayer = true;
+				layerFromXML(layer, &seg.layer);
+			}
+
+			const tinyxml2::XMLElement* body = segment->FirstChildElement("body");
+			if(body != NULL)
+			{
+				seg.bBody = true;
+
+				string sBodyName;
+				const char* cBodyName = body->Attribute("name");
+				if(cBodyName)
+					sBodyName = cBodyName;
+				mBodyNames[sBodyName] = out->segments.size();
+
+				const char* cBodyPos = body->Attribute("pos");
+				if(cBodyPos)
+					parseFloats(cBodyPos, seg.bodyPos, 2);
+
+				const char* cBodyType = body->Attribute("type");
+				if(cBodyType)
+				{
+					string sBodyType = cBodyType;
+					if(sBodyType == "dynamic")
+						seg.bodyType = BODY_DYNAMIC;
+					else if(sBodyType == "kinematic")
+						seg.bodyType = BODY_KINEMATIC;
+					else
+						seg.bodyType = BODY_STATIC;
+				}
+
+				body->QueryFloatAttribute("linearDamping", &seg.linearDamping);
+				body->QueryBoolAttribute("fixedrot", &seg.fixedRotation);
+
+				for(const tinyxml2::XMLElement* fixture = body->FirstChildElement("fixture"); fixture != NULL; fixture = fixture->NextSiblingElement("fixture"))
+				{
+					ObjFixtureDef fix;
+					if(fixtureFromXML(fixture, &fix))
+						seg.fixtures.push_back(fix);
+				}
+			}
+			out->segments.push_back(seg);
+		}
+
+		//Joints
+		for(const tinyxml2::XMLElement* joint = root->FirstChildElement("joint"); joint != NULL; joint = joint->NextSiblingElement("joint"))
+		{
+			const char* cJointType = joint->Attribute("type");
+			if(!cJointType || string(cJointType) != "distance")
+				continue;	//TODO Other joint types
+
+			const char* cBodyA = joint->Attribute("bodyA");
+			const char* cBodyB = joint->Attribute("bodyB");
+			if(!cBodyA || !cBodyB) continue;
+			if(!mBodyNames.count(cBodyA) || !mBodyNames.count(cBodyB)) continue;
+
+			ObjJointDef jd;
+			memset(&jd, 0, sizeof(ObjJointDef));
+			jd.bodyA = mBodyNames[cBodyA];
+			jd.bodyB = mBodyNames[cBodyB];
+
+			jd.frequencyHz = 2.0f;
+			jd.dampingRatio = 0.0f;
+			joint->QueryFloatAttribute("frequencyHz", &jd.frequencyHz);
+			joint->QueryFloatAttribute("dampingRatio", &jd.dampingRatio);
+
+			const char* cAnchorA = joint->Attribute("anchorA");
+			const char* cAnchorB = joint->Attribute("anchorB");
+			if(cAnchorA)
+				parseFloats(cAnchorA, jd.anchorA, 2);
+			if(cAnchorB)
+				parseFloats(cAnchorB, jd.anchorB, 2);
+
+			out->joints.push_back(jd);
+		}
+
+		//Lattice
+		const tinyxml2::XMLElement* latticeElem = root->FirstChildElement("lattice");
+		const char* cMeshImg = latticeElem ? latticeElem->Attribute("img") : NULL;
+		const char* cMeshImgSize = latticeElem ? latticeElem->Attribute("size") : NULL;
+		if(cMeshImg && cMeshImgSize)
+		{
+			ObjLatticeDef& lat = out->lattice;
+			lat.img = cMeshImg;
+			parseFloats(cMeshImgSize, lat.size, 2);
+
+			const char* cLatticeType = latticeElem->Attribute("type");
+			if(cLatticeType)
+			{
+				const char* cBodyRes = latticeElem->Attribute("resolution");
+				if(cBodyRes)
+					parseFloats(cBodyRes, lat.resolution, 2);
+
+				lat.type = LATTICEDEF_PLAIN;
+
+				string sLatticeType = cLatticeType;
+				if(sLatticeType == "softbody")
+				{
+					const char* cBodyCenter = latticeElem->Attribute("centerbody");
+					if(cBodyCenter && mBodyNames.count(cBodyCenter))
+					{
+						lat.type = LATTICEDEF_SOFTBODY;
+						lat.centerBody = mBodyNames[cBodyCenter];
+						for(map<string, uint32_t>::iterator i = mBodyNames.begin(); i != mBodyNames.end(); i++)
+						{
+							if(i->first != cBodyCenter)
+								lat.softBodies.push_back(i->second);
+						}
+					}
+				}
+				else if(sLatticeType == "sin")
+				{
+					lat.type = LATTICEDEF_SIN;
+					queryFloat(latticeElem, "amp", &lat.amp, LATTICE_AMP, &lat.mask);
+					queryFloat(latticeElem, "freq", &lat.freq, LATTICE_FREQ, &lat.mask);
+					queryFloat(latticeElem, "vtime", &lat.vtime, LATTICE_VTIME, &lat.mask);
+				}
+				else if(sLatticeType == "wobble")
+				{
+					lat.type = LATTICEDEF_WOBBLE;
+					queryFloat(latticeElem, "speed", &lat.speed, LATTICE_SPEED, &lat.mask);
+					queryFloat(latticeElem, "dist", &lat.dist, LATTICE_DIST, &lat.mask);
+					queryFloat(latticeElem, "distvar", &lat.distVar, LATTICE_DISTVAR, &lat.mask);
+					queryFloat(latticeElem, "angle", &lat.angle, LATTICE_ANGLE, &lat.mask);
+					queryFloat(latticeElem, "anglevar", &lat.angleVar, LATTICE_ANGLEVAR, &lat.mask);
+					queryFloat(latticeElem, "hfac", &lat.hfac, LATTICE_HFAC, &lat.mask);
+					queryFloat(latticeElem, "vfac", &lat.vfac, LATTICE_VFAC, &lat.mask);
+				}
+				//else TODO
+			}
+		}
+		return true;
+	}
+
+	static void writeLayer(RecordWriter& w, const ObjLayerDef& layer)
+	{
+		w.u32(layer.mask);
+		w.str(layer.img);
+		w.f(layer.pos, 2);
+		w.f(layer.tile, 2);
+		w.f(layer.rot);
+		w.f(layer.depth);
+		w.f(layer.size, 2);
+		w.f(layer.col, 4);
+		w.str(layer.obj);
+	}
+
+	static void readLayer(RecordReader& r, ObjLayerDef* layer)
+	{
+		layer->mask = r.u32();
+		layer->img = r.str();
+		r.f(layer->pos, 2);
+		r.f(layer->tile, 2);
+		layer->rot = r.f();
+		layer->depth = r.f();
+		r.f(layer->size, 2);
+		r.f(layer->col, 4);
+		layer->obj = r.str();
+	}
+
+	#define FIXTURE_RECORD_SIZE	(11 * sizeof(uint32_t))
+
+	static void writeFixture(RecordWriter& w, const ObjFixtureDef& fixture)
+	{
+		w.u32(fixture.type);
+		w.f(fixture.size, 2);
+		w.f(fixture.pos, 2);
+		w.f(fixture.rot);
+		w.f(fixture.radius);
+		w.f(fixture.length);
+		w.f(fixture.friction);
+		w.f(fixture.density);
+		w.b(fixture.sensor);
+	}
+
+	static void readFixture(RecordReader& r, ObjFixtureDef* fixture)
+	{
+		fixture->type = r.u32();
+		r.f(fixture->size, 2);
+		r.f(fixture->pos, 2);
+		fixture->rot = r.f();
+		fixture->radius = r.f();
+		fixture->length = r.f();
+		fixture->friction = r.f();
+		fixture->density = r.f();
+		fixture->sensor = r.b();
+	}
+
+	void write(const ObjectDef& def, vector<unsigned char>* out)
+	{
+		size_t headerPos;
+		beginRecord(COMPILED_XML_OBJECT, out, &headerPos);
+
+		RecordWriter w(out);
+		w.b(def.bLuaClass);
+		w.str(def.luaClass);
+
+		w.u32(def.segments.size());
+		for(vector<ObjSegmentDef>::const_iterator i = def.segments.begin(); i != def.segments.end(); i++)
+		{
+			w.b(i->bLayer);
+			if(i->bLayer)
+				writeLayer(w, i->layer);
+			w.b(i->bBody);
+			if(!i->bBody)
+				continue;
+			w.u32(i->bodyType);
+			w.f(i->bodyPos, 2);
+			w.f(i->linearDamping);
+			w.b(i->fixedRotation);
+			w.u32(i->fixtures.size());
+			for(vector<ObjFixtureDef>::const_iterator j = i->fixtures.begin(); j != i->fixtures.end(); j++)
+				writeFixture(w, *j);
+		}
+
+		w.u32(def.joints.size());
+		for(vector<ObjJointDef>::const_iterator i = def.joints.begin(); i != def.joints.end(); i++)
+		{
+			w.u32(i->bodyA);
+			w.u32(i->bodyB);
+			w.f(i->frequencyHz);
+			w.f(i->dampingRatio);
+			w.f(i->anchorA, 2);
+			w.f(i->anchorB, 2);
+		}
+
+		const ObjLatticeDef& lat = def.lattice;
+		w.str(lat.img);
+		w.f(lat.size, 2);
+		w.u32(lat.type);
+		w.f(lat.resolution, 2);
+		w.u32(lat.centerBody);
+		w.u32(lat.softBodies.size());
+		for(vector<uint32_t>::const_iterator i = lat.softBodies.begin(); i != lat.softBodies.end(); i++)
+			w.u32(*i);
+		w.u32(lat.mask);
+		w.f(lat.amp);
+		w.f(lat.freq);
+		w.f(lat.vtime);
+		w.f(lat.speed);
+		w.f(lat.dist);
+		w.f(lat.distVar);
+		w.f(lat.angle);
+		w.f(lat.angleVar);
+		w.f(lat.hfac);
+		w.f(lat.vfac);
+
+		endRecord(out, headerPos);
+	}
+
+	bool read(const unsigned char* data, unsigned int len, ObjectDef* out)
+	{
+		const unsigned char* record;
+		unsigned int recordLen;
+		if(!openRecord(data, len, COMPILED_XML_OBJECT, &record, &recordLen))
+			return false;
+
+		RecordReader r(record, recordLen);
+		out->bLuaClass = r.b();
+		out->luaClass = r.str();
+
+		out->segments.resize(r.count(2 * sizeof(uint32_t)));
+		for(vector<ObjSegmentDef>::iterator i = out->segments.begin(); i != out->segments.end(); i++)
+		{
+			i->bLayer = r.b();
+			if(i->bLayer)
+				readLayer(r, &i->layer);
+			i->bBody = r.b();
+			if(!i->bBody)
+				continue;
+			i->bodyType = r.u32();
+			r.f(i->bodyPos, 2);
+			i->linearDamping = r.f();
+			i->fixedRotation = r.b();
+			i->fixtures.resize(r.count(FIXTURE_RECORD_SIZE));
+			for(vector<ObjFixtureDef>::iterator j = i->fixtures.begin(); j != i->fixtures.end(); j++)
+				readFixture(r, &(*j));
+		}
+
+		out->joints.resize(r.count(8 * sizeof(uint32_t)));
+		for(vector<ObjJointDef>::iterator i = out->joints.begin(); i != out->joints.end(); i++)
+		{
+			i->bodyA = r.u32();
+			i->bodyB = r.u32();
+			i->frequencyHz = r.f();
+			i->dampingRatio = r.f();
+			r.f(i->anchorA, 2);
+			r.f(i->anchorB, 2);
+		}
+
+		ObjLatticeDef& lat = out->lattice;
+		lat.img = r.str();
+		r.f(lat.size, 2);
+		lat.type = r.u32();
+		r.f(lat.resolution, 2);
+		lat.centerBody = r.u32();
+		lat.softBodies.resize(r.count(sizeof(uint32_t)));
+		for(vector<uint32_t>::iterator i = lat.softBodies.begin(); i != lat.softBodies.end(); i++)
+			*i = r.u32();
+		lat.mask = r.u32();
+		lat.amp = r.f();
+		lat.freq = r.f();
+		lat.vtime = r.f();
+		lat.speed = r.f();
+		lat.dist = r.f();
+		lat.distVar = r.f();
+		lat.angle = r.f();
+		lat.angleVar = r.f();
+		lat.hfac = r.f();
+		lat.vfac = r.f();
+
+		//Segment indices come from the file; make sure they're ones we have
+		bool bOk = r.ok();
+		uint32_t numSegments = out->segments.size();
+		for(vector<ObjJointDef>::iterator i = out->joints.begin(); i != out->joints.end(); i++)
+		{
+			if(i->bodyA >= numSegments || i->bodyB >= numSegments || !out->segments[i->bodyA].bBody || !out->segments[i->bodyB].bBody)
+				bOk = false;
+		}
+		if(lat.type == LATTICEDEF_SOFTBODY)
+		{
+			if(lat.centerBody >= numSegments || !out->segments[lat.centerBody].bBody)
+				bOk = false;
+			for(vector<uint32_t>::iterator i = lat.softBodies.begin(); i != lat.softBodies.end(); i++)
+			{
+				if(*i >= numSegments || !out->segments[*i].bBody)
+					bOk = false;
+			}
+		}
+
+		if(!bOk)
+			LOG(ERROR) << "Compiled object record damaged";
+		return bOk;
+	}
+
+	//------------------------------------
+	// Mouse cursors
+	//------------------------------------
+	bool fromXML(const tinyxml2::XMLDocument* doc, const string& sID, CursorDef* out)
+	{
+		*out = CursorDef();
+		out->mask = 0;
+
+		const tinyxml2::XMLElement* root = doc->FirstChildElement("cursor");
+		if(root == NULL)
+		{
+			LOG(ERROR) << "Error: No toplevel \"cursor\" item in XML file " << sID;
+			return false;
+		}
+
+		const char* cImgPath = root->Attribute("path");
+		if(cImgPath)
+		{
+			out->img = cImgPath;
+			out->mask |= CURSOR_IMG;
+		}
+		queryFloats(root, "size", out->size, 2, CURSOR_SIZE, &out->mask);
+		queryFloats(root, "hotspot", out->hotSpot, 2, CURSOR_HOTSPOT, &out->mask);
+		return true;
+	}
+
+	void write(const CursorDef& def, vector<unsigned char>* out)
+	{
+		size_t headerPos;
+		beginRecord(COMPILED_XML_CURSOR, out, &headerPos);
+
+		RecordWriter w(out);
+		w.u32(def.mask);
+		w.str(def.img);
+		w.f(def.size, 2);
+		w.f(def.hotSpot, 2);
+
+		endRecord(out, headerPos);
+	}
+
+	bool read(const unsigned char* data, unsigned int len, CursorDef* out)
+	{
+		const unsigned char* record;
+		unsigned int recordLen;
+		if(!openRecord(data, len, COMPILED_XML_CURSOR, &record, &recordLen))
+			return false;
+
+		RecordReader r(record, recordLen);
+		out->mask = r.u32();
+		out->img = r.str();
+		r.f(out->size, 2);
+		r.f(out->hotSpot, 2);
+
+		if(!r.ok())
+			LOG(ERROR) << "Compiled cursor record damaged";
+		return r.ok();
+	}
+
+	//------------------------------------
+	// Scenes
+	//------------------------------------
+	static void propertiesFromXML(const tinyxml2::XMLElement* elem, PropertyTable* out)
+	{
+		for(const tinyxml2::XMLAttribute* attrib = elem->FirstAttribute(); attrib != NULL; attrib = attrib->Next())
+			out->push_back(make_pair(string(attrib->Name()), string(attrib->Value())));
+	}
+
+	bool fromXML(const tinyxml2::XMLDocument* doc, const string& sID, SceneDef* out)
+	{
+		*out = SceneDef();
+		out->gravity[0] = 0;
+		out->gravity[1] = -9.8f;
+		out->bBounds = false;
+		memset(out->bounds, 0, sizeof(out->bounds));
+
+		//Grab root element
+		const tinyxml2::XMLElement* root = doc->RootElement();
+		if(root == NULL)
+		{
+			LOG(ERROR) << "Error: Root element NULL in XML file " << sID;
+			return false;
+		}
+
+		const char* cGravity = root->Attribute("gravity");
+		if(cGravity)
+			parseFloats(cGravity, out->gravity, 2);
+
+		const char* cCamBounds = root->Attribute("bounds");
+		if(cCamBounds)
+		{
+			out->bBounds = true;
+			parseFloats(cCamBounds, out->bounds, 4);
+		}
+
+		//Layers
+		for(const tinyxml2::XMLElement* layer = root->FirstChildElement("layer"); layer != NULL; layer = layer->NextSiblingElement("layer"))
+		{
+			ObjLayerDef def;
+			layerFromXML(layer, &def);
+			out->layers.push_back(def);
+		}
+
+		//Objects
+		for(const tinyxml2::XMLElement* object = root->FirstChildElement("object"); object != NULL; object = object->NextSiblingElement("object"))
+		{
+			const char* cObjType = object->Attribute("type");
+			if(cObjType == NULL)
+				continue;
+
+			SceneObjectDef obj;
+			obj.path = string("res/obj/") + cObjType + ".xml";
+			obj.id = ResourceHash::hash(obj.path);
+			obj.pos[0] = obj.pos[1] = 0;
+			obj.vel[0] = obj.vel[1] = 0;
+
+			const char* cPos = object->Attribute("pos");
+			if(cPos)
+				parseFloats(cPos, obj.pos, 2);
+			const char* cVel = object->Attribute("vel");
+			if(cVel)
+				parseFloats(cVel, obj.vel, 2);
+			const char* cName = object->Attribute("name");
+			if(cName)
+				obj.name = cName;
+
+			propertiesFromXML(object, &obj.properties);
+			out->objects.push_back(obj);
+		}
+
+		//Particles
+		for(const tinyxml2::XMLElement* particles = root->FirstChildElement("particles"); particles != NULL; particles = particles->NextSiblingElement("particles"))
+		{
+			const char* cFilename = particles->Attribute("file");
+			if(cFilename == NULL)
+				continue;
+
+			SceneParticlesDef ps;
+			ps.path = cFilename;
+			ps.id = ResourceHash::hash(ps.path);
+			out->particles.push_back(ps);
+		}
+
+		//Level geometry
+		for(const tinyxml2::XMLElement* geom = root->FirstChildElement("geom"); geom != NULL; geom = geom->NextSiblingElement("geom"))
+		{
+			SceneGeomDef def;
+			if(!fixtureFromXML(geom, &def.fixture))
+				continue;
+
+			const char* cLua = geom->Attribute("luaclass");
+			def.bNode = (cLua != NULL);
+			if(def.bNode)
+			{
+				def.luaClass = cLua;
+				const char* cName = geom->Attribute("name");
+				if(cName)
+					def.name = cName;
+				propertiesFromXML(geom, &def.properties);
+			}
+			out->geom.push_back(def);
+		}
+		return true;
+	}
+
+	static void writeProperties(RecordWriter& w, const PropertyTable& properties)
+	{
+		w.u32(properties.size());
+		for(PropertyTable::const_iterator i = properties.begin(); i != properties.end(); i++)
+		{
+			w.str(i->first);
+			w.str(i->second);
+		}
+	}
+
+	static void readProperties(RecordReader& r, PropertyTable* properties)
+	{
+		properties->resize(r.count(2 * sizeof(uint32_t)));
+		for(PropertyTable::iterator i = properties->begin(); i != properties->end(); i++)
+		{
+			i->first = r.str();
+			i->second = r.str();
+		}
+	}
+
+	void write(const SceneDef& def, vector<unsigned char>* out)
+	{
+		size_t headerPos;
+		beginRecord(COMPILED_XML_SCENE, out, &headerPos);
+
+		RecordWriter w(out);
+		w.f(def.gravity, 2);
+		w.b(def.bBounds);
+		w.f(def.bounds, 4);
+
+		w.u32(def.layers.size());
+		for(vector<ObjLayerDef>::const_iterator i = def.layers.begin(); i != def.layers.end(); i++)
+			writeLayer(w, *i);
+
+		w.u32(def.objects.size());
+		for(vector<SceneObjectDef>::const_iterator i = def.objects.begin(); i != def.objects.end(); i++)
+		{
+			w.str(i->path);
+			w.u64(i->id);
+			w.f(i->pos, 2);
+			w.f(i->vel, 2);
+			w.str(i->name);
+			writeProperties(w, i->properties);
+		}
+
+		w.u32(def.particles.size());
+		for(vector<SceneParticlesDef>::const_iterator i = def.particles.begin(); i != def.particles.end(); i++)
+		{
+			w.str(i->path);
+			w.u64(i->id);
+		}
+
+		w.u32(def.geom.size());
+		for(vector<SceneGeomDef>::const_iterator i = def.geom.begin(); i != def.geom.end(); i++)
+		{
+			writeFixture(w, i->fixture);
+			w.b(i->bNode);
+			if(!i->bNode)
+				continue;
+			w.str(i->luaClass);
+			w.str(i->name);
+			writeProperties(w, i->properties);
+		}
+
+		endRecord(out, headerPos);
+	}
+
+	bool read(const unsigned char* data, unsigned int len, SceneDef* out)
+	{
+		const unsigned char* record;
+		unsigned int recordLen;
+		if(!openRecord(data, len, COMPILED_XML_SCENE, &record, &recordLen))
+			return false;
+
+		RecordReader r(record, recordLen);
+		r.f(out->gravity, 2);
+		out->bBounds = r.b();
+		r.f(out->bounds, 4);
+
+		out->layers.resize(r.count(2 * sizeof(uint32_t)));
+		for(vector<ObjLayerDef>::iterator i = out->layers.begin(); i != out->layers.end(); i++)
+			readLayer(r, &(*i));
+
+		out->objects.resize(r.count(4 * sizeof(uint32_t)));
+		for(vector<SceneObjectDef>::iterator i = out->objects.begin(); i != out->objects.end(); i++)
+		{
+			i->path = r.str();
+			i->id = r.u64();
+			r.f(i->pos, 2);
+			r.f(i->vel, 2);
+			i->name = r.str();
+			readProperties(r, &i->properties);
+		}
+
+		out->particles.resize(r.count(3 * sizeof(uint32_t)));
+		for(vector<SceneParticlesDef>::iterator i = out->particles.begin(); i != out->particles.end(); i++)
+		{
+			i->path = r.str();
+			i->id = r.u64();
+		}
+
+		out->geom.resize(r.count(FIXTURE_RECORD_SIZE + sizeof(uint32_t)));
+		for(vector<SceneGeomDef>::iterator i = out->geom.begin(); i != out->geom.end(); i++)
+		{
+			readFixture(r, &i->fixture);
+			i->bNode = r.b();
+			if(!i->bNode)
+				continue;
+			i->luaClass = r.str();
+			i->name = r.str();
+			readProperties(r, &i->properties);
+		}
+
+		if(!r.ok())
+			LOG(ERROR) << "Compiled scene record damaged";
+		return r.ok();
+	}
+}
@@ -0,0 +1,283 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include "tinyxml2.h"
+
+//Particle systems, objects, mouse cursors and scenes are written as XML. CompiledXML reads that XML into
+// the plain structs below, and turns those structs into binary records (see CompiledXMLHeader) and
+// back. The compressor stores the records in paks in place of the XML text, so loading one from a
+// pak doesn't involve any text parsing; the engine builds from the structs either way, so loose
+// XML files keep working the same during development.
+//
+//Values that are optional in the XML and default to whatever the engine class starts out with
+// have a bit in the struct's mask, set only if the XML gave one.
+
+//------------------------------------
+// Particle systems
+//------------------------------------
+#define PS_EMITFROM			(1ULL << 0)
+#define PS_EMITFROMVEL		(1ULL << 1)
+#define PS_FIREONSTART		(1ULL << 2)
+#define PS_BLEND			(1ULL << 3)
+#define PS_MAX				(1ULL << 4)
+#define PS_RATE				(1ULL << 5)
+#define PS_DECAY			(1ULL << 6)
+#define PS_IMG				(1ULL << 7)
+#define PS_EMITANGLE		(1ULL << 8)
+#define PS_EMITANGLEVAR		(1ULL << 9)
+#define PS_SIZESTART		(1ULL << 10)
+#define PS_SIZEEND			(1ULL << 11)
+#define PS_SIZEVAR			(1ULL << 12)
+#define PS_SPEED			(1ULL << 13)
+#define PS_SPEEDVAR			(1ULL << 14)
+#define PS_ACCEL			(1ULL << 15)
+#define PS_ACCELVAR			(1ULL << 16)
+#define PS_ROTSTART			(1ULL << 17)
+#define PS_ROTSTARTVAR		(1ULL << 18)
+#define PS_ROTVEL			(1ULL << 19)
+#define PS_ROTVELVAR		(1ULL << 20)
+#define PS_ROTACCEL			(1ULL << 21)
+#define PS_ROTACCELVAR		(1ULL << 22)
+#define PS_ROTAXIS			(1ULL << 23)
+#define PS_ROTAXISVAR		(1ULL << 24)
+#define PS_COLSTART			(1ULL << 25)
+#define PS_COLEND			(1ULL << 26)
+#define PS_COLVAR			(1ULL << 27)
+#define PS_TANACCEL			(1ULL << 28)
+#define PS_TANACCELVAR		(1ULL << 29)
+#define PS_NORMACCEL		(1ULL << 30)
+#define PS_NORMACCELVAR		(1ULL << 31)
+#define PS_LIFE				(1ULL << 32)
+#define PS_LIFEVAR			(1ULL << 33)
+#define PS_PREFADE			(1ULL << 34)
+#define PS_PREFADEVAR		(1ULL << 35)
+
+#define PARTICLE_BLEND_NORMAL		0
+#define PARTICLE_BLEND_ADDITIVE		1
+#define PARTICLE_BLEND_SUBTRACTIVE	2
+
+typedef struct
+{
+	uint64_t mask;			//PS_* bits
+	float emitFrom[4];		//Left, top, right, bottom
+	float emitFromVel[2];
+	bool fireOnStart;
+	uint32_t blend;			//PARTICLE_BLEND_*
+	uint32_t max;
+	float rate;
+	float decay;
+	float decayVar;			//Always valid; 0 if not given
+	std::string img;
+	std::vector<float> imgRects;	//Four floats (left, top, right, bottom) per rect
+	float emitAngle, emitAngleVar;
+	float sizeStart[2], sizeEnd[2];
+	float sizeVar;
+	float speed, speedVar;
+	float accel[2], accelVar[2];
+	float rotStart, rotStartVar;
+	float rotVel, rotVelVar;
+	float rotAccel, rotAccelVar;
+	float rotAxis[3], rotAxisVar[3];
+	float colStart[4], colEnd[4], colVar[4];	//RGBA, 0-1
+	float tanAccel, tanAccelVar;
+	float normAccel, normAccelVar;
+	float life, lifeVar;
+	float preFade, preFadeVar;
+	std::vector<std::string> spawnOnDeath;
+} ParticleSystemDef;
+
+//------------------------------------
+// Objects
+//------------------------------------
+#define LAYER_IMG		(1 << 0)
+#define LAYER_POS		(1 << 1)
+#define LAYER_TILE		(1 << 2)
+#define LAYER_ROT		(1 << 3)
+#define LAYER_DEPTH		(1 << 4)
+#define LAYER_SIZE		(1 << 5)
+#define LAYER_COL		(1 << 6)
+#define LAYER_OBJ		(1 << 7)
+
+//Image layer of an object segment (or scene)
+typedef struct
+{
+	uint32_t mask;			//LAYER_* bits
+	std::string img;
+	float pos[2];
+	float tile[2];
+	float rot;
+	float depth;
+	float size[2];
+	float col[4];
+	std::string obj;		//3D mesh
+} ObjLayerDef;
+
+#define FIXTURE_BOX			0
+#define FIXTURE_HOLLOWBOX	1
+#define FIXTURE_CIRCLE		2
+#define FIXTURE_LINE		3
+
+//Box2D fixture. Defaults from the XML format are already filled in
+typedef struct
+{
+	uint32_t type;			//FIXTURE_*
+	float size[2];			//Boxes
+	float pos[2];			//Boxes and circles
+	float rot;				//Boxes
+	float radius;			//Circles
+	float length;			//Lines
+	float friction;
+	float density;
+	bool sensor;
+} ObjFixtureDef;
+
+#define BODY_DYNAMIC	0
+#define BODY_KINEMATIC	1
+#define BODY_STATIC		2
+
+typedef struct
+{
+	bool bLayer;
+	ObjLayerDef layer;
+	bool bBody;
+	uint32_t bodyType;		//BODY_*
+	float bodyPos[2];		//Relative to the object
+	float linearDamping;
+	bool fixedRotation;
+	std::vector<ObjFixtureDef> fixtures;
+} ObjSegmentDef;
+
+//Distance joint between two segments' bodies
+typedef struct
+{
+	uint32_t bodyA;			//Segment indices
+	uint32_t bodyB;
+	float frequencyHz;
+	float dampingRatio;
+	float anchorA[2];
+	float anchorB[2];
+} ObjJointDef;
+
+#define LATTICEDEF_NONE			0	//No lattice, but maybe an image
+#define LATTICEDEF_PLAIN		1
+#define LATTICEDEF_SOFTBODY		2
+#define LATTICEDEF_SIN			3
+#define LATTICEDEF_WOBBLE		4
+
+#define LATTICE_AMP			(1 << 0)
+#define LATTICE_FREQ		(1 << 1)
+#define LATTICE_VTIME		(1 << 2)
+#define LATTICE_SPEED		(1 << 3)
+#define LATTICE_DIST		(1 << 4)
+#define LATTICE_DISTVAR		(1 << 5)
+#define LATTICE_ANGLE		(1 << 6)
+#define LATTICE_ANGLEVAR	(1 << 7)
+#define LATTICE_HFAC		(1 << 8)
+#define LATTICE_VFAC		(1 << 9)
+
+typedef struct
+{
+	std::string img;		//Empty if the object has no lattice image
+	float size[2];
+	uint32_t type;			//LATTICEDEF_*
+	float resolution[2];
+	uint32_t centerBody;	//Segment indices for softbody lattices
+	std::vector<uint32_t> softBodies;
+	uint32_t mask;			//LATTICE_* bits
+	float amp, freq, vtime;	//Sin
+	float speed, dist, distVar, angle, angleVar, hfac, vfac;	//Wobble
+} ObjLatticeDef;
+
+typedef struct
+{
+	bool bLuaClass;
+	std::string luaClass;
+	std::vector<ObjSegmentDef> segments;
+	std::vector<ObjJointDef> joints;
+	ObjLatticeDef lattice;
+} ObjectDef;
+
+//------------------------------------
+// Mouse cursors
+//------------------------------------
+#define CURSOR_IMG			(1 << 0)
+#define CURSOR_SIZE			(1 << 1)
+#define CURSOR_HOTSPOT		(1 << 2)
+
+typedef struct
+{
+	uint32_t mask;			//CURSOR_* bits
+	std::string img;
+	float size[2];
+	float hotSpot[2];
+} CursorDef;
+
+//------------------------------------
+// Scenes
+//------------------------------------
+typedef std::vector<std::pair<std::string, std::string> > PropertyTable;	//Name, value
+
+typedef struct
+{
+	std::string path;		//res/obj/<type>.xml
+	uint64_t id;			//Resource ID of path
+	float pos[2];
+	float vel[2];
+	std::string name;
+	PropertyTable properties;	//Every attribute of the <object> element, for Lua
+} SceneObjectDef;
+
+typedef struct
+{
+	std::string path;
+	uint64_t id;			//Resource ID of path
+} SceneParticlesDef;
+
+//Level geometry, added to the scene's ground body. With a Lua class, it's a node as well
+typedef struct
+{
+	ObjFixtureDef fixture;
+	bool bNode;
+	std::string luaClass;
+	std::string name;
+	PropertyTable properties;	//Every attribute of the <geom> element, for Lua
+} SceneGeomDef;
+
+typedef struct
+{
+	float gravity[2];
+	bool bBounds;
+	float bounds[4];		//Left, top, right, bottom
+	std::vector<ObjLayerDef> layers;
+	std::vector<SceneObjectDef> objects;
+	std::vector<SceneParticlesDef> particles;
+	std::vector<SceneGeomDef> geom;
+} SceneDef;
+
+namespace CompiledXML
+{
+	//True if data starts with a CompiledXMLHeader, rather than being XML text
+	bool isCompiled(const unsigned char* data, unsigned int len);
+
+	//Read XML into a def. sID is just for error messages. Return false if the XML isn't the right kind
+	bool fromXML(const tinyxml2::XMLDocument* doc, const std::string& sID, ParticleSystemDef* out);
+	bool fromXML(const tinyxml2::XMLDocument* doc, const std::string& sID, ObjectDef* out);
+	bool fromXML(const tinyxml2::XMLDocument* doc, const std::string& sID, CursorDef* out);
+	bool fromXML(const tinyxml2::XMLDocument* doc, const std::string& sID, SceneDef* out);
+	void layerFromXML(const tinyxml2::XMLElement* layer, ObjLayerDef* out);
+
+	//Read a compiled record (header and all). Return false if it's damaged, from a different
+	// COMPILED_XML_VERSION, or a different type of record
+	bool read(const unsigned char* data, unsigned int len, ParticleSystemDef* out);
+	bool read(const unsigned char* data, unsigned int len, ObjectDef* out);
+	bool read(const unsigned char* data, unsigned int len, CursorDef* out);
+	bool read(const unsigned char* data, unsigned int len, SceneDef* out);
+
+	//Append a compiled record (header and all) to out
+	void write(const ParticleSystemDef& def, std::vector<unsigned char>* out);
+	void write(const ObjectDef& def, std::vector<unsigned char>* out);
+	void write(const CursorDef& def, std::vector<unsigned char>* out);
+	void write(const SceneDef& def, std::vector<unsigned char>* out);
+}
@@ -0,0 +1,120 @@
+#include "MappedFile.h"
+#include <cstdlib>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+MappedFile::MappedFile()
+{
+	m_data = NULL;
+	m_size = 0;
+#ifdef _WIN32
+	m_hFile = NULL;
+	m_hMapping = NULL;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(string sFilename)
+{
+	close();
+
+	HANDLE hFile = CreateFileA(sFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+	if(hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER sz;
+	if(!GetFileSizeEx(hFile, &sz) || !sz.QuadPart)
+	{
+		CloseHandle(hFile);
+		return false;	//Can't map empty files
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(hMapping == NULL)
+	{
+		CloseHandle(hFile);
+		return false;
+	}
+
+	void* view = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if(view == NULL)
+	{
+		CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return false;
+	}
+
+	m_hFile = hFile;
+	m_hMapping = hMapping;
+	m_data = (const unsigned char*)view;
+	m_size = sz.QuadPart;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if(m_data)
+		UnmapViewOfFile(m_data);
+	if(m_hMapping)
+		CloseHandle(m_hMapping);
+	if(m_hFile)
+		CloseHandle(m_hFile);
+
+	m_data = NULL;
+	m_size = 0;
+	m_hFile = NULL;
+	m_hMapping = NULL;
+}
+
+#else
+
+bool MappedFile::open(string sFilename)
+{
+	close();
+
+	int fd = ::open(sFilename.c_str(), O_RDONLY);
+	if(fd < 0)
+		return false;
+
+	struct stat st;
+	if(fstat(fd, &st) || st.st_size <= 0)
+	{
+		::close(fd);
+		return false;	//Can't map empty files
+	}
+
+	void* view = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);	//Mapping holds its own reference to the file
+	if(view == MAP_FAILED)
+		return false;
+
+	m_data = (const unsigned char*)view;
+	m_size = st.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if(m_data)
+		munmap((void*)m_data, m_size);
+
+	m_data = NULL;
+	m_size = 0;
+}
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <inttypes.h>
+
+//Read-only memory mapping of an entire file. The mapping stays valid until close() is called
+// or the object is destroyed, and can be read from any thread.
+class MappedFile
+{
+	const unsigned char* m_data;
+	uint64_t m_size;
+
+#ifdef _WIN32
+	void* m_hFile;
+	void* m_hMapping;
+#endif
+
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	//Map the given file into memory. Returns false on error.
+	bool open(std::string sFilename);
+	void close();
+
+	bool isOpen()					{return m_data != NULL;};
+	const unsigned char* data()		{return m_data;};
+	uint64_t size()					{return m_size;};
+};
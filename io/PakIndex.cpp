@@ -0,0 +1,104 @@
+#include "PakIndex.h"
+#include <cstring>
+using namespace std;
+
+#define MIN_CAPACITY	16
+
+PakIndex::PakIndex()
+{
+	m_count = 0;
+}
+
+void PakIndex::clear()
+{
+	m_entries.clear();
+	m_count = 0;
+}
+
+uint64_t PakIndex::mix(uint64_t id)
+{
+	//IDs are string hashes already, but djb2 is weak in the low bits; scramble them a bit more
+	id ^= id >> 33;
+	id *= 0xff51afd7ed558ccdULL;
+	id ^= id >> 33;
+	id *= 0xc4ceb9fe1a85ec53ULL;
+	id ^= id >> 33;
+	return id;
+}
+
+void PakIndex::rehash(uint32_t capacity)
+{
+	vector<Entry> old;
+	old.swap(m_entries);
+
+	Entry empty;
+	memset(&empty, 0, sizeof(Entry));
+	m_entries.assign(capacity, empty);
+
+	uint64_t mask = capacity - 1;
+	for(vector<Entry>::iterator i = old.begin(); i != old.end(); i++)
+	{
+		if(!i->used)
+			continue;
+		uint64_t slot = mix(i->id) & mask;
+		while(m_entries[slot].used)
+			slot = (slot + 1) & mask;
+		m_entries[slot] = *i;
+	}
+}
+
+void PakIndex::reserve(uint32_t numEntries)
+{
+	//Keep load factor at or under 1/2 so probes stay short
+	uint64_t capacity = MIN_CAPACITY;
+	while(capacity < (uint64_t)numEntries * 2)
+		capacity <<= 1;
+
+	if(capacity > m_entries.size())
+		rehash((uint32_t)capacity);
+}
+
+bool PakIndex::insert(uint64_t id, uint64_t offset, uint32_t pak, uint32_t* prevPak)
+{
+	if((uint64_t)(m_count + 1) * 2 > m_entries.size())
+		reserve((m_count + 1) * 2);	//Grow geometrically
+
+	uint64_t mask = m_entries.size() - 1;
+	uint64_t slot = mix(id) & mask;
+	while(m_entries[slot].used)
+	{
+		if(m_entries[slot].id == id)
+		{
+			if(prevPak)
+				*prevPak = m_entries[slot].pak;
+			m_entries[slot].offset = offset;
+			m_entries[slot].pak = pak;
+			return false;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	Entry& e = m_entries[slot];
+	e.id = id;
+	e.offset = offset;
+	e.pak = pak;
+	e.used = 1;
+	m_count++;
+	return true;
+}
+
+const PakIndex::Entry* PakIndex::find(uint64_t id) const
+{
+	if(m_entries.empty())
+		return NULL;
+
+	uint64_t mask = m_entries.size() - 1;
+	uint64_t slot = mix(id) & mask;
+	while(m_entries[slot].used)
+	{
+		if(m_entries[slot].id == id)
+			return &m_entries[slot];
+		slot = (slot + 1) & mask;
+	}
+	return NULL;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <stddef.h>
+#include <inttypes.h>
+#include <vector>
+
+//Flat open-addressing hash table mapping resource IDs to where they live in a pak. All entries
+// sit in one contiguous array (no per-entry heap nodes), and lookups are a short linear probe.
+// Lookups are const and may run on any number of threads at once, as long as nothing is
+// inserting at the same time.
+class PakIndex
+{
+public:
+	typedef struct
+	{
+		uint64_t id;		//Resource ID
+		uint64_t offset;	//Offset from start of pak to CompressionHeader
+		uint32_t pak;		//Which pak this resource lives in (index assigned by the caller)
+		uint32_t used;		//Nonzero if this slot is filled
+	} Entry;
+
+private:
+	std::vector<Entry> m_entries;	//Always empty or a power of two in size
+	uint32_t m_count;
+
+	static uint64_t mix(uint64_t id);
+	void rehash(uint32_t capacity);
+
+public:
+	PakIndex();
+
+	void clear();
+
+	//Make sure numEntries entries total will fit without rehashing
+	void reserve(uint32_t numEntries);
+
+	//Add a resource to the index. If the ID is already in here, it's overwritten; in that case
+	// this returns false and (if prevPak isn't NULL) fills in the pak of the entry it replaced.
+	bool insert(uint64_t id, uint64_t offset, uint32_t pak, uint32_t* prevPak = NULL);
+
+	//Find a resource by ID. Returns NULL if it's not in here.
+	const Entry* find(uint64_t id) const;
+
+	uint32_t size() const	{return m_count;};
+};
@@ -1,11 +1,91 @@
 #include "PakLoader.h"
+#include "MappedFile.h"
+#include "TaskRunner.h"
+#include "ResourceAllocator.h"
 #include "wfLZ.h"
 #include "easylogging++.h"
 #include "Parse.h"
 #include "FileOperations.h"
 #include <sstream>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 using namespace std;
 
+//Read from an absolute position in a file without touching the shared file position, so that
+// any number of threads can read from the same FILE* at once
+static bool readAt(FILE* fp, void* buf, size_t len, uint64_t offset)
+{
+#ifdef _WIN32
+	HANDLE hFile = (HANDLE)_get_osfhandle(_fileno(fp));
+	unsigned char* out = (unsigned char*)buf;
+	while(len)
+	{
+		OVERLAPPED ov;
+		memset(&ov, 0, sizeof(OVERLAPPED));
+		ov.Offset = (DWORD)(offset & 0xFFFFFFFF);
+		ov.OffsetHigh = (DWORD)(offset >> 32);
+		DWORD toRead = (len > 0x40000000) ? 0x40000000 : (DWORD)len;
+		DWORD numRead = 0;
+		if(!ReadFile(hFile, out, toRead, &numRead, &ov) || !numRead)
+			return false;
+		out += numRead;
+		offset += numRead;
+		len -= numRead;
+	}
+	return true;
+#else
+	int fd = fileno(fp);
+	unsigned char* out = (unsigned char*)buf;
+	while(len)
+	{
+		ssize_t numRead = pread(fd, out, len, (off_t)offset);
+		if(numRead <= 0)
+			return false;
+		out += numRead;
+		offset += numRead;
+		len -= numRead;
+	}
+	return true;
+#endif
+}
+
+#define SCRATCH_KEEP_SIZE	(4*1024*1024)	//Per-thread scratch buffers bigger than this are given back after use
+
+//Buffer for compressed bytes read from disk, reused by every load on this thread
+static unsigned char* scratchBuffer(vector<unsigned char>& scratch, size_t len)
+{
+	if(scratch.size() < len)
+		scratch.resize(len);
+	return &scratch[0];
+}
+
+static void releaseScratch(vector<unsigned char>& scratch)
+{
+	//One huge resource shouldn't pin that much memory on every loading thread forever
+	if(scratch.size() > SCRATCH_KEEP_SIZE)
+		vector<unsigned char>().swap(scratch);
+}
+
+static unsigned char* allocate(ResourceAllocator* allocator, size_t len)
+{
+	if(allocator)
+		return allocator->alloc(len);
+	return new unsigned char[len];
+}
+
+static void deallocate(ResourceAllocator* allocator, unsigned char* data)
+{
+	if(!allocator)
+		delete[] data;	//Allocator memory is the allocator's problem
+}
+
 void PakLoader::loadFromDir(string sDirName)
 {
 	set<string> pakFiles = FileOperations::readFilesFromDir(sDirName);
@@ -17,8 +97,10 @@ void PakLoader::loadFromDir(string sDirName)
 	}
 }
 
-PakLoader::PakLoader(string sDirName)
+PakLoader::PakLoader(string sDirName, bool bMemoryMap)
 {
+	m_bMemoryMap = bMemoryMap;
+	m_taskRunner = NULL;
 	loadFromDir(sDirName);
 }
 
@@ -29,82 +111,315 @@ PakLoader::~PakLoader()
 
 void PakLoader::clear()
 {
-	for(list<FILE*>::iterator i = openedFiles.begin(); i != openedFiles.end(); i++)
-		fclose(*i);	//Close all our opened files
+	for(vector<PakFile*>::iterator i = openedFiles.begin(); i != openedFiles.end(); i++)
+	{
+		//Close all our opened files
+		if((*i)->fp)
+			fclose((*i)->fp);
+		delete (*i)->map;
+		delete *i;
+	}
 
 	openedFiles.clear();
-	m_pakFiles.clear();
+	m_index.clear();
+	m_contentIDs.clear();
 }
 
 void PakLoader::parseFile(string sFileName)
 {
 	LOG(TRACE) << "Parse pak file " << sFileName;
-	FILE* fp = fopen(sFileName.c_str(), "rb");
-	if(fp)
+	PakFile* pak = new PakFile;
+	pak->fp = NULL;
+	pak->map = NULL;
+	pak->filename = sFileName;
+	pak->version = VERSION_1_0;
+	pak->alignment = 1;
+
+	if(m_bMemoryMap)
 	{
-		//Try to read in file header
-		PakFileHeader header;
-		if(fread(&header, 1, sizeof(PakFileHeader), fp) != sizeof(PakFileHeader))
+		pak->map = new MappedFile();
+		if(!pak->map->open(sFileName))
 		{
-			LOG(TRACE) << "couldn't read header";
-			fclose(fp);
-			return;
+			LOG(TRACE) << "unable to map file; falling back to file reads";
+			delete pak->map;
+			pak->map = NULL;
 		}
+	}
 
-		//Check file signature
-		if(header.sig[0] != 'P' || header.sig[1] != 'A' || header.sig[2] != 'K' || header.sig[3] != 'C')
+	if(!pak->map)
+	{
+		pak->fp = fopen(sFileName.c_str(), "rb");
+		if(!pak->fp)
 		{
-			LOG(TRACE) << "sig incorrect";
-			fclose(fp);
+			LOG(TRACE) << "unable to open file";
+			delete pak;
 			return;
 		}
+	}
 
-		//Load ResourcePtrs
-		for(int i = 0; i < header.numResources; i++)
-		{
-			ResourcePtr resPtr;
-			if(fread(&resPtr, 1, sizeof(ResourcePtr), fp) != sizeof(ResourcePtr))
-			{
-				LOG(TRACE) << "couldn't read resptr";
-				fclose(fp);
-				return;
-			}
+	uint32_t pakIdx = openedFiles.size();
+	bool bParsed = pak->map ? parseMapped(pak, pakIdx) : parseStream(pak, pakIdx);
+	if(!bParsed)
+	{
+		if(pak->fp)
+			fclose(pak->fp);
+		delete pak->map;
+		delete pak;
+		return;
+	}
 
-			PakPtr pakPtr = {resPtr, fp};
-			m_pakFiles[resPtr.id] = pakPtr;
+	openedFiles.push_back(pak);	//Hang onto this to close later
+}
 
-		}
+bool PakLoader::checkHeader(const PakFileHeader& header, PakFile* pak)
+{
+	//Check file signature
+	if(header.sig[0] != 'P' || header.sig[1] != 'A' || header.sig[2] != 'K' || header.sig[3] != 'C')
+	{
+		LOG(TRACE) << "sig incorrect";
+		return false;
+	}
 
-		openedFiles.push_back(fp);	//Hang onto this to close later
+	pak->version = header.version;
+	if(header.version == VERSION_1_0)
+	{
+		pak->alignment = 1;	//Entries are packed back to back; nothing is guaranteed
+		return true;
 	}
-	else
-		LOG(TRACE) << "unable to open file";
+	if(header.version != VERSION_2)
+	{
+		LOG(WARNING) << "Unknown pak version " << header.version << " in " << pak->filename;
+		return false;
+	}
+
+	//Alignment must be a power of two no bigger than a page
+	if(header.alignment < PAK_DEFAULT_ALIGNMENT || header.alignment > PAK_MAX_ALIGNMENT || (header.alignment & (header.alignment - 1)))
+	{
+		LOG(WARNING) << "Invalid payload alignment " << header.alignment << " in " << pak->filename;
+		return false;
+	}
+	pak->alignment = header.alignment;
+	return true;
+}
+
+void PakLoader::checkFlags(const PakPtr& p, CompressionHeader* header)
+{
+	if(p.pak->version < VERSION_2)
+		header->flags = 0;	//Just padding in older paks
+	else if((header->flags & RESOURCE_FLAG_FINAL_LAYOUT) && header->compressionType != COMPRESSION_FLAGS_UNCOMPRESSED)
+	{
+		LOG(WARNING) << "Compressed resource ID " << p.ptr.id << " in " << p.pak->filename << " is flagged as final layout; ignoring flag";
+		header->flags &= ~RESOURCE_FLAG_FINAL_LAYOUT;
+	}
+}
+
+bool PakLoader::parseMapped(PakFile* pak, uint32_t pakIdx)
+{
+	const unsigned char* data = pak->map->data();
+	uint64_t size = pak->map->size();
+
+	//Try to read in file header
+	PakFileHeader header;
+	if(size < sizeof(PakFileHeader))
+	{
+		LOG(TRACE) << "couldn't read header";
+		return false;
+	}
+	memcpy(&header, data, sizeof(PakFileHeader));
+
+	if(!checkHeader(header, pak))
+		return false;
+
+	//Load ResourcePtrs
+	if(size < sizeof(PakFileHeader) + (uint64_t)header.numResources * sizeof(ResourcePtr))
+	{
+		LOG(TRACE) << "couldn't read resptr";
+		return false;
+	}
+
+	//Table directly follows the 16-byte header, so it's suitably aligned inside the mapping
+	addResources((const ResourcePtr*)(data + sizeof(PakFileHeader)), header.numResources, pak, pakIdx);
+	return true;
 }
 
-unsigned char* PakLoader::loadResource(uint64_t id, unsigned int* len)
+bool PakLoader::parseStream(PakFile* pak, uint32_t pakIdx)
+{
+	//Try to read in file header
+	PakFileHeader header;
+	if(fread(&header, 1, sizeof(PakFileHeader), pak->fp) != sizeof(PakFileHeader))
+	{
+		LOG(TRACE) << "couldn't read header";
+		return false;
+	}
+
+	if(!checkHeader(header, pak))
+		return false;
+
+	//Load ResourcePtrs all in one go
+	if(!header.numResources)
+		return true;
+
+	vector<ResourcePtr> resPtrs(header.numResources);
+	if(fread(&resPtrs[0], sizeof(ResourcePtr), header.numResources, pak->fp) != header.numResources)
+	{
+		LOG(TRACE) << "couldn't read resptr";
+		return false;
+	}
+
+	addResources(&resPtrs[0], header.numResources, pak, pakIdx);
+	return true;
+}
+
+void PakLoader::addResources(const ResourcePtr* resPtrs, uint32_t numResources, PakFile* pak, uint32_t pakIdx)
+{
+	m_index.reserve(m_index.size() + numResources);
+	map<uint64_t, uint64_t> firstAtOffset;	//Deduplicated entries share an offset
+	for(uint32_t i = 0; i < numResources; i++)
+	{
+		m_contentIDs.erase(resPtrs[i].id);	//In case this overrides one from an earlier pak
+		pair<map<uint64_t, uint64_t>::iterator, bool> first = firstAtOffset.insert(make_pair(resPtrs[i].offset, resPtrs[i].id));
+		if(!first.second && first.first->second != resPtrs[i].id)
+			m_contentIDs[resPtrs[i].id] = first.first->second;
+
+		uint32_t prevPak;
+		if(!m_index.insert(resPtrs[i].id, resPtrs[i].offset, pakIdx, &prevPak))
+		{
+			//Later entries win, same as always, but don't let it happen silently; this is either
+			// an intentional override from a later pak or two resource names hashing the same
+			const string& prevName = (prevPak == pakIdx) ? pak->filename : openedFiles[prevPak]->filename;
+			LOG(WARNING) << "Resource ID " << resPtrs[i].id << " in " << pak->filename << " collides with one in " << prevName << "; using the one in " << pak->filename;
+		}
+	}
+}
+
+bool PakLoader::findResource(uint64_t id, PakPtr* p) const
+{
+	const PakIndex::Entry* e = m_index.find(id);
+	if(!e)
+		return false;
+
+	p->ptr.id = e->id;
+	p->ptr.offset = e->offset;
+	p->pak = openedFiles[e->pak];
+	return true;
+}
+
+unsigned char* PakLoader::loadResource(uint64_t id, unsigned int* len, ResourceAllocator* allocator)
 {
 	LOG(TRACE) << "load resource with id " << id;
-	map<uint64_t, PakPtr>::iterator it = m_pakFiles.find(id);
-	if(it == m_pakFiles.end())
+	PakPtr p;
+	if(!findResource(id, &p))
 	{
 		LOG(TRACE) << "resource was not in pak files";
 		return NULL;
 	}
 
-	//Load resource
-	if(fseek(it->second.fp, it->second.ptr.offset, SEEK_SET))
+	if(p.pak->map)
+		return loadMapped(p, len, allocator);
+	return loadStream(p, len, allocator);
+}
+
+const unsigned char* PakLoader::getResourceView(uint64_t id, unsigned int* len, unsigned int alignment, bool* bFinalLayout)
+{
+	PakPtr p;
+	if(!findResource(id, &p) || !p.pak->map)
+		return NULL;
+
+	CompressionHeader compHeader;
+	const unsigned char* payload = mappedPayload(p, &compHeader);
+	if(!payload || compHeader.compressionType != COMPRESSION_FLAGS_UNCOMPRESSED)
+		return NULL;
+
+	//Mappings start on a page boundary, so this only fails for older paks or absurd alignments
+	if(alignment > 1 && ((uintptr_t)payload & (alignment - 1)))
+	{
+		LOG(TRACE) << "resource data not aligned to " << alignment << "; needs a copy";
+		return NULL;
+	}
+
+	if(len)
+		*len = compHeader.decompressedSize;
+	if(bFinalLayout)
+		*bFinalLayout = (compHeader.flags & RESOURCE_FLAG_FINAL_LAYOUT) != 0;
+	return payload;
+}
+
+const unsigned char* PakLoader::mappedPayload(const PakPtr& p, CompressionHeader* header)
+{
+	const unsigned char* data = p.pak->map->data();
+	uint64_t size = p.pak->map->size();
+
+	if(p.ptr.offset > size || size - p.ptr.offset < sizeof(CompressionHeader))
+	{
+		LOG(WARNING) << "Resource offset out of range for resource ID " << p.ptr.id;
+		return NULL;
+	}
+	memcpy(header, data + p.ptr.offset, sizeof(CompressionHeader));
+	checkFlags(p, header);
+
+	//Same rules as the file-read path: uncompressed resources may omit their decompressed size
+	if(header->compressionType == COMPRESSION_FLAGS_UNCOMPRESSED && !header->decompressedSize)
+		header->decompressedSize = header->compressedSize;
+
+	uint64_t payloadOffset = p.ptr.offset + sizeof(CompressionHeader);
+	uint64_t payloadSize = header->compressedSize;
+	if(header->compressionType == COMPRESSION_FLAGS_UNCOMPRESSED)
+		payloadSize = header->decompressedSize;
+	if(size - payloadOffset < payloadSize)
 	{
-		LOG(WARNING) << "Unable to seek to proper location in resource file for resource ID " << id;
+		LOG(WARNING) << "Resource data truncated for resource ID " << p.ptr.id;
 		return NULL;
 	}
+	return data + payloadOffset;
+}
+
+unsigned char* PakLoader::loadMapped(const PakPtr& p, unsigned int* len, ResourceAllocator* allocator)
+{
+	CompressionHeader compHeader;
+	const unsigned char* payload = mappedPayload(p, &compHeader);
+	if(!payload)
+		return NULL;
+
+	if(compHeader.compressionType == COMPRESSION_FLAGS_UNCOMPRESSED)
+	{
+		//Make sure we don't have an empty resource
+		if(!compHeader.decompressedSize)
+		{
+			LOG(TRACE) << "compressed size 0";
+			return NULL;
+		}
+
+		unsigned char* uncompressedData = allocate(allocator, compHeader.decompressedSize);
+		if(!uncompressedData)
+			return NULL;
+		memcpy(uncompressedData, payload, compHeader.decompressedSize);
+
+		if(len)
+			*len = compHeader.decompressedSize;
+
+		LOG(TRACE) << "all good uncompressed (mapped)";
+		return uncompressedData;
+	}
+
+	//Decompress straight out of the mapping; no intermediate copy of the compressed bytes
+	return decompress(compHeader, payload, p.ptr.id, len, allocator);
+}
+
+unsigned char* PakLoader::loadStream(const PakPtr& p, unsigned int* len, ResourceAllocator* allocator)
+{
+	uint64_t id = p.ptr.id;
+	FILE* fp = p.pak->fp;
+	uint64_t offset = p.ptr.offset;
 
 	//Read file
 	CompressionHeader compHeader;
-	if(fread(&compHeader, 1, sizeof(CompressionHeader), it->second.fp) != sizeof(CompressionHeader))
+	if(!readAt(fp, &compHeader, sizeof(CompressionHeader), offset))
 	{
-		LOG(TRACE) << "couldn\'t read compression header";
+		LOG(WARNING) << "Unable to read compression header from resource file for resource ID " << id;
 		return NULL;
 	}
+	offset += sizeof(CompressionHeader);
+	checkFlags(p, &compHeader);
 
 	if(compHeader.compressionType == COMPRESSION_FLAGS_UNCOMPRESSED)
 	{
@@ -116,14 +431,16 @@ unsigned char* PakLoader::loadResource(uint64_t id, unsigned int* len)
 				LOG(TRACE) << "compressed size 0";
 				return NULL;
 			}
-			
+
 			compHeader.decompressedSize = compHeader.compressedSize;
 		}
 
-		unsigned char* uncompressedData = new unsigned char[compHeader.decompressedSize];
-		if(fread(uncompressedData, 1, compHeader.decompressedSize, it->second.fp) != compHeader.decompressedSize)
+		unsigned char* uncompressedData = allocate(allocator, compHeader.decompressedSize);
+		if(!uncompressedData)
+			return NULL;
+		if(!readAt(fp, uncompressedData, compHeader.decompressedSize, offset))
 		{
-			delete[] uncompressedData;
+			deallocate(allocator, uncompressedData);
 			return NULL;
 		}
 
@@ -133,43 +450,153 @@ unsigned char* PakLoader::loadResource(uint64_t id, unsigned int* len)
 		LOG(TRACE) << "all good uncompressed";
 		return uncompressedData;
 	}
-	else if(compHeader.compressionType == COMPRESSION_FLAGS_WFLZ)
+	else if(compHeader.compressionType == COMPRESSION_FLAGS_WFLZ || compHeader.compressionType == COMPRESSION_FLAGS_WFLZ_CHUNKED)
 	{
 		if(!compHeader.compressedSize)
 			return NULL;
 
-		unsigned char* compressedData = new unsigned char[compHeader.compressedSize];
-		if(fread(compressedData, 1, compHeader.compressedSize, it->second.fp) != compHeader.compressedSize)
-		{
+		static thread_local vector<unsigned char> scratch;
+		unsigned char* compressedData = scratchBuffer(scratch, compHeader.compressedSize);
+		unsigned char* decompressedData = NULL;
+		if(!readAt(fp, compressedData, compHeader.compressedSize, offset))
 			LOG(TRACE) << "couldn\'t read compressed data";
-			delete[] compressedData;
-			return NULL;
-		}
+		else
+			decompressedData = decompress(compHeader, compressedData, id, len, allocator);
+		releaseScratch(scratch);
+		return decompressedData;
+	}
 
-		//If for some reason we don't have the decompressed size, generate it now
-		if(!compHeader.decompressedSize)
-			compHeader.decompressedSize = wfLZ_GetDecompressedSize(compressedData);
+	LOG(WARNING) << "Unknown compression header type " << compHeader.compressionType;
+	return NULL;
+}
 
-		if(!compHeader.decompressedSize)
-		{
-			LOG(TRACE) << "decompressed size wrong";
-			delete[] compressedData;
-			return NULL;
-		}
+unsigned char* PakLoader::decompress(CompressionHeader compHeader, const unsigned char* compressed, uint64_t id, unsigned int* len, ResourceAllocator* allocator)
+{
+	if(compHeader.compressionType != COMPRESSION_FLAGS_WFLZ && compHeader.compressionType != COMPRESSION_FLAGS_WFLZ_CHUNKED)
+	{
+		LOG(WARNING) << "Unknown compression header type " << compHeader.compressionType;
+		return NULL;
+	}
 
-		//Allocate memory and decompress
-		unsigned char* decompressedData = new unsigned char[compHeader.decompressedSize];
-		wfLZ_Decompress(compressedData, decompressedData);
+	if(!compHeader.compressedSize)
+		return NULL;
 
-		//Clean up
-		if(len)
-			*len = compHeader.decompressedSize;
+	//If for some reason we don't have the decompressed size, generate it now
+	if(!compHeader.decompressedSize)
+		compHeader.decompressedSize = wfLZ_GetDecompressedSize(compressed);
 
-		LOG(TRACE) << "all good wflz";
-		delete[] compressedData;
-		return decompressedData;
+	if(!compHeader.decompressedSize)
+	{
+		LOG(TRACE) << "decompressed size wrong";
+		return NULL;
 	}
 
-	LOG(WARNING) << "Unknown compression header type " << compHeader.compressionType;
-	return NULL;
+	//Allocate memory and decompress
+	unsigned char* decompressedData = allocate(allocator, compHeader.decompressedSize);
+	if(!decompressedData)
+		return NULL;
+	if(compHeader.compressionType == COMPRESSION_FLAGS_WFLZ)
+		wfLZ_Decompress(compressed, decompressedData);
+	else if(!decompressChunked(compressed, compHeader.compressedSize, decompressedData, compHeader.decompressedSize))
+	{
+		LOG(WARNING) << "Malformed chunked data for resource ID " << id;
+		deallocate(allocator, decompressedData);
+		return NULL;
+	}
+
+	if(len)
+		*len = compHeader.decompressedSize;
+
+	LOG(TRACE) << "all good wflz";
+	return decompressedData;
+}
+
+//wfLZ_ChunkCompress() output: this header, then a uint32_t offset for each chunk (from the start
+// of this header), then the chunks themselves; each one a regular wfLZ block.
+typedef struct
+{
+	char sig[4];	//ZLFW
+	uint32_t compressedSize;
+	uint32_t decompressedSize;
+	uint32_t numChunks;
+} ChunkedHeader;
+
+#define WFLZ_BLOCK_HEADER_SIZE	16	//Enough to read a chunk's sizes
+
+typedef struct
+{
+	const unsigned char* in;
+	unsigned char* out;
+	std::vector<uint32_t> inOffsets;
+	std::vector<uint32_t> outOffsets;
+} ChunkedJob;
+
+static void decompressChunk(uint32_t idx, void* data)
+{
+	ChunkedJob* job = (ChunkedJob*)data;
+	wfLZ_Decompress(job->in + job->inOffsets[idx], job->out + job->outOffsets[idx]);
+}
+
+bool PakLoader::decompressChunked(const unsigned char* in, uint32_t compressedSize, unsigned char* out, uint32_t decompressedSize)
+{
+	if(compressedSize < sizeof(ChunkedHeader))
+		return false;
+
+	ChunkedHeader header;
+	memcpy(&header, in, sizeof(ChunkedHeader));
+	if(header.sig[0] != 'Z' || header.sig[1] != 'L' || header.sig[2] != 'F' || header.sig[3] != 'W' || !header.numChunks)
+		return false;
+	if((uint64_t)header.numChunks * sizeof(uint32_t) > compressedSize - sizeof(ChunkedHeader))
+		return false;
+
+	//Work out where each chunk comes from and goes to, and make sure it all fits
+	ChunkedJob job;
+	job.in = in;
+	job.out = out;
+	job.inOffsets.resize(header.numChunks);
+	job.outOffsets.resize(header.numChunks);
+	memcpy(&job.inOffsets[0], in + sizeof(ChunkedHeader), header.numChunks * sizeof(uint32_t));
+
+	uint64_t outOffset = 0;
+	for(uint32_t i = 0; i < header.numChunks; i++)
+	{
+		uint32_t inOffset = job.inOffsets[i];
+		if(inOffset > compressedSize || compressedSize - inOffset < WFLZ_BLOCK_HEADER_SIZE)
+			return false;
+		const unsigned char* chunk = in + inOffset;
+		if(chunk[0] != 'W')
+			return false;	//Each chunk should be a plain WFLZ block
+		uint32_t chunkCompressed = wfLZ_GetCompressedSize(chunk);
+		uint32_t chunkDecompressed = wfLZ_GetDecompressedSize(chunk);
+		if(!chunkCompressed || chunkCompressed > compressedSize - inOffset)
+			return false;
+
+		job.outOffsets[i] = (uint32_t)outOffset;
+		outOffset += chunkDecompressed;
+	}
+	if(outOffset != decompressedSize)
+		return false;
+
+	if(m_taskRunner && header.numChunks > 1)
+		m_taskRunner->parallelFor(decompressChunk, &job, header.numChunks);
+	else
+	{
+		for(uint32_t i = 0; i < header.numChunks; i++)
+			decompressChunk(i, &job);
+	}
+	return true;
+}
+
+uint64_t PakLoader::getContentID(uint64_t id) const
+{
+	map<uint64_t, uint64_t>::const_iterator i = m_contentIDs.find(id);
+	if(i == m_contentIDs.end())
+		return id;
+
+	//A later pak may have overridden the one it shared with
+	const PakIndex::Entry* entry = m_index.find(id);
+	const PakIndex::Entry* shared = m_index.find(i->second);
+	if(!entry || !shared || entry->pak != shared->pak || entry->offset != shared->offset)
+		return id;
+	return i->second;
 }
@@ -1,36 +1,93 @@
 #pragma once
 #include <stdio.h>
 #include <inttypes.h>
-#include <map>
 #include <string>
-#include <list>
+#include <vector>
+#include <map>
 #include "ResourceTypes.h"
+#include "PakIndex.h"
 
 #define PAK_FILE_TYPE "pak"
 
+class MappedFile;
+class TaskRunner;
+class ResourceAllocator;
+
 class PakLoader
 {
+	typedef struct
+	{
+		FILE* fp;			//NULL if this pak is memory-mapped. Only read with positional reads after parsing
+		MappedFile* map;	//NULL if this pak is read through fp
+		std::string filename;
+		uint32_t version;	//VERSION_1_0 or VERSION_2
+		uint32_t alignment;	//Payload alignment guaranteed by the file; 1 for VERSION_1_0 paks
+	} PakFile;
+
 	typedef struct
 	{
 		ResourcePtr ptr;
-		FILE* fp;
+		PakFile* pak;
 	} PakPtr;
 
-	std::map<uint64_t, PakPtr> m_pakFiles;	//Maps resource IDs to particular pak files
-	std::list<FILE*> openedFiles;			//Keeps track of all opened file handles so we can close them easily
+	PakIndex m_index;						//Maps resource IDs to particular pak files
+	std::vector<PakFile*> openedFiles;		//All opened paks, indexed by PakIndex::Entry::pak
+	std::map<uint64_t, uint64_t> m_contentIDs;	//IDs sharing an earlier ID's entry, to that ID. Only holds duplicates
+	bool m_bMemoryMap;
+	TaskRunner* m_taskRunner;
 
 	void parseFile(std::string sFileName);
+	bool checkHeader(const PakFileHeader& header, PakFile* pak);
+	void checkFlags(const PakPtr& p, CompressionHeader* header);
+	bool parseMapped(PakFile* pak, uint32_t pakIdx);
+	bool parseStream(PakFile* pak, uint32_t pakIdx);
+	void addResources(const ResourcePtr* resPtrs, uint32_t numResources, PakFile* pak, uint32_t pakIdx);
+	bool findResource(uint64_t id, PakPtr* p) const;
+
+	//Find the payload of a resource inside a mapped pak. Returns NULL if out of bounds.
+	const unsigned char* mappedPayload(const PakPtr& p, CompressionHeader* header);
+	unsigned char* loadMapped(const PakPtr& p, unsigned int* len, ResourceAllocator* allocator);
+	unsigned char* loadStream(const PakPtr& p, unsigned int* len, ResourceAllocator* allocator);
+	unsigned char* decompress(CompressionHeader compHeader, const unsigned char* compressed, uint64_t id, unsigned int* len, ResourceAllocator* allocator);
+	bool decompressChunked(const unsigned char* in, uint32_t compressedSize, unsigned char* out, uint32_t decompressedSize);
 
 	PakLoader() {};
 
 public:
-	PakLoader(std::string sDirName);
+	//Thread safety: once the paks are opened, loadResource() and getResourceView() may be called
+	// from any number of threads at once. Index lookups take no locks, and pak data is read with
+	// positional reads (or straight from the mapping) so no file position is shared between loads.
+	// clear() and loadFromDir() modify the index and must not run concurrently with anything else.
+
+	//If bMemoryMap is set, each pak is mapped into memory once instead of being read piecemeal
+	// (falls back to regular file reads for any pak that can't be mapped)
+	PakLoader(std::string sDirName, bool bMemoryMap = false);
 	~PakLoader();
 
 	void clear();
 	void loadFromDir(std::string sDirName);
 
+	//Chunked resources are decompressed a chunk per task through this, if set. Without one,
+	// chunks are decompressed one after another on the calling thread.
+	void setTaskRunner(TaskRunner* runner)	{m_taskRunner = runner;};
+
 	//Load a resource from the opened pak files. Returns NULL if it's not here or on error,
-	// returns a pointer to the data otherwise. This pointer must be free()d.
-	unsigned char* loadResource(uint64_t id, unsigned int* len = NULL);
-};
\ No newline at end of file
+	// returns a pointer to the data otherwise. Without an allocator, this pointer is new[]ed and
+	// must be delete[]d. With one, the data goes into memory from allocator->alloc() and belongs
+	// to the allocator. Compressed bytes read from disk go through a per-thread scratch buffer
+	// either way, so the only allocation is the one for the decompressed data.
+	unsigned char* loadResource(uint64_t id, unsigned int* len = NULL, ResourceAllocator* allocator = NULL);
+
+	//Get a read-only pointer straight into a memory-mapped pak, without copying. Only works for
+	// uncompressed resources in mapped paks whose data starts on a multiple of alignment (always
+	// the case up to the pak's own alignment for VERSION_2 paks); returns NULL otherwise (use
+	// loadResource() instead). If bFinalLayout is given, it's set if the resource was flagged
+	// RESOURCE_FLAG_FINAL_LAYOUT when the pak was built.
+	// The pointer must NOT be freed, and is only valid until clear() is called.
+	const unsigned char* getResourceView(uint64_t id, unsigned int* len = NULL, unsigned int alignment = 1, bool* bFinalLayout = NULL);
+
+	//The compressor stores files with identical data once, with each of their IDs pointing at the
+	// same entry. Those IDs all have the same content ID (the first of them in the pak), so whatever
+	// gets built from the data can be shared. Any other ID, in a pak or not, is its own content ID.
+	uint64_t getContentID(uint64_t id) const;
+};
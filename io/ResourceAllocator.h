@@ -0,0 +1,25 @@
+#pragma once
+#include <stddef.h>
+
+//Where PakLoader puts the data it loads, for callers that don't want a new[] per resource
+class ResourceAllocator
+{
+public:
+	virtual ~ResourceAllocator() {};
+
+	//Return a buffer of at least len bytes, or NULL to fail the load. Whatever's returned stays
+	// owned by the allocator; PakLoader never frees it, even if the load fails afterwards.
+	virtual unsigned char* alloc(size_t len) = 0;
+};
+
+//Loads straight into a buffer the caller already has. Anything that doesn't fit fails to load.
+class BufferAllocator : public ResourceAllocator
+{
+	unsigned char* m_buf;
+	size_t m_len;
+
+public:
+	BufferAllocator(unsigned char* buf, size_t len)	{m_buf = buf; m_len = len;};
+
+	unsigned char* alloc(size_t len)	{return (len <= m_len) ? m_buf : NULL;};
+};
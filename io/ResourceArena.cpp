@@ -0,0 +1,66 @@
+#include "ResourceArena.h"
+using namespace std;
+
+ResourceArena::ResourceArena(size_t blockSize, size_t keepSize)
+{
+	m_used = 0;
+	m_blockSize = blockSize;
+	m_keepSize = keepSize;
+}
+
+ResourceArena::~ResourceArena()
+{
+	for(vector<Block>::iterator i = m_blocks.begin(); i != m_blocks.end(); i++)
+		delete[] i->data;
+}
+
+unsigned char* ResourceArena::alloc(size_t len)
+{
+	size_t offset = (m_used + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+	if(m_blocks.empty() || offset > m_blocks.back().size || m_blocks.back().size - offset < len)
+	{
+		//Doesn't fit; start a new block big enough for this
+		Block b;
+		b.size = (len > m_blockSize) ? len : m_blockSize;
+		b.data = new unsigned char[b.size];
+		m_blocks.push_back(b);
+		offset = 0;
+	}
+
+	m_used = offset + len;
+	return m_blocks.back().data + offset;
+}
+
+void ResourceArena::reset()
+{
+	if(m_blocks.empty())
+		return;
+
+	//Hang onto the biggest block we're allowed to; next time around everything probably fits in it
+	Block keep;
+	keep.data = NULL;
+	keep.size = 0;
+	for(vector<Block>::iterator i = m_blocks.begin(); i != m_blocks.end(); i++)
+	{
+		if(i->size > keep.size && i->size <= m_keepSize)
+			keep = *i;
+	}
+
+	for(vector<Block>::iterator i = m_blocks.begin(); i != m_blocks.end(); i++)
+	{
+		if(i->data != keep.data)
+			delete[] i->data;
+	}
+	m_blocks.clear();
+	if(keep.data)
+		m_blocks.push_back(keep);
+	m_used = 0;
+}
+
+size_t ResourceArena::capacity()
+{
+	size_t total = 0;
+	for(vector<Block>::iterator i = m_blocks.begin(); i != m_blocks.end(); i++)
+		total += i->size;
+	return total;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include "ResourceAllocator.h"
+
+#define ARENA_DEFAULT_BLOCK_SIZE	(1024*1024)
+#define ARENA_DEFAULT_KEEP_SIZE		(16*1024*1024)
+#define ARENA_ALIGNMENT				16
+
+//Bump allocator for short-lived resource data: allocations are carved out of large blocks and
+// all freed at once by reset(). The biggest block (up to keepSize) is kept around between resets,
+// so a steady stream of loads stops touching the heap once it has warmed up. Not thread-safe;
+// use one per thread.
+class ResourceArena : public ResourceAllocator
+{
+	typedef struct
+	{
+		unsigned char* data;
+		size_t size;
+	} Block;
+
+	std::vector<Block> m_blocks;	//Last one is the one being allocated from
+	size_t m_used;					//Bytes used in the last block
+	size_t m_blockSize;
+	size_t m_keepSize;
+
+	ResourceArena(const ResourceArena&);
+	ResourceArena& operator=(const ResourceArena&);
+
+public:
+	ResourceArena(size_t blockSize = ARENA_DEFAULT_BLOCK_SIZE, size_t keepSize = ARENA_DEFAULT_KEEP_SIZE);
+	~ResourceArena();
+
+	unsigned char* alloc(size_t len);
+
+	//Free everything allocated so far
+	void reset();
+
+	//Size of the memory currently held, used or not
+	size_t capacity();
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+
+//Resource IDs are the djb2 hash of the resource's path (from http://stackoverflow.com/a/13487193).
+// Anything that turns a path into an ID - the engine, the pak compressor, tools - goes through here,
+// so the IDs baked into paks always match the ones the game looks up.
+namespace ResourceHash
+{
+	//Usable at compile time; see RES_ID() below
+	constexpr uint64_t hash(const char* str, uint64_t hash = 5381)
+	{
+		return *str ? ResourceHash::hash(str + 1, ((hash << 5) + hash) + (uint64_t)(int)*str) : hash;
+	}
+
+	inline uint64_t hash(const std::string& sHashStr)
+	{
+		const char* str = sHashStr.c_str();
+		uint64_t hash = 5381;
+		int c;
+
+		while((c = *str++))
+			hash = ((hash << 5) + hash) + c;
+
+		return hash;
+	}
+}
+
+//ID of a resource path given as a string literal, worked out by the compiler, e.g. RES_ID("res/gfx/foo.png")
+#define RES_ID(path) (std::integral_constant<uint64_t, ResourceHash::hash(path)>::value)
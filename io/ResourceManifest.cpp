@@ -0,0 +1,71 @@
+#include "ResourceManifest.h"
+#include "easylogging++.h"
+#include <sstream>
+#include <fstream>
+using namespace std;
+
+static const char* g_typeNames[] = {"img", "mesh", "particles", "obj"};
+#define NUM_MANIFEST_TYPES	(sizeof(g_typeNames) / sizeof(g_typeNames[0]))
+
+namespace ResourceManifest
+{
+	string filenameFor(const string& sScene)
+	{
+		return sScene + ".manifest";
+	}
+
+	void parse(const char* data, unsigned int len, vector<ManifestEntry>* out)
+	{
+		istringstream iss(string(data, len));
+		string sLine;
+		while(getline(iss, sLine))
+		{
+			if(sLine.size() && sLine[sLine.size() - 1] == '\r')
+				sLine.erase(sLine.size() - 1);
+			if(sLine.empty() || sLine[0] == '#')
+				continue;
+
+			size_t space = sLine.find(' ');
+			if(space == string::npos)
+			{
+				LOG(WARNING) << "Malformed manifest line: " << sLine;
+				continue;
+			}
+
+			string sType = sLine.substr(0, space);
+			ManifestEntry entry;
+			entry.type = NUM_MANIFEST_TYPES;
+			for(uint32_t i = 0; i < NUM_MANIFEST_TYPES; i++)
+			{
+				if(sType == g_typeNames[i])
+					entry.type = i;
+			}
+			if(entry.type == NUM_MANIFEST_TYPES)
+			{
+				LOG(WARNING) << "Unknown manifest resource type " << sType;
+				continue;
+			}
+
+			entry.path = sLine.substr(space + 1);
+			out->push_back(entry);
+		}
+	}
+
+	bool write(const string& sFilename, const vector<ManifestEntry>& entries)
+	{
+		ofstream ofs(sFilename.c_str(), ios_base::out | ios_base::binary);
+		if(ofs.fail())
+		{
+			LOG(ERROR) << "Unable to open manifest " << sFilename << " for writing";
+			return false;
+		}
+
+		ofs << "# Resources in the order they were first used. Recorded by the engine; regenerate rather than edit" << endl;
+		for(vector<ManifestEntry>::const_iterator i = entries.begin(); i != entries.end(); i++)
+		{
+			if(i->type < NUM_MANIFEST_TYPES)
+				ofs << g_typeNames[i->type] << ' ' << i->path << endl;
+		}
+		return !ofs.fail();
+	}
+}
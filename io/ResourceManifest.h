@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//A manifest lists the resources a scene used, in the order they were first asked for. The engine
+// records them (see ResourceLoader::startRecording()) and prefetches from them the next time the
+// scene loads. They're text, one resource per line, type then path:
+//
+//	img res/gfx/ship.png
+//	obj res/obj/ship.xml
+//
+//Blank lines and lines starting with # are ignored.
+
+#define MANIFEST_IMAGE			0
+#define MANIFEST_MESH			1
+#define MANIFEST_PARTICLESYSTEM	2
+#define MANIFEST_OBJECT			3
+
+typedef struct
+{
+	uint32_t type;			//MANIFEST_*
+	std::string path;
+} ManifestEntry;
+
+namespace ResourceManifest
+{
+	std::string filenameFor(const std::string& sScene);	//Where a scene's manifest lives: <scene>.manifest
+
+	//Unknown types are skipped with a warning, so older engines can read newer manifests
+	void parse(const char* data, unsigned int len, std::vector<ManifestEntry>* out);
+	bool write(const std::string& sFilename, const std::vector<ManifestEntry>& entries);
+}
@@ -3,6 +3,10 @@
 #include <stdint.h>	//Use specific-sized ints for this
 
 #define VERSION_1_0		1
+#define VERSION_2		2	//Resource payloads are aligned to PakFileHeader::alignment, and CompressionHeader::flags is valid
+
+#define PAK_DEFAULT_ALIGNMENT	16		//Enough for anything we read straight out of a payload
+#define PAK_MAX_ALIGNMENT		4096	//Page alignment
 
 //------------------------------------
 // Header of the .pak file
@@ -10,9 +14,10 @@
 typedef struct
 {
 	char sig[4];		//PAKC in big endian for current version
-	uint32_t version;	//VERSION_1_0 for current version of the game
+	uint32_t version;	//VERSION_2 for current version of the game; VERSION_1_0 paks can still be read
 	uint32_t numResources;
-	uint32_t pad;
+	uint32_t alignment;	//VERSION_2: every payload (the data after a CompressionHeader) starts at a multiple
+						// of this from the start of the file. Power of two, 16 to PAK_MAX_ALIGNMENT. Padding in VERSION_1_0
 	//Followed by numResources ResourcePtrs
 } PakFileHeader;
 
@@ -33,13 +38,18 @@ typedef struct
 //--------------------------------------------------------------
 #define COMPRESSION_FLAGS_UNCOMPRESSED	0
 #define COMPRESSION_FLAGS_WFLZ			1
+#define COMPRESSION_FLAGS_WFLZ_CHUNKED	2	//wfLZ_ChunkCompress() output; chunks decompress independently
+
+#define RESOURCE_FLAG_FINAL_LAYOUT		0x1	//Uncompressed, and stored exactly the way it's used in memory, so it can be used in place from a mapped pak
+
+#define WFLZ_CHUNK_SIZE	(256*1024)	//Resources larger than this get compressed in chunks of this size (multiple of 16)
 
 typedef struct
 {
 	uint32_t compressionType;	//One of the compression flags above
 	uint32_t compressedSize;
 	uint32_t decompressedSize;
-	uint32_t pad;
+	uint32_t flags;				//VERSION_2: RESOURCE_FLAG_* bits. Padding in VERSION_1_0
 	//Followed by compressed data
 } CompressionHeader;
 
@@ -49,6 +59,7 @@ typedef struct
 //--------------------------------------------------------------
 #define TEXTURE_BPP_RGBA	32
 #define TEXTURE_BPP_RGB		24
+#define TEXTURE_BPP_ATLAS	0	//No pixels; the image was packed into an atlas page, and an AtlasRegion follows
 
 typedef struct
 {
@@ -59,3 +70,30 @@ typedef struct
 	//Followed by image data
 } TextureHeader;
 
+typedef struct
+{
+	uint32_t x, y;		//Upper left of the image within the page, in pixels
+	uint32_t pathLen;	//Length of the page's resource path
+	uint32_t pad;
+	//Followed by the page's path (not NUL-terminated). The page itself is an RGBA image
+} AtlasRegion;
+
+
+//--------------------------------------------------------------
+// Compiled XML - particle systems, objects, and mouse cursors
+//--------------------------------------------------------------
+#define COMPILED_XML_VERSION	1	//Bump whenever any record layout changes
+
+#define COMPILED_XML_PARTICLESYSTEM	1
+#define COMPILED_XML_OBJECT			2
+#define COMPILED_XML_CURSOR			3
+#define COMPILED_XML_SCENE			4
+
+typedef struct
+{
+	char sig[4];		//CXML. Anything else is XML text
+	uint32_t version;	//COMPILED_XML_VERSION
+	uint32_t type;		//One of the COMPILED_XML_ types above
+	uint32_t size;		//Bytes of record data following this header
+	//Followed by the record; see CompiledXML.cpp for the layout of each type
+} CompiledXMLHeader;
@@ -0,0 +1,16 @@
+#pragma once
+#include <inttypes.h>
+
+typedef void (*TaskFunc)(uint32_t idx, void* data);
+
+//Runs batches of independent tasks in parallel. io doesn't depend on any threading library, so
+// whoever owns the threads implements this and hands it to whatever needs it.
+class TaskRunner
+{
+public:
+	virtual ~TaskRunner() {};
+
+	//Call func(i, data) for every i from 0 to count-1, in any order and on any threads. Must not
+	// return until all of them are done. May be called from more than one thread at once.
+	virtual void parallelFor(TaskFunc func, void* data, uint32_t count) = 0;
+};
@@ -0,0 +1,156 @@
+#include "Atlas.h"
+#include "ResourceTypes.h"
+#include "stb_image.h"
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "stb_rect_pack.h"
+using namespace std;
+
+typedef struct
+{
+	string filename;
+	int width, height;
+} AtlasImage;
+
+static bool inAtlasDir(const string& filename, const vector<string>& dirs)
+{
+	for(vector<string>::const_iterator i = dirs.begin(); i != dirs.end(); i++)
+	{
+		if(filename.find(*i) == 0)
+			return true;
+	}
+	return false;
+}
+
+//Copy an RGBA image into the page, repeating its edge pixels out into the padding around it
+static void blit(const unsigned char* pixels, int width, int height, unsigned char* page, int pageWidth, int x, int y)
+{
+	for(int dy = -ATLAS_PADDING; dy < height + ATLAS_PADDING; dy++)
+	{
+		int sy = min(max(dy, 0), height - 1);
+		unsigned char* dest = &page[((y + dy) * pageWidth + x - ATLAS_PADDING) * 4];
+		for(int dx = -ATLAS_PADDING; dx < width + ATLAS_PADDING; dx++)
+		{
+			int sx = min(max(dx, 0), width - 1);
+			memcpy(dest, &pixels[(sy * width + sx) * 4], 4);
+			dest += 4;
+		}
+	}
+}
+
+static void regionRecord(const string& sPage, const stbrp_rect& rect, const AtlasImage& img, vector<unsigned char>* out)
+{
+	TextureHeader header;
+	header.bpp = TEXTURE_BPP_ATLAS;
+	header.width = img.width;
+	header.height = img.height;
+	header.pad = 0;
+
+	AtlasRegion region;
+	region.x = rect.x + ATLAS_PADDING;
+	region.y = rect.y + ATLAS_PADDING;
+	region.pathLen = sPage.size();
+	region.pad = 0;
+
+	out->resize(sizeof(TextureHeader) + sizeof(AtlasRegion) + sPage.size());
+	memcpy(&(*out)[0], &header, sizeof(TextureHeader));
+	memcpy(&(*out)[sizeof(TextureHeader)], &region, sizeof(AtlasRegion));
+	memcpy(&(*out)[sizeof(TextureHeader) + sizeof(AtlasRegion)], sPage.c_str(), sPage.size());
+}
+
+namespace Atlas
+{
+	void pack(const vector<string>& files, const vector<string>& dirs, const string& sPakBase, map<string, vector<unsigned char> >* generated, vector<string>* pages)
+	{
+		vector<AtlasImage> images;
+		for(vector<string>::const_iterator i = files.begin(); i != files.end(); i++)
+		{
+			if(i->find(".png") == string::npos || !inAtlasDir(*i, dirs))
+				continue;
+
+			AtlasImage img;
+			int comp = 0;
+			img.filename = *i;
+			if(!stbi_info(i->c_str(), &img.width, &img.height, &comp) || img.width > ATLAS_MAX_IMAGE || img.height > ATLAS_MAX_IMAGE)
+				continue;
+			images.push_back(img);
+		}
+
+		vector<stbrp_node> nodes(ATLAS_PAGE_SIZE);
+		vector<stbrp_rect> remaining;
+		for(unsigned int i = 0; i < images.size(); i++)
+		{
+			stbrp_rect rect;
+			rect.id = i;
+			rect.w = images[i].width + ATLAS_PADDING * 2;
+			rect.h = images[i].height + ATLAS_PADDING * 2;
+			remaining.push_back(rect);
+		}
+
+		unsigned int numPacked = 0;
+		while(remaining.size())
+		{
+			stbrp_context ctx;
+			stbrp_init_target(&ctx, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, &nodes[0], nodes.size());
+			stbrp_pack_rects(&ctx, &remaining[0], remaining.size());
+
+			vector<stbrp_rect> packed;
+			vector<stbrp_rect> next;
+			int pageHeight = 0;
+			for(vector<stbrp_rect>::iterator i = remaining.begin(); i != remaining.end(); i++)
+			{
+				if(i->was_packed)
+				{
+					packed.push_back(*i);
+					pageHeight = max(pageHeight, i->y + i->h);
+				}
+				else
+					next.push_back(*i);
+			}
+			remaining = next;
+
+			//A page with one image on it saves nothing
+			if(packed.size() < 2)
+				break;
+
+			ostringstream oss;
+			oss << sPakBase << "/atlas" << pages->size() << ".png";
+			string sPage = oss.str();
+
+			//Only as tall as it needs to be
+			vector<unsigned char>& page = (*generated)[sPage];
+			page.assign(sizeof(TextureHeader) + ATLAS_PAGE_SIZE * pageHeight * 4, 0);
+			TextureHeader header;
+			header.bpp = TEXTURE_BPP_RGBA;
+			header.width = ATLAS_PAGE_SIZE;
+			header.height = pageHeight;
+			header.pad = 0;
+			memcpy(&page[0], &header, sizeof(TextureHeader));
+
+			for(vector<stbrp_rect>::iterator i = packed.begin(); i != packed.end(); i++)
+			{
+				const AtlasImage& img = images[i->id];
+				int width, height, comp;
+				unsigned char* pixels = stbi_load(img.filename.c_str(), &width, &height, &comp, 4);
+				if(!pixels || width != img.width || height != img.height)
+				{
+					cout << "Unable to load image " << img.filename << " into atlas" << endl;
+					stbi_image_free(pixels);
+					continue;	//Leaves a hole in the page, but it still gets its own entry
+				}
+
+				blit(pixels, width, height, &page[sizeof(TextureHeader)], ATLAS_PAGE_SIZE, i->x + ATLAS_PADDING, i->y + ATLAS_PADDING);
+				stbi_image_free(pixels);
+				regionRecord(sPage, *i, img, &(*generated)[img.filename]);
+				numPacked++;
+			}
+			pages->push_back(sPage);
+		}
+
+		cout << "Packed " << numPacked << " of " << images.size() << " small images into " << pages->size() << " atlas pages" << endl;
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+
+#define ATLAS_PAGE_SIZE		2048	//Width and height of each atlas page, in pixels
+#define ATLAS_MAX_IMAGE		256		//Images bigger than this either way get their own texture
+#define ATLAS_PADDING		1		//Border around each image, copied from its edge pixels so filtering doesn't bleed
+
+//Packs small images into shared atlas pages. Each packed image's entry becomes an AtlasRegion
+// (see ResourceTypes.h) that the engine turns back into an Image, so nothing asking for an image by
+// path has to know. Atlased images can't be tiled, used as lattices or put on meshes, since their
+// texture coordinates only cover part of the page; that's why only images in directories asked for
+// get packed.
+namespace Atlas
+{
+	//Pack images among files that start with one of dirs. Fills generated with the new data for each
+	// packed image (by its path) and each page (by the path in pages). Pages are named after sPakBase.
+	void pack(const std::vector<std::string>& files, const std::vector<std::string>& dirs, const std::string& sPakBase, std::map<std::string, std::vector<unsigned char> >* generated, std::vector<std::string>* pages);
+}
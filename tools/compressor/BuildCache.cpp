@@ -0,0 +1,154 @@
+#include "BuildCache.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+using namespace std;
+
+#define LAYOUT_VERSION	1
+
+typedef struct
+{
+	char sig[4];	//PKLY
+	uint32_t version;
+	uint32_t numEntries;
+	uint32_t pad;
+	uint64_t dataStart;
+	uint64_t dataEnd;
+	//Followed by numEntries LayoutEntries
+} LayoutFileHeader;
+
+namespace BuildCache
+{
+	uint64_t fnv1a(const unsigned char* data, unsigned int len, uint64_t hash)
+	{
+		for(unsigned int i = 0; i < len; i++)
+		{
+			hash ^= data[i];
+			hash *= 0x100000001b3ULL;
+		}
+		return hash;
+	}
+
+	uint64_t contentKey(const string& sFilename, const unsigned char* data, unsigned int len, bool bInPlace)
+	{
+		//Build settings: anything that changes the output for the same input bytes
+		ostringstream oss;
+		oss << "v" << BUILD_CACHE_VERSION << " chunk" << WFLZ_CHUNK_SIZE;
+		if(sFilename.find(".png") != string::npos)
+			oss << " image";
+		if(sFilename.find(".xml") != string::npos)
+			oss << " xml" << COMPILED_XML_VERSION << " " << sFilename;	//Whether and how it's compiled depends on where it lives
+		if(bInPlace)
+			oss << " inplace";
+		string sSettings = oss.str();
+
+		uint64_t hash = fnv1a((const unsigned char*)sSettings.c_str(), sSettings.size());
+		return fnv1a(data, len, hash);
+	}
+
+	static string cacheFilename(uint64_t key)
+	{
+		ostringstream oss;
+		oss << BUILD_CACHE_DIR << "/" << hex << setw(16) << setfill('0') << key << ".bin";
+		return oss.str();
+	}
+
+	bool load(uint64_t key, CompressionHeader* header, unsigned char** data)
+	{
+		FILE* fp = fopen(cacheFilename(key).c_str(), "rb");
+		if(!fp)
+			return false;
+
+		if(fread(header, 1, sizeof(CompressionHeader), fp) != sizeof(CompressionHeader))
+		{
+			fclose(fp);
+			return false;
+		}
+
+		*data = (unsigned char*)malloc(header->compressedSize);
+		if(fread(*data, 1, header->compressedSize, fp) != header->compressedSize)
+		{
+			free(*data);
+			*data = NULL;
+			fclose(fp);
+			return false;
+		}
+
+		fclose(fp);
+		return true;
+	}
+
+	void store(uint64_t key, const CompressionHeader& header, const unsigned char* data)
+	{
+#ifdef _WIN32
+		_mkdir(BUILD_CACHE_DIR);
+#else
+		mkdir(BUILD_CACHE_DIR, 0755);
+#endif
+
+		//Write to a temp file first so an interrupted build can't leave a truncated entry behind
+		string sFilename = cacheFilename(key);
+		string sTemp = sFilename + ".tmp";
+		FILE* fp = fopen(sTemp.c_str(), "wb");
+		if(!fp)
+			return;
+
+		bool bOk = fwrite(&header, 1, sizeof(CompressionHeader), fp) == sizeof(CompressionHeader);
+		bOk = bOk && fwrite(data, 1, header.compressedSize, fp) == header.compressedSize;
+		fclose(fp);
+
+		remove(sFilename.c_str());
+		if(!bOk || rename(sTemp.c_str(), sFilename.c_str()))
+			remove(sTemp.c_str());
+	}
+
+	bool readLayout(const string& sPakFilename, PakLayout* layout)
+	{
+		FILE* fp = fopen((sPakFilename + ".layout").c_str(), "rb");
+		if(!fp)
+			return false;
+
+		LayoutFileHeader header;
+		if(fread(&header, 1, sizeof(LayoutFileHeader), fp) != sizeof(LayoutFileHeader) ||
+		   memcmp(header.sig, "PKLY", 4) || header.version != LAYOUT_VERSION)
+		{
+			fclose(fp);
+			return false;
+		}
+
+		layout->dataStart = header.dataStart;
+		layout->dataEnd = header.dataEnd;
+		layout->entries.resize(header.numEntries);
+		bool bOk = !header.numEntries || fread(&layout->entries[0], sizeof(LayoutEntry), header.numEntries, fp) == header.numEntries;
+		fclose(fp);
+		if(!bOk)
+			layout->entries.clear();
+		return bOk;
+	}
+
+	void writeLayout(const string& sPakFilename, const PakLayout& layout)
+	{
+		FILE* fp = fopen((sPakFilename + ".layout").c_str(), "wb");
+		if(!fp)
+			return;
+
+		LayoutFileHeader header;
+		memcpy(header.sig, "PKLY", 4);
+		header.version = LAYOUT_VERSION;
+		header.numEntries = layout.entries.size();
+		header.pad = 0;
+		header.dataStart = layout.dataStart;
+		header.dataEnd = layout.dataEnd;
+		fwrite(&header, 1, sizeof(LayoutFileHeader), fp);
+		if(layout.entries.size())
+			fwrite(&layout.entries[0], sizeof(LayoutEntry), layout.entries.size(), fp);
+		fclose(fp);
+	}
+}
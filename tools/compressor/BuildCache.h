@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <inttypes.h>
+#include "ResourceTypes.h"
+
+#define BUILD_CACHE_DIR		"pakcache"	//Compressed entries from previous runs, named by content key
+#define BUILD_CACHE_VERSION	5			//Bump whenever the compressed output for the same input would change
+
+//Where an entry ended up in a pak, so the next build can leave it in the same place
+typedef struct
+{
+	uint64_t id;		//Resource ID
+	uint64_t key;		//Content key the entry was built from
+	uint64_t offset;	//Offset of its CompressionHeader in the pak
+	uint64_t size;		//CompressionHeader plus payload
+} LayoutEntry;
+
+typedef struct
+{
+	uint64_t dataStart;	//Where entry data starts (end of the ResourcePtr table, including spare slots)
+	uint64_t dataEnd;
+	std::vector<LayoutEntry> entries;
+} PakLayout;
+
+namespace BuildCache
+{
+	//64-bit FNV-1a, chained through hash
+	uint64_t fnv1a(const unsigned char* data, unsigned int len, uint64_t hash = 0xcbf29ce484222325ULL);
+
+	//Hash of a file's contents together with everything about the build that affects its
+	// compressed bytes. Two files with the same key compress to the same entry.
+	uint64_t contentKey(const std::string& sFilename, const unsigned char* data, unsigned int len, bool bInPlace);
+
+	//Look up/store a compressed entry by content key. Loaded data is malloc()ed.
+	bool load(uint64_t key, CompressionHeader* header, unsigned char** data);
+	void store(uint64_t key, const CompressionHeader& header, const unsigned char* data);
+
+	//The layout of a pak from the last build lives next to it, as <pak>.layout
+	bool readLayout(const std::string& sPakFilename, PakLayout* layout);
+	void writeLayout(const std::string& sPakFilename, const PakLayout& layout);
+}
@@ -5,16 +5,39 @@
 #include <string>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <list>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <map>
+#include <algorithm>
+#include <set>
+#include <sstream>
 #include "Parse.h"
 #include "FileOperations.h"
+#include "BuildCache.h"
+#include "Atlas.h"
 using namespace std;
 
-#define PAD_32BIT 0x50444150
 #define STB_IMAGE_IMPLEMENTATION
 
 #include "stb_image.h"
 #include "ResourceTypes.h"
+#include "ResourceHash.h"
+#include "CompiledXML.h"
+#include "ResourceManifest.h"
+#include "easylogging++.h"
+
+INITIALIZE_EASYLOGGINGPP
+
+static uint32_t g_alignment = PAK_DEFAULT_ALIGNMENT;	//Payload alignment in the output pak
+static set<string> g_inPlaceTypes;	//Extensions that get stored uncompressed in their final layout, to use in place from a mapping
+static vector<string> g_traces;		//Recorded manifests to order entries by, in the order scenes get played
+static vector<string> g_atlasDirs;	//Directories whose small images get packed into atlases
+static map<string, vector<unsigned char> > g_generated;	//Data we made up rather than read (atlas pages, and the images packed into them), by filename
 
 //Helper struct for compression
 typedef struct
@@ -24,19 +47,28 @@ typedef struct
 	unsigned int size;
 	uint64_t id;
 	string filename;
+	bool bCached;	//Came straight out of the build cache
 } compressionHelper;
 
-uint64_t hashString(string sHashStr)
-{
-	const char* str = sHashStr.c_str();
-	uint64_t hash = 5381;
-	int c;
+#define FILE_PENDING	0
+#define FILE_DONE		1
+#define FILE_FAILED		2
 
-	while(c = *str++)
-		hash = ((hash << 5) + hash) + c;
-
-	return hash;
-}
+//Work shared between the compression threads and the thread writing the pak
+struct compressionQueue
+{
+	vector<string> files;
+	vector<uint64_t> keys;		//Content key of each file; 0 if it couldn't be read
+	vector<int> aliasOf;		//Earlier file with the same content key, whose entry this one shares; -1 if none
+	atomic<unsigned int> nextHash;
+	vector<compressionHelper> results;
+	vector<int> state;			//FILE_PENDING, FILE_DONE, or FILE_FAILED for each file
+	unsigned int nextFile;		//Next file for a worker to pick up
+	unsigned int nextWrite;		//Next file the writer is waiting on
+	unsigned int maxAhead;		//How far workers can get ahead of the writer
+	mutex lock;
+	condition_variable changed;
+};
 
 string remove_extension(const string& filename)
 {
@@ -79,6 +111,90 @@ unsigned char* extractImage(string filename, unsigned int* fileSize)
 	return finalBuf;
 }
 
+//Scenes don't have a fixed directory or root element; go by what's in them
+bool isScene(const tinyxml2::XMLElement* root)
+{
+	return root->Attribute("gravity") || root->Attribute("bounds")
+		|| root->FirstChildElement("layer") || root->FirstChildElement("object")
+		|| root->FirstChildElement("particles") || root->FirstChildElement("geom");
+}
+
+//Particle systems, objects, cursors and scenes get compiled to binary records, so the game doesn't
+// have to parse them. Returns NULL for any other XML, which gets stored as-is
+unsigned char* compileXML(const string& filename, unsigned int* fileSize)
+{
+	tinyxml2::XMLDocument doc;
+	if(doc.LoadFile(filename.c_str()) != tinyxml2::XML_NO_ERROR)
+		return NULL;
+	const tinyxml2::XMLElement* root = doc.RootElement();
+	if(!root)
+		return NULL;
+
+	vector<unsigned char> record;
+	string sRoot = root->Name();
+	if(sRoot == "particlesystem")
+	{
+		ParticleSystemDef def;
+		if(CompiledXML::fromXML(&doc, filename, &def))
+			CompiledXML::write(def, &record);
+	}
+	else if(sRoot == "cursor")
+	{
+		CursorDef def;
+		if(CompiledXML::fromXML(&doc, filename, &def))
+			CompiledXML::write(def, &record);
+	}
+	else if(filename.find("res/obj/") == 0)	//Objects can have any root element
+	{
+		ObjectDef def;
+		if(CompiledXML::fromXML(&doc, filename, &def))
+			CompiledXML::write(def, &record);
+	}
+	else if(isScene(root))
+	{
+		SceneDef def;
+		if(CompiledXML::fromXML(&doc, filename, &def))
+			CompiledXML::write(def, &record);
+	}
+
+	if(record.empty())
+		return NULL;
+
+	unsigned char* buf = (unsigned char*)malloc(record.size());
+	memcpy(buf, &record[0], record.size());
+	if(fileSize)
+		*fileSize = record.size();
+	return buf;
+}
+
+//Read a file, or what we generated in its place. malloc()ed, like FileOperations::readFile()
+unsigned char* readInput(const string& filename, unsigned int* fileSize)
+{
+	map<string, vector<unsigned char> >::iterator i = g_generated.find(filename);
+	if(i == g_generated.end())
+		return FileOperations::readFile(filename, fileSize);
+
+	unsigned char* buf = (unsigned char*)malloc(i->second.size());
+	memcpy(buf, &i->second[0], i->second.size());
+	if(fileSize)
+		*fileSize = i->second.size();
+	return buf;
+}
+
+//Is this file stored uncompressed, ready to be used straight out of a mapped pak?
+bool isInPlace(const string& filename)
+{
+	return g_inPlaceTypes.count(Parse::getExtension(filename)) > 0;
+}
+
+//Where an entry starting at or after offset has to go, so that its payload is aligned
+uint64_t alignEntry(uint64_t offset)
+{
+	uint64_t payload = offset + sizeof(CompressionHeader);
+	payload = (payload + g_alignment - 1) & ~((uint64_t)g_alignment - 1);
+	return payload - sizeof(CompressionHeader);
+}
+
 bool hasUpper(string s)
 {
 	for(unsigned int i = 0; i < s.length(); i++)
@@ -124,68 +240,417 @@ list<string> readFilenames(string filelistFile)
 	return lFilenames;
 }
 
+//Load and compress a single file, or pull it out of the build cache if it's been compressed before.
+// Safe to call from any number of threads, as long as each one has its own workMem
+bool compressFile(const string& filename, uint64_t key, uint8_t* workMem, compressionHelper* helper)
+{
+	helper->filename = filename;
+	helper->id = ResourceHash::hash(filename);
+	helper->bCached = BuildCache::load(key, &helper->header, &helper->data);
+	if(helper->bCached)
+	{
+		helper->size = helper->header.compressedSize;
+		return true;
+	}
+
+	unsigned int size = 0;
+	unsigned char* decompressed;
+
+	//Extract an image from this file if it is one
+	if(g_generated.count(filename))
+		decompressed = readInput(filename, &size);
+	else if(filename.find(".png") != string::npos)
+		decompressed = extractImage(filename, &size);
+	else
+	{
+		decompressed = NULL;
+		if(filename.find(".xml") != string::npos)
+			decompressed = compileXML(filename, &size);
+		if(!decompressed)
+			decompressed = FileOperations::readFile(filename, &size);
+	}
+
+	if(!size)
+		return false;
+
+	helper->filename = filename;
+	helper->header.flags = 0;
+	helper->header.decompressedSize = size;
+	uint8_t* compressed;
+	if(isInPlace(filename))
+	{
+		//Leave this one alone so it can be used without a copy
+		helper->header.compressionType = COMPRESSION_FLAGS_UNCOMPRESSED;
+		helper->header.compressedSize = size;
+		helper->header.flags = RESOURCE_FLAG_FINAL_LAYOUT;
+		compressed = NULL;
+	}
+	else if(size > WFLZ_CHUNK_SIZE)
+	{
+		//Large resources get split into chunks, so they can be decompressed in parallel
+		helper->header.compressionType = COMPRESSION_FLAGS_WFLZ_CHUNKED;
+		compressed = (uint8_t*)malloc(wfLZ_GetMaxChunkCompressedSize(size, WFLZ_CHUNK_SIZE));
+		helper->header.compressedSize = wfLZ_ChunkCompress(decompressed, size, WFLZ_CHUNK_SIZE, compressed, workMem, 0, 1);
+	}
+	else
+	{
+		helper->header.compressionType = COMPRESSION_FLAGS_WFLZ;
+		compressed = (uint8_t*)malloc(wfLZ_GetMaxCompressedSize(size));
+		helper->header.compressedSize = wfLZ_CompressFast(decompressed, size, compressed, workMem, 0);
+	}
+
+	//See if compression made the file larger
+	if(helper->header.flags & RESOURCE_FLAG_FINAL_LAYOUT)
+		helper->data = decompressed;
+	else if(helper->header.compressedSize >= helper->header.decompressedSize)
+	{
+		//It did; use the uncompressed data instead
+		helper->header.compressionType = COMPRESSION_FLAGS_UNCOMPRESSED;
+		helper->header.compressedSize = helper->header.decompressedSize;
+		helper->data = decompressed;
+		free(compressed);
+	}
+	else
+	{
+		//It didn't; use the compressed data
+		helper->data = compressed;
+		free(decompressed);
+	}
+
+	helper->size = helper->header.compressedSize;
+	BuildCache::store(key, helper->header, helper->data);
+	return true;
+}
+
+//Work out content keys for every file, so we know up front which entries haven't changed
+void hashWorker(compressionQueue* q)
+{
+	unsigned int cur;
+	while((cur = q->nextHash++) < q->files.size())
+	{
+		unsigned int size = 0;
+		unsigned char* data = readInput(q->files[cur], &size);
+		q->keys[cur] = (data && size) ? BuildCache::contentKey(q->files[cur], data, size, isInPlace(q->files[cur])) : 0;
+		free(data);
+	}
+}
+
+void compressionWorker(compressionQueue* q)
+{
+	uint8_t* workMem = (uint8_t*)malloc(wfLZ_GetWorkMemSize());
+
+	unique_lock<mutex> lock(q->lock);
+	while(true)
+	{
+		//Don't get too far ahead of the writer, or we end up holding the whole pak in memory
+		while(q->nextFile < q->files.size() && q->nextFile >= q->nextWrite + q->maxAhead)
+			q->changed.wait(lock);
+		if(q->nextFile >= q->files.size())
+			break;
+
+		unsigned int cur = q->nextFile++;
+		lock.unlock();
+		bool bOk = q->keys[cur] && (q->aliasOf[cur] >= 0 || compressFile(q->files[cur], q->keys[cur], workMem, &q->results[cur]));
+		lock.lock();
+
+		q->state[cur] = bOk ? FILE_DONE : FILE_FAILED;
+		q->changed.notify_all();
+	}
+	lock.unlock();
+
+	free(workMem);
+}
+
+//Point a resource ID at an entry
+void addEntry(uint64_t id, uint64_t key, uint64_t offset, uint64_t size, vector<ResourcePtr>* resPtrs, PakLayout* layout)
+{
+	ResourcePtr resPtr;
+	resPtr.id = id;
+	resPtr.offset = offset;
+	resPtrs->push_back(resPtr);
+
+	LayoutEntry entry;
+	entry.id = id;
+	entry.key = key;
+	entry.offset = offset;
+	entry.size = size;
+	layout->entries.push_back(entry);
+}
+
+//Find an entry already written to the pak with exactly the same bytes as this one. Returns its file index, or -1
+int findWritten(FILE* fOut, const multimap<uint64_t, unsigned int>& written, uint64_t entryHash, const compressionHelper& helper, const vector<uint64_t>& entryOffsets, const vector<uint64_t>& entrySizes)
+{
+	uint64_t entrySize = sizeof(CompressionHeader) + helper.size;
+	pair<multimap<uint64_t, unsigned int>::const_iterator, multimap<uint64_t, unsigned int>::const_iterator> range = written.equal_range(entryHash);
+	for(multimap<uint64_t, unsigned int>::const_iterator i = range.first; i != range.second; i++)
+	{
+		if(entrySizes[i->second] != entrySize)
+			continue;
+
+		//Hashes can collide; compare what's actually there
+		vector<unsigned char> existing(entrySize);
+		fseek(fOut, entryOffsets[i->second], SEEK_SET);
+		if(fread(&existing[0], 1, entrySize, fOut) != entrySize)
+			continue;
+		if(!memcmp(&existing[0], &helper.header, sizeof(CompressionHeader)) && !memcmp(&existing[sizeof(CompressionHeader)], helper.data, helper.size))
+			return i->second;
+	}
+	return -1;
+}
+
+//Lay entries out in the order the game reads them, so a scene's resources sit together and load
+// with sequential reads. Each manifest is one scene's worth of reads; the scene file and its
+// manifest come first, since they're read before anything else. Resources shared with an earlier
+// scene stay with the first scene that used them. Files no trace mentions go last, in list order.
+vector<string> orderByTraces(const vector<string>& files)
+{
+	set<string> inPak(files.begin(), files.end());
+	set<string> placed;
+	vector<string> ordered;
+
+	for(vector<string>::iterator i = g_traces.begin(); i != g_traces.end(); i++)
+	{
+		unsigned int size = 0;
+		unsigned char* data = FileOperations::readFile(*i, &size);
+		if(!data)
+		{
+			cout << "Unable to read trace " << *i << ". Skipping..." << endl;
+			continue;
+		}
+		vector<ManifestEntry> entries;
+		ResourceManifest::parse((const char*)data, size, &entries);
+		free(data);
+
+		vector<string> group;
+		string sManifestExt = ResourceManifest::filenameFor("");
+		if(i->size() > sManifestExt.size() && i->rfind(sManifestExt) == i->size() - sManifestExt.size())
+			group.push_back(i->substr(0, i->size() - sManifestExt.size()));	//The scene itself
+		group.push_back(*i);
+		for(vector<ManifestEntry>::iterator j = entries.begin(); j != entries.end(); j++)
+			group.push_back(j->path);
+
+		for(vector<string>::iterator j = group.begin(); j != group.end(); j++)
+		{
+			if(inPak.count(*j) && placed.insert(*j).second)
+				ordered.push_back(*j);
+		}
+	}
+
+	for(vector<string>::const_iterator i = files.begin(); i != files.end(); i++)
+	{
+		if(placed.insert(*i).second)
+			ordered.push_back(*i);
+	}
+	return ordered;
+}
+
 void compress(list<string> filesToPak, string pakFilename)
 {
 	pakFilename = remove_extension(pakFilename);
 	pakFilename += ".pak";
 	cout << "Packing pak file \"" << pakFilename << "\"..." << endl;
 
-	uint8_t* workMem = (uint8_t*)malloc(wfLZ_GetWorkMemSize());
+	//Open output file. Read back too, to check possible duplicate entries really are
+	FILE *fOut = fopen(pakFilename.c_str(), "w+b");
+	if(!fOut)
+	{
+		cout << "Unable to open " << pakFilename << " for writing." << endl;
+		return;
+	}
 
-	list<compressionHelper> compressedFiles;
+	compressionQueue q;
+	q.files.assign(filesToPak.begin(), filesToPak.end());
+	g_generated.clear();
+	if(g_atlasDirs.size())
+	{
+		vector<string> pages;
+		Atlas::pack(q.files, g_atlasDirs, remove_extension(pakFilename), &g_generated, &pages);
+		q.files.insert(q.files.end(), pages.begin(), pages.end());
+	}
+	if(g_traces.size())
+		q.files = orderByTraces(q.files);
+	q.keys.assign(q.files.size(), 0);
+	q.nextHash = 0;
+	q.results.resize(q.files.size());
+	q.state.assign(q.files.size(), FILE_PENDING);
+	q.nextFile = q.nextWrite = 0;
+
+	unsigned int numThreads = thread::hardware_concurrency();
+	if(!numThreads)
+		numThreads = 1;
+	q.maxAhead = numThreads * 4;
+
+	vector<thread> workers;
+	for(unsigned int i = 0; i < numThreads; i++)
+		workers.push_back(thread(hashWorker, &q));
+	for(unsigned int i = 0; i < workers.size(); i++)
+		workers[i].join();
+	workers.clear();
+
+	//Files with the same content key compress to the same entry, so only compress the first one
+	q.aliasOf.assign(q.files.size(), -1);
+	map<uint64_t, unsigned int> firstWithKey;
+	for(unsigned int i = 0; i < q.files.size(); i++)
+	{
+		if(!q.keys[i])
+			continue;
+		pair<map<uint64_t, unsigned int>::iterator, bool> first = firstWithKey.insert(make_pair(q.keys[i], i));
+		if(!first.second)
+			q.aliasOf[i] = first.first->second;
+	}
+
+	//Leave spare ResourcePtr slots, so adding a few files doesn't shift every entry after the table
+	uint64_t numSlots = q.files.size() + q.files.size() / 4;
+	numSlots = (numSlots + 63) & ~63ULL;
+	uint64_t dataStart = (uint64_t)sizeof(PakFileHeader) + numSlots * (uint64_t)sizeof(ResourcePtr);	//Make sure we're doing 64-bit math on the current offset
+	uint64_t dataEnd = dataStart;
+
+	//Entries whose content hasn't changed since the last build stay exactly where they were. Not when
+	// ordering by traces, though; the whole point there is to move them
+	PakLayout prevLayout;
+	vector<uint64_t> keptOffsets(q.files.size(), 0);
+	vector<uint64_t> keptSizes(q.files.size(), 0);
+	vector<pair<uint64_t, uint64_t> > keptRanges;
+	if(g_traces.empty() && BuildCache::readLayout(pakFilename, &prevLayout) && prevLayout.dataStart >= (uint64_t)sizeof(PakFileHeader) + q.files.size() * (uint64_t)sizeof(ResourcePtr))
+	{
+		dataStart = prevLayout.dataStart;
+		dataEnd = max(prevLayout.dataEnd, dataStart);
 
+		map<uint64_t, LayoutEntry*> prevEntries;
+		for(vector<LayoutEntry>::iterator i = prevLayout.entries.begin(); i != prevLayout.entries.end(); i++)
+			prevEntries[i->id] = &(*i);
 
-	for(list<string>::iterator i = filesToPak.begin(); i != filesToPak.end(); i++)
+		for(unsigned int i = 0; i < q.files.size(); i++)
+		{
+			map<uint64_t, LayoutEntry*>::iterator prev = prevEntries.find(ResourceHash::hash(q.files[i]));
+			if(prev == prevEntries.end() || !q.keys[i] || prev->second->key != q.keys[i])
+				continue;
+			if(alignEntry(prev->second->offset) != prev->second->offset)
+				continue;	//Built with a different alignment
+
+			keptOffsets[i] = prev->second->offset;
+			keptSizes[i] = prev->second->size;
+			keptRanges.push_back(make_pair(prev->second->offset, prev->second->size));
+			prevEntries.erase(prev);	//Only one file gets to keep a given spot
+		}
+	}
+
+	//Everything between kept entries is free for new and changed ones
+	sort(keptRanges.begin(), keptRanges.end());
+	list<pair<uint64_t, uint64_t> > holes;	//Offset, size
+	uint64_t holeStart = dataStart;
+	for(vector<pair<uint64_t, uint64_t> >::iterator i = keptRanges.begin(); i != keptRanges.end(); i++)
 	{
-		cout << "Compressing \"" << *i << "\"..." << endl;
-		unsigned int size = 0;
-		unsigned char* decompressed;
+		if(i->first > holeStart)
+			holes.push_back(make_pair(holeStart, i->first - holeStart));
+		holeStart = max(holeStart, i->first + i->second);
+	}
+	if(dataEnd > holeStart)
+		holes.push_back(make_pair(holeStart, dataEnd - holeStart));
+	dataEnd = max(dataEnd, holeStart);
+
+	for(unsigned int i = 0; i < numThreads; i++)
+		workers.push_back(thread(compressionWorker, &q));
+
+	//Write resource data in list (or trace) order as it finishes, so the output doesn't depend on thread timing
+	PakLayout layout;
+	layout.dataStart = dataStart;
+	vector<ResourcePtr> resPtrs;
+	unsigned int numKept = 0;
+	unsigned int numCached = 0;
+	unsigned int numShared = 0;
+	vector<uint64_t> entryOffsets(q.files.size(), 0);	//Where each file's entry went
+	vector<uint64_t> entrySizes(q.files.size(), 0);		//0 if it wasn't written
+	multimap<uint64_t, unsigned int> written;			//Files whose entries we wrote, by hash of the entry
+	for(unsigned int i = 0; i < q.files.size(); i++)
+	{
+		int state;
+		compressionHelper helper;
+		{
+			unique_lock<mutex> lock(q.lock);
+			while(q.state[i] == FILE_PENDING)
+				q.changed.wait(lock);
+			state = q.state[i];
+			helper = q.results[i];
+			q.results[i] = compressionHelper();
+			q.nextWrite = i + 1;
+			q.changed.notify_all();
+		}
 
-		//Extract an image from this file if it is one
-		if(i->find(".png") != string::npos)
-			decompressed = extractImage(*i, &size);
-		else
-			decompressed = FileOperations::readFile(*i, &size);
+		int alias = q.aliasOf[i];
+		if(state == FILE_FAILED || (alias >= 0 && !entrySizes[alias]))
+		{
+			cout << "Unable to load file " << q.files[i] << endl;
+			continue;
+		}
 
-		if(!size)
+		//Same entry as an earlier file; point at that one
+		if(alias >= 0)
 		{
-			cout << "Unable to load file " << *i << endl;
+			entryOffsets[i] = entryOffsets[alias];
+			entrySizes[i] = entrySizes[alias];
+			addEntry(ResourceHash::hash(q.files[i]), q.keys[i], entryOffsets[i], entrySizes[i], &resPtrs, &layout);
+			numShared++;
 			continue;
 		}
 
-		compressionHelper helper;
-		helper.filename = *i;
-		helper.header.pad = PAD_32BIT;
-		helper.header.compressionType = COMPRESSION_FLAGS_WFLZ;
-		helper.header.decompressedSize = size;
-		uint8_t* compressed = (uint8_t*)malloc(wfLZ_GetMaxCompressedSize(helper.header.decompressedSize));
-		helper.header.compressedSize = wfLZ_CompressFast(decompressed, size, compressed, workMem, 0);
-
-		//See if compression made the file larger
-		if(helper.header.compressedSize >= helper.header.decompressedSize)
-		{
-			//It did; use the uncompressed data instead
-			helper.header.compressionType = COMPRESSION_FLAGS_UNCOMPRESSED;
-			helper.header.compressedSize = helper.header.decompressedSize;
-			helper.data = decompressed;
-			free(compressed);
+		uint64_t entrySize = sizeof(CompressionHeader) + helper.size;
+		uint64_t entryHash = BuildCache::fnv1a(helper.data, helper.size, BuildCache::fnv1a((const unsigned char*)&helper.header, sizeof(CompressionHeader)));
+		uint64_t offset;
+		int same = -1;
+		if(keptSizes[i] == entrySize)
+		{
+			offset = keptOffsets[i];
+			numKept++;
+		}
+		else if((same = findWritten(fOut, written, entryHash, helper, entryOffsets, entrySizes)) >= 0)
+		{
+			//Different file, same bytes once compiled and compressed
+			offset = entryOffsets[same];
+			numShared++;
 		}
 		else
 		{
-			//It didn't; use the compressed data
-			helper.data = compressed;
-			free(decompressed);
+			//First hole it fits in, or the end of the file
+			offset = alignEntry(dataEnd);
+			for(list<pair<uint64_t, uint64_t> >::iterator h = holes.begin(); h != holes.end(); h++)
+			{
+				uint64_t start = alignEntry(h->first);
+				uint64_t end = h->first + h->second;
+				if(start < end && end - start >= entrySize)
+				{
+					offset = start;
+					h->first = start + entrySize;
+					h->second = end - h->first;
+					break;
+				}
+			}
+			dataEnd = max(dataEnd, offset + entrySize);
 		}
+		if(helper.bCached)
+			numCached++;
+		else
+			cout << "Compressed \"" << helper.filename << "\"" << endl;
 
-		//Add this compression helper to our list
-		helper.size = helper.header.compressedSize;
-		helper.id = hashString(*i);
+		entryOffsets[i] = offset;
+		entrySizes[i] = entrySize;
+		addEntry(helper.id, q.keys[i], offset, entrySize, &resPtrs, &layout);
+
+		if(same < 0)
+		{
+			fseek(fOut, offset, SEEK_SET);
+			fwrite(&helper.header, 1, sizeof(CompressionHeader), fOut);
+			fwrite(helper.data, 1, helper.size, fOut);
+			written.insert(make_pair(entryHash, i));
+		}
 
-		compressedFiles.push_back(helper);
+		free(helper.data);	//Free image data while we're at it
 	}
 
-	//Open output file
-	FILE *fOut = fopen(pakFilename.c_str(), "wb");
+	for(unsigned int i = 0; i < workers.size(); i++)
+		workers[i].join();
+
+	cout << numCached << " of " << resPtrs.size() << " entries reused from the build cache, " << numKept << " kept in place, " << numShared << " sharing another's data" << endl;
 
 	//Create header
 	PakFileHeader fileHeader;
@@ -193,51 +658,80 @@ void compress(list<string> filesToPak, string pakFilename)
 	fileHeader.sig[1] = 'A';
 	fileHeader.sig[2] = 'K';
 	fileHeader.sig[3] = 'C';
-	fileHeader.version = VERSION_1_0;
-	fileHeader.numResources = compressedFiles.size();
-	fileHeader.pad = PAD_32BIT;
+	fileHeader.version = VERSION_2;
+	fileHeader.numResources = resPtrs.size();
+	fileHeader.alignment = g_alignment;
 
-	//Write header
+	//Write header and resource pointers
+	fseek(fOut, 0, SEEK_SET);
 	fwrite(&fileHeader, 1, sizeof(PakFileHeader), fOut);
-
-	//Make sure we're doing 64-bit math on the current offset
-	uint64_t curOffset = (uint64_t)sizeof(PakFileHeader) + (uint64_t)compressedFiles.size() * (uint64_t)sizeof(ResourcePtr);	//Start after both these
-
-	//Write resource pointers
-	for(list<compressionHelper>::iterator i = compressedFiles.begin(); i != compressedFiles.end(); i++)
-	{
-		ResourcePtr resPtr;
-		resPtr.id = i->id;
-		resPtr.offset = curOffset;
-
-		fwrite(&resPtr, 1, sizeof(ResourcePtr), fOut);
-		curOffset += sizeof(CompressionHeader) + i->header.compressedSize;
-	}
-
-	//Write resource data
-	for(list<compressionHelper>::iterator i = compressedFiles.begin(); i != compressedFiles.end(); i++)
-	{
-		fwrite(&i->header, 1, sizeof(CompressionHeader), fOut);
-		fwrite(i->data, 1, i->size, fOut);
-
-		free(i->data);	//Free image data while we're at it
-	}
-
-	//Free our WFLZ working memory
-	free(workMem);
+	if(resPtrs.size())
+		fwrite(&resPtrs[0], sizeof(ResourcePtr), resPtrs.size(), fOut);
 
 	//Close output file
 	fclose(fOut);
+
+	layout.dataEnd = dataEnd;
+	BuildCache::writeLayout(pakFilename, layout);
 }
 
 int main(int argc, char** argv)
 {
+	//Warnings from compiling XML go to the console only
+	el::Configurations conf;
+	conf.setToDefault();
+	conf.setGlobally(el::ConfigurationType::ToFile, "false");
+	el::Loggers::reconfigureAllLoggers(conf);
+
 	list<string> sFilelistNames;
 	//Parse commandline
 	for(int i = 1; i < argc; i++)
 	{
 		string s = argv[i];
-		sFilelistNames.push_back(s);
+		if(s.find("-align=") == 0)
+		{
+			g_alignment = atoi(s.substr(7).c_str());
+			if(g_alignment < PAK_DEFAULT_ALIGNMENT || g_alignment > PAK_MAX_ALIGNMENT || (g_alignment & (g_alignment - 1)))
+			{
+				cout << "Alignment must be a power of two from " << PAK_DEFAULT_ALIGNMENT << " to " << PAK_MAX_ALIGNMENT << endl;
+				return 1;
+			}
+		}
+		else if(s.find("-inplace=") == 0)
+		{
+			//Comma-separated list of extensions, e.g. -inplace=png,t3d
+			istringstream iss(s.substr(9));
+			string sExt;
+			while(getline(iss, sExt, ','))
+			{
+				if(sExt.size())
+					g_inPlaceTypes.insert(sExt);
+			}
+		}
+		else if(s.find("-order=") == 0)
+		{
+			//Comma-separated list of manifests recorded with --record-manifests, e.g. -order=res/map/start.xml.manifest,res/map/cave.xml.manifest
+			istringstream iss(s.substr(7));
+			string sTrace;
+			while(getline(iss, sTrace, ','))
+			{
+				if(sTrace.size())
+					g_traces.push_back(sTrace);
+			}
+		}
+		else if(s.find("-atlas=") == 0)
+		{
+			//Comma-separated list of directories whose small images can share textures, e.g. -atlas=res/particles/,res/hud/
+			istringstream iss(s.substr(7));
+			string sDir;
+			while(getline(iss, sDir, ','))
+			{
+				if(sDir.size())
+					g_atlasDirs.push_back(sDir);
+			}
+		}
+		else
+			sFilelistNames.push_back(s);
 	}
 	//Compress files
 	for(list<string>::iterator i = sFilelistNames.begin(); i != sFilelistNames.end(); i++)
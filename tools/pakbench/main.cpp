@@ -0,0 +1,199 @@
+//Micro-benchmark for pak index building and resource ID lookups.
+// Writes a synthetic pak with lots of tiny resources to the given (empty) directory, then times
+// opening it and looking up IDs, both the old way (one fread per ResourcePtr into a std::map)
+// and through PakLoader/PakIndex.
+//
+// Usage: pakbench <empty output dir> [numResources] [numLookups]
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <chrono>
+#include "ResourceTypes.h"
+#include "ResourceHash.h"
+#include "PakIndex.h"
+#include "PakLoader.h"
+#include "easylogging++.h"
+using namespace std;
+
+INITIALIZE_EASYLOGGINGPP
+
+#define PAD_32BIT 0x50444150
+#define BENCH_PAK_NAME "pakbench.pak"
+#define RESOURCE_SIZE 4
+
+double secondsSince(chrono::high_resolution_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+}
+
+string resourceName(uint32_t i)
+{
+	char buf[64];
+	sprintf(buf, "res/bench/resource_%u.bin", i);
+	return buf;
+}
+
+bool writePak(string sFilename, uint32_t numResources)
+{
+	FILE* fp = fopen(sFilename.c_str(), "wb");
+	if(!fp)
+		return false;
+
+	PakFileHeader header;
+	header.sig[0] = 'P';
+	header.sig[1] = 'A';
+	header.sig[2] = 'K';
+	header.sig[3] = 'C';
+	header.version = VERSION_1_0;
+	header.numResources = numResources;
+	header.alignment = PAD_32BIT;	//Padding in VERSION_1_0 paks
+	fwrite(&header, 1, sizeof(PakFileHeader), fp);
+
+	uint64_t offset = sizeof(PakFileHeader) + (uint64_t)numResources * sizeof(ResourcePtr);
+	for(uint32_t i = 0; i < numResources; i++)
+	{
+		ResourcePtr resPtr;
+		resPtr.id = ResourceHash::hash(resourceName(i));
+		resPtr.offset = offset;
+		fwrite(&resPtr, 1, sizeof(ResourcePtr), fp);
+		offset += sizeof(CompressionHeader) + RESOURCE_SIZE;
+	}
+
+	for(uint32_t i = 0; i < numResources; i++)
+	{
+		CompressionHeader compHeader;
+		compHeader.compressionType = COMPRESSION_FLAGS_UNCOMPRESSED;
+		compHeader.compressedSize = RESOURCE_SIZE;
+		compHeader.decompressedSize = RESOURCE_SIZE;
+		compHeader.flags = PAD_32BIT;
+		fwrite(&compHeader, 1, sizeof(CompressionHeader), fp);
+		fwrite(&i, 1, RESOURCE_SIZE, fp);
+	}
+
+	fclose(fp);
+	return true;
+}
+
+//What PakLoader used to do: one fread per ResourcePtr, one map node per resource
+bool legacyOpen(string sFilename, map<uint64_t, ResourcePtr>* index)
+{
+	FILE* fp = fopen(sFilename.c_str(), "rb");
+	if(!fp)
+		return false;
+
+	PakFileHeader header;
+	if(fread(&header, 1, sizeof(PakFileHeader), fp) != sizeof(PakFileHeader))
+	{
+		fclose(fp);
+		return false;
+	}
+
+	for(uint32_t i = 0; i < header.numResources; i++)
+	{
+		ResourcePtr resPtr;
+		if(fread(&resPtr, 1, sizeof(ResourcePtr), fp) != sizeof(ResourcePtr))
+			break;
+		(*index)[resPtr.id] = resPtr;
+	}
+
+	fclose(fp);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 2)
+	{
+		cout << "Usage: pakbench <empty output dir> [numResources] [numLookups]" << endl;
+		return 1;
+	}
+
+	//Keep PakLoader's trace logging out of the timings
+	el::Configurations conf;
+	conf.setToDefault();
+	conf.setGlobally(el::ConfigurationType::Enabled, "false");
+	el::Loggers::reconfigureAllLoggers(conf);
+
+	string sDir = argv[1];
+	uint32_t numResources = (argc > 2) ? atoi(argv[2]) : 100000;
+	uint32_t numLookups = (argc > 3) ? atoi(argv[3]) : 10000000;
+	string sPakFile = sDir + "/" + BENCH_PAK_NAME;
+
+	if(!writePak(sPakFile, numResources))
+	{
+		cout << "Unable to write " << sPakFile << endl;
+		return 1;
+	}
+	cout << "Wrote " << numResources << " resources to " << sPakFile << endl;
+
+	//Lookup keys: every resource, in a scrambled order
+	vector<uint64_t> keys(numResources);
+	for(uint32_t i = 0; i < numResources; i++)
+		keys[i] = ResourceHash::hash(resourceName((uint32_t)(((uint64_t)i * 2654435761U) % numResources)));
+
+	//Opening
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	map<uint64_t, ResourcePtr> legacyIndex;
+	legacyOpen(sPakFile, &legacyIndex);
+	double legacyOpenTime = secondsSince(start);
+
+	start = chrono::high_resolution_clock::now();
+	PakLoader* streamLoader = new PakLoader(sDir, false);
+	double streamOpenTime = secondsSince(start);
+
+	start = chrono::high_resolution_clock::now();
+	PakLoader* mappedLoader = new PakLoader(sDir, true);
+	double mappedOpenTime = secondsSince(start);
+
+	PakIndex index;
+	index.reserve(numResources);
+	for(map<uint64_t, ResourcePtr>::iterator i = legacyIndex.begin(); i != legacyIndex.end(); i++)
+		index.insert(i->first, i->second.offset, 0);
+
+	cout << "Open (std::map, fread per entry): " << legacyOpenTime * 1000.0 << " ms" << endl;
+	cout << "Open (PakLoader, file reads):     " << streamOpenTime * 1000.0 << " ms" << endl;
+	cout << "Open (PakLoader, mapped):         " << mappedOpenTime * 1000.0 << " ms" << endl;
+
+	//Lookups
+	uint64_t checksum = 0;
+	start = chrono::high_resolution_clock::now();
+	for(uint32_t i = 0; i < numLookups; i++)
+	{
+		map<uint64_t, ResourcePtr>::iterator it = legacyIndex.find(keys[i % numResources]);
+		if(it != legacyIndex.end())
+			checksum += it->second.offset;
+	}
+	double legacyLookupTime = secondsSince(start);
+
+	start = chrono::high_resolution_clock::now();
+	for(uint32_t i = 0; i < numLookups; i++)
+	{
+		const PakIndex::Entry* e = index.find(keys[i % numResources]);
+		if(e)
+			checksum -= e->offset;
+	}
+	double indexLookupTime = secondsSince(start);
+
+	cout << "Lookup (std::map): " << legacyLookupTime * 1e9 / numLookups << " ns/lookup" << endl;
+	cout << "Lookup (PakIndex): " << indexLookupTime * 1e9 / numLookups << " ns/lookup" << endl;
+
+	//Sanity check: both indices agree and the loader finds everything
+	bool bOk = (checksum == 0);
+	for(uint32_t i = 0; i < numResources && bOk; i += (numResources / 64 + 1))
+	{
+		unsigned int len = 0;
+		unsigned char* data = streamLoader->loadResource(ResourceHash::hash(resourceName(i)), &len);
+		bOk = data && len == RESOURCE_SIZE && !memcmp(data, &i, RESOURCE_SIZE);
+		delete[] data;
+	}
+	cout << (bOk ? "Lookups verified" : "Lookup MISMATCH") << endl;
+
+	delete streamLoader;
+	delete mappedLoader;
+	remove(sPakFile.c_str());
+	return bOk ? 0 : 1;
+}